@@ -0,0 +1,28 @@
+#!/bin/sh
+# Compares two results of run_benchmarks.sh, and fails if a benchmark became
+# slower by more than a tolerance, in percent (5 by default). Times, in ms,
+# should decrease, throughputs, per second, should increase.
+#
+# usage: compare_results.sh BASELINE CURRENT [TOLERANCE]
+
+if [ $# -lt 2 ]
+then
+	echo "usage: $0 BASELINE CURRENT [TOLERANCE]" >&2
+	exit 1
+fi
+
+awk -F '\t' -v tolerance="${3-5}" '
+	NR == FNR { baseline[$1] = $2; next }
+	!( $1 in baseline ) || baseline[$1] == 0 { next }
+	{
+		change = ( $2 - baseline[$1] ) / baseline[$1] * 100
+		if( $3 == "ms" )
+			change = -change
+
+		verdict = ""
+		if( change < -tolerance ) { verdict = "REGRESSION"; failed = 1 }
+
+		printf "%-45s %12g %12g %8.1f%% %s\n", $1, baseline[$1], $2, change, verdict
+	}
+	END { exit failed }
+' "$1" "$2"
@@ -0,0 +1,307 @@
+// Generates a synthetic Tatoeba export, to measure tatoparser on a corpus of
+// a chosen size without downloading one. The same seed and the same number of
+// sentences always give the same files.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Draws random numbers from the raw output of a mt19937_64, whose
+ *        sequence is the same with every standard library, unlike those of
+ *        the std:: distributions */
+struct randomSource
+{
+    explicit randomSource( uint64_t _seed ): m_engine( _seed ) { }
+
+    /**@brief Returns a number between 0 and _bound, excluded */
+    uint64_t below( uint64_t _bound ) { return m_engine() % _bound; }
+
+    /**@brief Returns a number between 0 and 1, excluded */
+    double unit() { return static_cast<double>( m_engine() >> 11 ) / static_cast<double>( 1ull << 53 ); }
+
+    /**@brief Returns true with a given probability */
+    bool chance( double _probability ) { return unit() < _probability; }
+
+private:
+    std::mt19937_64 m_engine;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Draws indexes with given weights, like the language of a sentence */
+struct weightedChoice
+{
+    explicit weightedChoice( const std::vector<double> & _weights )
+        : m_cumulated()
+    {
+        double total = 0;
+        for( double weight : _weights )
+            m_cumulated.push_back( total += weight );
+    }
+
+    /**@brief Builds a Zipf distribution: the n-th item is n times less likely than the first */
+    static weightedChoice zipf( size_t _nbItems, double _exponent = 1.0 )
+    {
+        std::vector<double> weights;
+        for( size_t rank = 1; rank <= _nbItems; ++rank )
+            weights.push_back( 1.0 / std::pow( static_cast<double>( rank ), _exponent ) );
+
+        return weightedChoice( weights );
+    }
+
+    size_t operator()( randomSource & _random ) const
+    {
+        const double drawn = _random.unit() * m_cumulated.back();
+        return static_cast<size_t>( std::upper_bound( m_cumulated.begin(), m_cumulated.end(), drawn ) - m_cumulated.begin() );
+    }
+
+private:
+    std::vector<double> m_cumulated;
+};
+
+// -------------------------------------------------------------------------- //
+
+// the most frequent languages of Tatoeba, with about their share of the sentences
+static const char * const LANGUAGES[] =
+{
+    "eng", "rus", "ita", "tur", "epo", "deu", "fra", "por", "spa", "ber",
+    "hun", "jpn", "heb", "ukr", "pol", "nld", "fin", "cmn", "mkd", "lit",
+    "mar", "ces", "dan", "tlh", "swe", "ara", "lat", "ell", "srp", "kab"
+};
+
+static const double LANGUAGE_SHARES[] =
+{
+    15.0, 9.0, 8.0, 7.5, 7.0, 6.0, 5.0, 4.0, 3.8, 3.0,
+     2.5, 2.2, 2.0, 1.8, 1.5, 1.4, 1.2, 1.2, 1.0, 0.9,
+     0.9, 0.8, 0.6, 0.3, 0.5, 0.5, 0.5, 0.5, 0.4, 0.4
+};
+
+// the languages written without spaces, whose words are made of CJK characters
+static bool isWrittenInIdeograms( const std::string & _lang )
+{
+    return _lang == "cmn" || _lang == "jpn";
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Makes up the words of the corpus, the most frequent first */
+static std::vector<std::string> makeVocabulary( randomSource & _random, size_t _size, bool _ideograms )
+{
+    static const char LETTERS[] = "etaoinshrdlcumwfgypbvkjxqz";
+    std::vector<std::string> words;
+
+    for( size_t i = 0; i < _size; ++i )
+    {
+        // the frequent words are short
+        const size_t length = 1 + std::min<size_t>( 11, i / 200 ) / 2 + _random.below( 4 );
+        std::string word;
+
+        for( size_t j = 0; j < length; ++j )
+        {
+            if( _ideograms )
+            {
+                // a character of the CJK Unified Ideographs block, in UTF-8
+                const uint32_t codePoint = 0x4E00 + static_cast<uint32_t>( _random.below( 0x5000 ) );
+                word.push_back( static_cast<char>( 0xE0 | ( codePoint >> 12 ) ) );
+                word.push_back( static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) ) );
+                word.push_back( static_cast<char>( 0x80 | ( codePoint & 0x3F ) ) );
+            }
+            else
+                word.push_back( LETTERS[ _random.below( sizeof( LETTERS ) - 1 ) ] );
+        }
+
+        words.push_back( word );
+    }
+
+    return words;
+}
+
+// -------------------------------------------------------------------------- //
+
+static std::string makeDate( randomSource & _random )
+{
+    char date[32];
+    snprintf( date, sizeof( date ), "%04u-%02u-%02u %02u:%02u:%02u",
+              2007 + static_cast<unsigned>( _random.below( 8 ) ),
+              1 + static_cast<unsigned>( _random.below( 12 ) ),
+              1 + static_cast<unsigned>( _random.below( 28 ) ),
+              static_cast<unsigned>( _random.below( 24 ) ),
+              static_cast<unsigned>( _random.below( 60 ) ),
+              static_cast<unsigned>( _random.below( 60 ) ) );
+    return date;
+}
+
+// -------------------------------------------------------------------------- //
+
+static void usage( const char * _program )
+{
+    std::cerr << "Usage: " << _program << " OUTPUT_DIRECTORY [NB_SENTENCES [SEED]]\n"
+              << "Writes sentences.csv, sentences_detailed.csv, links.csv, tags.csv and lists.csv\n"
+              << "with NB_SENTENCES sentences (1000000 by default).\n";
+}
+
+// -------------------------------------------------------------------------- //
+
+int main( int argc, char * argv[] )
+{
+    if( argc < 2 || argc > 4 )
+    {
+        usage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    const std::string directory = argv[1];
+    const uint32_t nbSentences = argc > 2 ? static_cast<uint32_t>( std::strtoul( argv[2], nullptr, 10 ) ) : 1000000;
+    const uint64_t seed = argc > 3 ? std::strtoull( argv[3], nullptr, 10 ) : 42;
+
+    if( nbSentences == 0 )
+    {
+        usage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    randomSource random( seed );
+
+    const size_t nbLanguages = sizeof( LANGUAGES ) / sizeof( LANGUAGES[0] );
+    const weightedChoice chooseLanguage( std::vector<double>( LANGUAGE_SHARES, LANGUAGE_SHARES + nbLanguages ) );
+
+    const std::vector<std::string> alphabeticWords = makeVocabulary( random, 20000, false );
+    const std::vector<std::string> ideographicWords = makeVocabulary( random, 20000, true );
+    const weightedChoice chooseWord = weightedChoice::zipf( 20000 );
+
+    // a few users write most of the sentences
+    const size_t nbUsers = std::max<size_t>( 100, nbSentences / 100 );
+    const weightedChoice chooseUser = weightedChoice::zipf( nbUsers, 1.1 );
+
+    std::ofstream sentences( ( directory + "/sentences.csv" ).c_str() );
+    std::ofstream detailed( ( directory + "/sentences_detailed.csv" ).c_str() );
+
+    if( !sentences || !detailed )
+    {
+        std::cerr << "Cannot write into " << directory << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::string text;
+
+    for( uint32_t id = 1; id <= nbSentences; ++id )
+    {
+        const size_t language = chooseLanguage( random );
+        const bool ideograms = isWrittenInIdeograms( LANGUAGES[language] );
+        const std::vector<std::string> & words = ideograms ? ideographicWords : alphabeticWords;
+
+        // most sentences have 2 to 10 words, a few are much longer
+        const size_t nbWords = 2 + random.below( 9 ) + ( random.chance( 0.02 ) ? random.below( 40 ) : 0 );
+
+        text.clear();
+        for( size_t i = 0; i < nbWords; ++i )
+        {
+            if( i != 0 && !ideograms )
+                text.push_back( ' ' );
+            text += words[ chooseWord( random ) ];
+        }
+
+        text += ideograms ? "\xE3\x80\x82" : ".";
+        if( !ideograms )
+            text[0] = static_cast<char>( text[0] - 'a' + 'A' );
+
+        sentences << id << '\t' << LANGUAGES[language] << '\t' << text << '\n';
+
+        // sentences_detailed.csv: the author, the creation date if it is known,
+        // and the date of the last modification
+        detailed << id << '\t' << LANGUAGES[language] << '\t' << text << '\t'
+                 << "user" << chooseUser( random ) << '\t'
+                 << ( random.chance( 0.3 ) ? std::string( "\\N" ) : makeDate( random ) ) << '\t'
+                 << makeDate( random ) << '\n';
+    }
+
+    // links: the sentences are grouped into sets of translations of each
+    // other. Most sets have one to three sentences, a few have dozens. Each
+    // sentence is linked to the first of its set, and to some of the others.
+    // The links are written in both directions, sorted like in the exports.
+    std::vector<uint32_t> shuffled( nbSentences );
+    for( uint32_t i = 0; i < nbSentences; ++i )
+        shuffled[i] = i + 1;
+
+    for( uint32_t i = nbSentences - 1; i > 0; --i )
+        std::swap( shuffled[i], shuffled[ random.below( i + 1 ) ] );
+
+    std::vector< std::pair<uint32_t, uint32_t> > links;
+    for( size_t first = 0; first < shuffled.size(); )
+    {
+        size_t setSize = 1 + ( random.chance( 0.01 ) ? random.below( 40 ) : 0 );
+        while( random.chance( 0.55 ) )
+            ++setSize;
+
+        setSize = std::min( setSize, shuffled.size() - first );
+
+        for( size_t i = first + 1; i < first + setSize; ++i )
+        {
+            for( size_t j = first; j < i; ++j )
+            {
+                if( j == first || random.chance( 0.3 ) )
+                {
+                    links.push_back( std::make_pair( shuffled[i], shuffled[j] ) );
+                    links.push_back( std::make_pair( shuffled[j], shuffled[i] ) );
+                }
+            }
+        }
+
+        first += setSize;
+    }
+
+    std::sort( links.begin(), links.end() );
+    links.erase( std::unique( links.begin(), links.end() ), links.end() );
+
+    std::ofstream linksFile( ( directory + "/links.csv" ).c_str() );
+    for( const std::pair<uint32_t, uint32_t> & link : links )
+        linksFile << link.first << '\t' << link.second << '\n';
+
+    // tags: a few sentences have some, "OK" and "has audio" being the most frequent
+    static const char * const FREQUENT_TAGS[] = { "OK", "has audio", "@needs native check", "idiom", "proverb" };
+    const weightedChoice chooseTag = weightedChoice::zipf( 500 );
+
+    std::ofstream tagsFile( ( directory + "/tags.csv" ).c_str() );
+    for( uint32_t id = 1; id <= nbSentences; ++id )
+    {
+        while( random.chance( 0.06 ) )
+        {
+            const size_t tag = chooseTag( random );
+            tagsFile << id << '\t';
+
+            if( tag < sizeof( FREQUENT_TAGS ) / sizeof( FREQUENT_TAGS[0] ) )
+                tagsFile << FREQUENT_TAGS[tag] << '\n';
+            else
+                tagsFile << "tag" << tag << '\n';
+        }
+    }
+
+    // lists: a few sentences belong to one
+    const weightedChoice chooseList = weightedChoice::zipf( 200 );
+
+    std::ofstream listsFile( ( directory + "/lists.csv" ).c_str() );
+    for( uint32_t id = 1; id <= nbSentences; ++id )
+    {
+        if( random.chance( 0.03 ) )
+            listsFile << id << '\t' << "list" << chooseList( random ) << '\n';
+    }
+
+    if( !sentences || !detailed || !linksFile || !tagsFile || !listsFile )
+    {
+        std::cerr << "Cannot write into " << directory << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::cerr << "Wrote " << nbSentences << " sentences, " << links.size() << " links into " << directory << '\n';
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+// Measures the parsers and the lookups of libtatoparser on a corpus, like one
+// written by generate_corpus. Each result is written on a line, as
+// "name<TAB>value<TAB>unit", so that it can be compared with compare_results.sh.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tatoparser/interface_lib.h>
+#include <tatoparser/dataset.h>
+#include <tatoparser/linkset.h>
+#include <tatoparser/tagset.h>
+#include <tatoparser/listset.h>
+#include <tatoparser/statistics.h>
+
+USING_NAMESPACE
+
+static const char * const FILES[] = { "sentences.csv", "sentences_detailed.csv", "links.csv", "tags.csv", "lists.csv" };
+
+// how many times a lookup is made per repetition
+static const size_t NB_LOOKUPS = 4000000;
+
+// -------------------------------------------------------------------------- //
+
+static void writeResult( const std::string & _name, double _value, const char * _unit )
+{
+    std::cout << _name << '\t' << _value << '\t' << _unit << '\n';
+}
+
+// -------------------------------------------------------------------------- //
+
+static double getFileSize( const std::string & _path )
+{
+    std::ifstream file( _path.c_str(), std::ios::binary | std::ios::ate );
+    return file.is_open() ? static_cast<double>( file.tellg() ) : 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Parses the corpus several times with some flags, and writes the best
+ *        throughput of each parser in MB/s, and the best time of the whole parse */
+static bool benchmarkParsing( const std::string & _corpus, const char * _name, ParserFlag _flags, unsigned _repetitions )
+{
+    const bool detailed = ( _flags & DETAILED ) != 0;
+    std::vector<double> bestSeconds( sizeof( FILES ) / sizeof( FILES[0] ), 0 );
+    double bestTotal = 0;
+
+    for( unsigned repetition = 0; repetition < _repetitions; ++repetition )
+    {
+        // the context must outlive the containers it fills
+        statistics recorded;
+        parserContext context( _flags );
+        context.setStatistics( &recorded );
+
+        dataset sentences;
+        linkset links;
+        tagset tags;
+        listset lists;
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const int parsed = parse( context, sentences, links, tags, lists,
+                                  _corpus + ( detailed ? "/sentences_detailed.csv" : "/sentences.csv" ),
+                                  _corpus + "/links.csv", _corpus + "/tags.csv", _corpus + "/lists.csv" );
+        const double total = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+        if( parsed != EXIT_SUCCESS )
+        {
+            std::cerr << "Cannot parse " << _corpus << '\n';
+            return false;
+        }
+
+        bestTotal = repetition == 0 ? total : std::min( bestTotal, total );
+
+        for( const statistics::stage & stage : recorded.getStages() )
+        {
+            for( size_t i = 0; i < bestSeconds.size(); ++i )
+            {
+                if( stage.m_name != std::string( "parse " ) + FILES[i] )
+                    continue;
+
+                const double seconds = static_cast<double>( stage.m_nanoseconds ) / 1e9;
+                bestSeconds[i] = bestSeconds[i] == 0 ? seconds : std::min( bestSeconds[i], seconds );
+            }
+        }
+    }
+
+    for( size_t i = 0; i < bestSeconds.size(); ++i )
+    {
+        if( bestSeconds[i] > 0 )
+            writeResult( std::string( "parse/" ) + _name + '/' + FILES[i],
+                         getFileSize( _corpus + '/' + FILES[i] ) / bestSeconds[i] / 1e6, "MB/s" );
+    }
+
+    writeResult( std::string( "parse/" ) + _name + "/total", bestTotal * 1000, "ms" );
+    return true;
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Looks up random sentences several times, and writes the best number
+ *        of lookups per second, in millions */
+template<typename LOOKUP>
+static void benchmarkLookup( const char * _name, sentence::id _highestId, unsigned _repetitions, LOOKUP _lookup )
+{
+    double bestSeconds = 0;
+    size_t found = 0;
+
+    for( unsigned repetition = 0; repetition < _repetitions; ++repetition )
+    {
+        // the same ids at each repetition
+        std::mt19937 random( 42 );
+        found = 0;
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for( size_t i = 0; i < NB_LOOKUPS; ++i )
+        {
+            const sentence::id id = 1 + static_cast<sentence::id>( random() % _highestId );
+            const sentence::id other = 1 + static_cast<sentence::id>( random() % _highestId );
+            found += _lookup( id, other );
+        }
+
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        bestSeconds = repetition == 0 ? seconds : std::min( bestSeconds, seconds );
+    }
+
+    // the result is used, so that the lookups are not optimized away
+    std::cerr << _name << ": " << found << " found\n";
+    writeResult( std::string( "lookup/" ) + _name, static_cast<double>( NB_LOOKUPS ) / bestSeconds / 1e6, "M/s" );
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Measures the lookups which the filters make for each sentence */
+static bool benchmarkLookups( const std::string & _corpus, unsigned _repetitions )
+{
+    parserContext context( PARALLEL );
+    dataset sentences;
+    linkset links;
+    tagset tags;
+    listset lists;
+
+    if( parse( context, sentences, links, tags, lists, _corpus + "/sentences.csv",
+               _corpus + "/links.csv", _corpus + "/tags.csv", _corpus + "/lists.csv" ) != EXIT_SUCCESS )
+    {
+        std::cerr << "Cannot parse " << _corpus << '\n';
+        return false;
+    }
+
+    const sentence::id highestId = sentences.getHighestId();
+    const tagset::tagId frequentTag = tags.getTagId( "ok" );
+    const listset::listId frequentList = lists.findListId( "list1" );
+
+    benchmarkLookup( "dataset/id", highestId, _repetitions, [&]( sentence::id _id, sentence::id )
+    {
+        return sentences[_id] != nullptr;
+    } );
+
+    benchmarkLookup( "linkset/areLinked", highestId, _repetitions, [&]( sentence::id _a, sentence::id _b )
+    {
+        return links.areLinked( _a, _b );
+    } );
+
+    benchmarkLookup( "linkset/getLinksOf", highestId, _repetitions, [&]( sentence::id _id, sentence::id )
+    {
+        const std::pair<linkset::const_iterator, linkset::const_iterator> linked = links.getLinksOfSafe( _id );
+        return static_cast<size_t>( linked.second - linked.first );
+    } );
+
+    benchmarkLookup( "tagset/isSentenceTagged", highestId, _repetitions, [&]( sentence::id _id, sentence::id )
+    {
+        return tags.isSentenceTagged( _id, frequentTag );
+    } );
+
+    benchmarkLookup( "listset/isSentenceInList", highestId, _repetitions, [&]( sentence::id _id, sentence::id )
+    {
+        return lists.isSentenceInList( _id, frequentList );
+    } );
+
+    return true;
+}
+
+// -------------------------------------------------------------------------- //
+
+int main( int argc, char * argv[] )
+{
+    if( argc < 2 || argc > 3 )
+    {
+        std::cerr << "Usage: " << argv[0] << " CORPUS_DIRECTORY [REPETITIONS]\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::string corpus = argv[1];
+    const unsigned repetitions = argc > 2 ? std::max( 1u, static_cast<unsigned>( std::strtoul( argv[2], nullptr, 10 ) ) ) : 3;
+
+    if( init( NONE ) != EXIT_SUCCESS )
+        return EXIT_FAILURE;
+
+    const bool succeeded =
+        benchmarkParsing( corpus, "parallel", PARALLEL, repetitions ) &&
+        benchmarkParsing( corpus, "single", NONE, repetitions ) &&
+        benchmarkParsing( corpus, "detailed", DETAILED | PARALLEL, repetitions ) &&
+        benchmarkParsing( corpus, "no-mmap", NO_MMAP | PARALLEL, repetitions ) &&
+        benchmarkLookups( corpus, repetitions );
+
+    terminate();
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
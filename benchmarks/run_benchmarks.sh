@@ -0,0 +1,76 @@
+#!/bin/sh
+# Generates a synthetic corpus, unless it already exists, then measures the
+# parsers, the lookups, every filter and some end-to-end queries on it.
+# Each result is written on a line, as "name<TAB>value<TAB>unit".
+#
+# usage: run_benchmarks.sh TATOPARSER GENERATE_CORPUS MICROBENCHMARKS [NB_SENTENCES [REPETITIONS [CORPUS_DIR]]]
+
+if [ $# -lt 3 ]
+then
+	echo "usage: $0 TATOPARSER GENERATE_CORPUS MICROBENCHMARKS [NB_SENTENCES [REPETITIONS [CORPUS_DIR]]]" >&2
+	exit 1
+fi
+
+tatoparser_bin="$1"
+generate_corpus_bin="$2"
+microbenchmarks_bin="$3"
+nb_sentences="${4-1000000}"
+repetitions="${5-3}"
+corpus="${6-./corpus-$nb_sentences}"
+
+if [ ! -f "$corpus/lists.csv" ]
+then
+	mkdir -p "$corpus" && "$generate_corpus_bin" "$corpus" "$nb_sentences" || exit 1
+fi
+
+"$microbenchmarks_bin" "$corpus" "$repetitions" 2>/dev/null || exit 1
+
+stats=$(mktemp)
+
+# Runs a query several times, and writes its best time and how many sentences
+# per second its filter went through.
+# usage: bench_query NAME FILTER_NAME ARGUMENTS...
+bench_query()
+{
+	name="$1"
+	filter="$2"
+	shift 2
+
+	best=""
+	i=0
+	while [ $i -lt "$repetitions" ]
+	do
+		start=$(date +%s%N)
+		"$tatoparser_bin" --csv-path "$corpus" --stats=json "$@" >/dev/null 2>"$stats" || return 1
+		end=$(date +%s%N)
+
+		elapsed=$(( (end - start) / 1000 ))
+		if [ -z "$best" ] || [ $elapsed -lt $best ]
+		then
+			best=$elapsed
+		fi
+		i=$((i + 1))
+	done
+
+	printf "query/%s\t%s\tms\n" "$name" $(awk "BEGIN { print $best / 1000 }")
+
+	sed -n "s/.*\"name\": \"filter $filter\", \"calls\": \([0-9]*\), \"milliseconds\": \([0-9.]*\),.*/\1 \2/p" "$stats" |
+		awk -v name="$name" '$2 > 0 { printf "filter/%s\t%g\tM/s\n", name, $1 / $2 / 1000 }'
+}
+
+bench_query parse-only          -                   --just-parse
+bench_query language            language            -l fra
+bench_query regex               regex               -r '.*e.*'
+bench_query regex-nocs          regex               --regex-nocs '.*E.*'
+bench_query has-id              has-id              --has-id 1000
+bench_query is-linked-to        is-linked-to        --is-linked-to 1000
+bench_query is-translatable-in  is-translatable-in  --is-translatable-in fra
+bench_query has-tag             has-tag             --has-tag ok
+bench_query translation-regex   translation-regex   -p '.*e.*'
+bench_query user                user                -u user1
+bench_query in-list             in-list             --in-list list1
+bench_query translates          translates          -t 1000
+bench_query fuzzy               fuzzy               -f 10 'hello world'
+bench_query language-regex      regex               -l eng -r '.*e.*' -i --display-lang
+
+rm -f "$stats"
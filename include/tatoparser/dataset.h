@@ -2,10 +2,12 @@
 #define DATASET_H
 
 #include <vector>
+#include <unordered_map>
 #include <cstddef>
 #include <assert.h>
 #include "namespace.h"
 #include "sentence.h"
+#include "name_interner.h"
 
 #ifndef TATO_RESTRICT
 #   define TATO_RESTRICT
@@ -37,6 +39,12 @@ struct dataset
     // fastAccessArray stores index of sentences
     typedef std::vector<std::size_t> fastAccessArray;
 
+    // how many sentences there are in each language, see packLanguage
+    typedef std::unordered_map<uint32_t, std::size_t> languageCounts;
+
+    // the ids of the sentences of a user
+    typedef std::vector<sentence::id> sentenceIds;
+
 public:
     void allocate( const datainfo & _info );
     void allocate( size_t _nbSentences );
@@ -62,10 +70,10 @@ public:
     {
         return m_allSentences.end();
     }
-    void addSentence( sentence::id _a, const char * _lang, const char * _data,
-                      const char * _author = nullptr,
-                      const char * _creationnDate = nullptr,
-                      const char * _lastModifiedDate = nullptr );
+    void addSentence( sentence::id _a, textSlice _lang, textSlice _data,
+                      textSlice _author = textSlice(),
+                      textSlice _creationnDate = textSlice(),
+                      textSlice _lastModifiedDate = textSlice() );
 
 public:
     // python interface
@@ -83,21 +91,104 @@ public:
         return m_allSentences.size();
     }
 
+    /**@brief Returns the highest id of all the sentences added so far, or
+     *        sentence::INVALID_ID if there is none. */
+    sentence::id getHighestId() const
+    {
+        return m_highestId;
+    }
+
+    /**@brief Returns a number which changes each time sentences are added,
+     *        replaced or removed, and which no other dataset has, so that
+     *        what is computed from the sentences can be kept until then */
+    uint64_t getGeneration() const
+    {
+        return m_generation;
+    }
+
+    /**@brief Returns how many sentences are written in a given language */
+    size_t countSentencesIn( const std::string & _lang ) const;
+
+    /**@brief Returns how many sentences are written in each language */
+    const languageCounts & getLanguageCounts() const
+    {
+        return m_languages;
+    }
+
+    /**@brief Returns the number of a user, see sentence::getUserId()
+     * @return sentence::NO_USER if no sentence was written by this user */
+    sentence::userId findUserId( const std::string & _user ) const
+    {
+        return m_users.find( _user );
+    }
+
+    /**@brief Returns how many different authors the sentences have */
+    size_t countUsers() const
+    {
+        return m_users.size();
+    }
+
+    /**@brief Returns the ids of the sentences written by a user, once
+     *        prepare() has been run. The sentences whose author is not known,
+     *        like those of sentences.csv, belong to no user. */
+    const sentenceIds & getSentencesOf( sentence::userId _user ) const;
+
+    /**@brief Returns how many sentences a user wrote, once prepare() has
+     *        been run */
+    size_t countSentencesOf( const std::string & _user ) const
+    {
+        return getSentencesOf( findUserId( _user ) ).size();
+    }
+
 public:
     // iterator interface
     sentence * operator[]( sentence::id );
     const sentence * operator[]( sentence::id ) const;
 
-    /**@brief Should be run before any sentence is retrieved using operator[] */
-    void prepare( const datainfo & _info );
+    /**@brief Adds a sentence, or replaces the sentence which has the same id,
+     *        once prepare() has been run. A sentence is not replaced by an
+     *        older version of itself, when the dates of last modification
+     *        are known.
+     * @warning The text of the sentence must outlive the dataset
+     * @return false if the sentence was older than the one stored */
+    bool updateSentence( const sentence & _sentence );
+
+    /**@brief Removes a sentence once prepare() has been run. The last
+     *        sentence takes its place, so that nothing is moved.
+     * @return false if there was no such sentence */
+    bool removeSentence( sentence::id _id );
+
+    /**@brief Should be run before any sentence is retrieved using operator[]
+     * @param[in] _nbThreads How many threads index the sentences at the same time */
+    void prepare( const datainfo & _info, unsigned _nbThreads = 1 );
 
 private:
     dataset( const dataset & ) TATO_DELETE;
     dataset & operator=( const dataset & ) TATO_DELETE;
 
+    // numbers the author of a sentence, if it has one
+    sentence::userId internUser( const sentence & _sentence );
+
+    // keeps the sentences of each user up to date, once prepare() has been run
+    void addToUser( sentence::userId _user, sentence::id _id );
+    void removeFromUser( sentence::userId _user, sentence::id _id );
+
 private:
     containerType   m_allSentences;
     fastAccessArray m_fastAccess;
+
+    // kept up to date by addSentence, so that no pass over the sentences is
+    // needed once they have been parsed
+    sentence::id    m_highestId;
+    languageCounts  m_languages;
+
+    // see getGeneration()
+    uint64_t        m_generation;
+
+    // the authors of the sentences, numbered as they are met, and the
+    // sentences of each of them, built by prepare()
+    nameInterner                m_users;
+    std::vector<sentenceIds>    m_sentencesOfUser;
 };
 
 // -------------------------------------------------------------------------- //
@@ -106,9 +197,9 @@ inline
 sentence * dataset::operator[]( sentence::id _id )
 {
     assert( !m_fastAccess.empty() ); // if m_fastAccess is empty, it means that prepare() command has not been run before.
-    assert( static_cast<std::size_t>( _id ) < m_fastAccess.size() );
 
-    if( m_fastAccess[_id] == static_cast<std::size_t>( -1 ) )
+    // links which are loaded lazily can point past the sentences
+    if( static_cast<std::size_t>( _id ) >= m_fastAccess.size() || m_fastAccess[_id] == static_cast<std::size_t>( -1 ) )
         return nullptr;
 
     return & ( m_allSentences[ m_fastAccess[_id] ] );
@@ -120,7 +211,7 @@ inline
 const sentence * dataset::operator[]( sentence::id _id ) const
 {
     assert( !m_fastAccess.empty() );
-    if( m_fastAccess[_id] == static_cast<std::size_t>( -1 ) )
+    if( static_cast<std::size_t>( _id ) >= m_fastAccess.size() || m_fastAccess[_id] == static_cast<std::size_t>( -1 ) )
         return nullptr;
 
     return & ( m_allSentences[ m_fastAccess[_id] ] );
@@ -129,12 +220,32 @@ const sentence * dataset::operator[]( sentence::id _id ) const
 // -------------------------------------------------------------------------- //
 
 inline
-void dataset::addSentence( sentence::id _id, const char * _lang, const char * _data,
-                           const char * _author,
-                           const char * _creationDate,
-                           const char * _lastModifiedDate )
+void dataset::addSentence( sentence::id _id, textSlice _lang, textSlice _data,
+                           textSlice _author,
+                           textSlice _creationDate,
+                           textSlice _lastModifiedDate )
 {
     m_allSentences.emplace_back( _id, _lang, _data, _author, _creationDate, _lastModifiedDate );
+
+    if( _id > m_highestId )
+        m_highestId = _id;
+
+    ++m_languages[ m_allSentences.back().getLangKey() ];
+    ++m_generation;
+
+    sentence & added = m_allSentences.back();
+    added.m_user = internUser( added );
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+sentence::userId dataset::internUser( const sentence & _sentence )
+{
+    // only sentences_detailed.csv tells the authors. The names are compared
+    // as they are, like sentence::belongsTo() does
+    const textSlice author = _sentence.getAuthor();
+    return author.size() == 0 ? sentence::NO_USER : m_users.intern( author.begin(), author.end(), false );
 }
 
 NAMESPACE_END
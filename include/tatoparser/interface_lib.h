@@ -1,10 +1,16 @@
 #ifndef TATOPARSER_INTERFACE_LIB_H
 #define TATOPARSER_INTERFACE_LIB_H
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <string>
 #include "namespace.h"
 
+#ifndef TATO_DELETE
+#   define TATO_DELETE
+#endif
+
 NAMESPACE_START
 
 // -------------------------------------------------------------------------- //
@@ -12,6 +18,9 @@ struct dataset;
 struct linkset;
 struct tagset;
 struct listset;
+struct statistics;
+
+struct parserResources;
 // -------------------------------------------------------------------------- //
 typedef uint32_t ParserFlag;
 
@@ -42,9 +51,105 @@ static const ParserFlag DETAILED   = 1<<5;
 // use more than one thread to parse
 static const ParserFlag PARALLEL   = 1<<6;
 
+// reads the whole files into memory before parsing them, instead of letting
+// the parsers wait for each page to be read from the disk
+static const ParserFlag PREFAULT   = 1<<7;
+
+// reads the files in large blocks instead of mapping them, for the file
+// systems on which page faults are slow, like network volumes
+static const ParserFlag NO_MMAP    = 1<<8;
+
+// counts the lines of the files before parsing them instead of estimating
+// their number, so that exactly the memory needed is reserved
+static const ParserFlag EXACT_COUNT = 1<<9;
+
+// parses links.csv, tags.csv and lists.csv the first time the links, the tags
+// or the lists are queried, instead of in parse()
+static const ParserFlag LAZY       = 1<<10;
+
+// -------------------------------------------------------------------------- //
+
+/**@struct parseProgress
+ * @brief How far the parsing of a file has gone */
+struct parseProgress
+{
+    // the path of the file
+    const char * m_path;
+
+    // how many bytes of the file have been parsed, decompressed if it is compressed
+    size_t m_bytesParsed;
+
+    // the size of the file, or 0 if it is not known, like for compressed files
+    size_t m_bytesTotal;
+
+    // how many lines have been parsed
+    size_t m_linesParsed;
+};
+
+/**@brief Receives the progress of the parsing, every few megabytes of each
+ *        file. It is called by the threads which parse, possibly by several
+ *        at the same time for different files, and must not throw. */
+typedef std::function<void( const parseProgress & )> progressCallback;
+
 // -------------------------------------------------------------------------- //
 
-/**@brief Initializes the parser
+/**@struct parserContext
+ * @brief Holds what the parsing of a corpus needs: the flags, the files which
+ *        the sentences point into, and the parsers which cancel() stops.
+ *
+ * Several contexts can parse different corpora at the same time, on different
+ * threads, and the structures they fill can be queried from any thread. A
+ * context parses one corpus at a time, and must outlive the structures it
+ * fills. Contexts are created after init() and destroyed before terminate(),
+ * which start and stop the logs. */
+struct parserContext
+{
+    /**@brief Constructs a context
+     * @param[in] _flags How to parse, see above. VERBOSE is only read by init() */
+    explicit parserContext( ParserFlag _flags );
+
+    /**@brief Destructs a context, unmapping the files the sentences point into */
+    ~parserContext();
+
+    /**@brief Tells whether a flag was given to the constructor */
+    bool isFlagSet( ParserFlag _flag ) const { return ( m_flags & _flag ) != 0; }
+
+    /**@brief Aborts the parsing operation of this context, if there is one.
+     *        The parsers stop after the chunk they are working on, and the
+     *        operation fails. This can be called from another thread or from a
+     *        signal handler. */
+    void cancel();
+
+    /**@brief Tells whether the operation in progress has been cancelled */
+    bool isCancelled() const;
+
+    /**@brief Sets the function which receives the progress of the parsing
+     * @warning Must not be called while parsing */
+    void setProgressCallback( progressCallback _callback );
+
+    /**@brief Records how long the stages of the parsing take: mapping,
+     *        counting and parsing each file, and indexing the sentences
+     * @param[in] _statistics Where the stages are recorded, or nullptr to stop
+     *            recording. It must outlive the parsing operations.
+     * @warning Must not be called while parsing */
+    void setStatistics( statistics * _statistics );
+
+    /**@brief The state of a parsing operation, only known to the library */
+    parserResources & getResources() { return *m_resources; }
+
+private:
+    parserContext( const parserContext & ) TATO_DELETE;
+    parserContext & operator=( const parserContext & ) TATO_DELETE;
+
+private:
+    ParserFlag          m_flags;
+    parserResources *   m_resources; // owned
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Initializes the library, and the context used by the functions which
+ *        do not take one
  * @return EXIT_SUCCESS on success */
 int init( ParserFlag _flags );
 
@@ -84,14 +189,82 @@ int parse( dataset & allSentences_,
            const std::string & _tagPath,
            const std::string & _listPath );
 
-/**@brief Destroys the parser
+/**@brief Parses the database, see above
+ * @param[in,out] _context Where the files are kept, and how they are parsed */
+int parse( parserContext & _context,
+           dataset & allSentences_,
+           linkset & allLinks_,
+           tagset  & allTags_,
+           listset & allLists_,
+           const std::string & _sentencePath,
+           const std::string & _linksPath,
+           const std::string & _tagPath,
+           const std::string & _listPath );
+
+/**@brief Parses the database, see above
+ * @param[in,out] _context Where the files are kept, and how they are parsed */
+int parse_( parserContext & _context,
+            dataset & allSentences_,
+            linkset & allLinks_,
+            tagset  & allTags_,
+            listset & allLists_,
+            const char * _sentencePath,
+            const char * _linksPath,
+            const char * _tagPath,
+            const char * _listPath );
+
+/**@brief Applies the changes between two exports of the database to the
+ *        structures filled by parse(), in a time which depends on the number
+ *        of changes rather than on the size of the database.
+ * @param[in,out] allSentences_ The sentences returned by parse()
+ * @param[in,out] allLinks_ The links returned by parse()
+ * @param[in,out] allTags_ The tags returned by parse()
+ * @param[in,out] allLists_ The lists returned by parse()
+ * @param[in] _sentenceDiff A path to a unified diff (diff -u) of sentences.csv,
+ *            or of sentences_detailed.csv with the DETAILED flag, or an empty string
+ * @param[in] _linksDiff A path to a unified diff of links.csv, or an empty string
+ * @param[in] _tagDiff A path to a unified diff of tags.csv, or an empty string
+ * @param[in] _listDiff A path to a unified diff of lists.csv, or an empty string
+ * @note The sentences which are added are appended, and a removed sentence is
+ *       replaced by the last one: the order of the file is not kept.
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE otherwise */
+int update( dataset & allSentences_,
+            linkset & allLinks_,
+            tagset  & allTags_,
+            listset & allLists_,
+            const std::string & _sentenceDiff,
+            const std::string & _linksDiff,
+            const std::string & _tagDiff,
+            const std::string & _listDiff );
+
+/**@brief Applies the changes between two exports of the database, see above
+ * @param[in,out] _context The context which parsed the structures */
+int update( parserContext & _context,
+            dataset & allSentences_,
+            linkset & allLinks_,
+            tagset  & allTags_,
+            listset & allLists_,
+            const std::string & _sentenceDiff,
+            const std::string & _linksDiff,
+            const std::string & _tagDiff,
+            const std::string & _listDiff );
+
+/**@brief Destroys the context created by init(), and stops the logs
  * @return EXIT_SUCCESS on success */
 int terminate();
 
 
-/**@brief Aborts a parsing operation. */
+/**@brief Aborts a parsing operation started without a context. */
 void cancel();
 
+/**@brief Sets the function which receives the progress of the parsing
+ *        operations started without a context */
+void setProgressCallback( progressCallback _callback );
+
+/**@brief Records how long the stages of the parsing operations started without
+ *        a context take, see parserContext::setStatistics() */
+void setStatistics( statistics * _statistics );
+
 NAMESPACE_END
 
 #endif // TATOPARSER_INTERFACE_LIB_H
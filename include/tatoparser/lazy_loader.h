@@ -0,0 +1,60 @@
+#ifndef TATOPARSER_LAZY_LOADER_H
+#define TATOPARSER_LAZY_LOADER_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "namespace.h"
+
+NAMESPACE_START
+
+/**@struct lazyLoader
+ * @brief Fills a container the first time it is queried, instead of when the
+ *        files are parsed.
+ *
+ * The loader belongs to the container object, not to its contents: moving
+ * contents into or out of the container leaves the loader where it is, so
+ * that the parsers can still swap their temporary containers in.
+ *
+ * @tparam CONTAINER linkset, tagset or listset */
+template<typename CONTAINER>
+struct lazyLoader
+{
+    /**@brief A function which fills the container */
+    typedef std::function<void( CONTAINER & )> loadFunction;
+
+    lazyLoader(): m_state() { }
+
+    /**@brief Keeps the loader in place, see above */
+    lazyLoader & operator=( lazyLoader && ) { return *this; }
+
+    /**@brief Registers the function which fills the container when it is
+     *        first queried */
+    void set( loadFunction _load )
+    {
+        m_state = std::make_shared<state>( std::move( _load ) );
+    }
+
+    /**@brief Fills the container, unless it already has been. If another
+     *        thread is filling it, waits until it is done. */
+    void load( CONTAINER & container_ ) const
+    {
+        if( m_state != nullptr )
+            std::call_once( m_state->m_once, m_state->m_load, std::ref( container_ ) );
+    }
+
+private:
+    struct state
+    {
+        explicit state( loadFunction _load ): m_load( std::move( _load ) ), m_once() { }
+
+        loadFunction    m_load;
+        std::once_flag  m_once;
+    };
+
+    std::shared_ptr<state> m_state;
+};
+
+NAMESPACE_END
+
+#endif // TATOPARSER_LAZY_LOADER_H
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include "namespace.h"
 #include "sentence.h"
+#include "lazy_loader.h"
 
 NAMESPACE_START
 
@@ -37,6 +38,17 @@ public:
      * @throw std::bad_alloc   */
     void addLink( sentence::id _a, sentence::id _b );
 
+    /**@brief Registers a link once the links have been parsed, whatever the
+     *        order in which the links are given
+     * @note The links of _a are moved to the end of the container if other
+     *       links follow them, which costs as many copies as _a has links
+     * @throw std::bad_alloc */
+    void insertLink( sentence::id _a, sentence::id _b );
+
+    /**@brief Removes a link once the links have been parsed
+     * @return false if the sentences were not linked */
+    bool removeLink( sentence::id _a, sentence::id _b );
+
     /**@brief checks if two sentences are linked
      * @param[in] _a The first sentence
      * @param[in] _b The second sentence
@@ -55,9 +67,20 @@ public:
      * @return A pair of iterator (begin,end), traversing a sequence of sentence::ids */
     std::pair<const_iterator, const_iterator> getLinksOfSafe( sentence::id _a ) const;
 
-    /**@brief Find the highest id in the list of links
-     * @return a sentence id */
-    sentence::id getHighestSentenceId() const;
+    /**@brief Returns the number of links stored so far
+     * @note This does not load the links, so that the parsers can call it */
+    size_t size() const { return m_links.size(); }
+
+    /**@brief Returns the highest id of all the linked sentences
+     * @return a sentence id, or sentence::INVALID_ID if there is no link */
+    sentence::id getHighestSentenceId() const { loadIfNeeded(); return m_highestId; }
+
+    /**@brief Fills the linkset the first time it is queried, rather than now
+     * @param[in] _load A function which adds all the links to the linkset it is given */
+    void loadLazily( lazyLoader<linkset>::loadFunction _load ) { m_loader.set( std::move( _load ) ); }
+
+private:
+    void loadIfNeeded() const { m_loader.load( const_cast<linkset &>( *this ) ); }
 
 private:
     typedef std::vector<sentence::id> linksArray;
@@ -85,6 +108,16 @@ private:
     /// of sentence 1.
     std::vector< std::pair<size_t, size_t> >    m_offsets;
 
+    /// kept up to date by addLink, so that the links need not be searched
+    /// for it once they have been parsed
+    sentence::id                                m_highestId;
+
+    /// the first sentence of the last link added: the links of a sentence
+    /// are consecutive in links.csv, so they are appended to the same list
+    sentence::id                                m_lastId;
+
+    lazyLoader<linkset>                         m_loader;
+
 private:
     linkset( const linkset & );
     linkset & operator=( const linkset & );
@@ -113,11 +146,9 @@ void linkset::addLink( sentence::id _a, sentence::id _b ) TATO_RESTRICT
     assert( sentence::INVALID_ID != _a );
     assert( sentence::INVALID_ID != _b );
 
-    static sentence::id lastIdValue = sentence::INVALID_ID;
-
-    if( lastIdValue != _a )
+    if( m_lastId != _a )
     {
-        lastIdValue = _a;
+        m_lastId = _a;
         while( _a >= static_cast<sentence::id>( m_offsets.size() ) )
         {
             m_offsets.resize( 2 * m_offsets.size() + 1 );
@@ -127,6 +158,10 @@ void linkset::addLink( sentence::id _a, sentence::id _b ) TATO_RESTRICT
 
     m_links.push_back( _b );
     m_offsets[_a].second = m_links.size();
+
+    const sentence::id highest = _a > _b ? _a : _b;
+    if( highest > m_highestId )
+        m_highestId = highest;
 }
 
 // -------------------------------------------------------------------------- //
@@ -149,6 +184,7 @@ inline
 std::pair<linkset::const_iterator, linkset::const_iterator>
 linkset::getLinksOf( sentence::id _a ) const
 {
+    loadIfNeeded();
     assert( _a < m_offsets.size() );
     const std::pair<size_t, size_t> & sentenceOffsets = m_offsets[_a];
     assert( sentenceOffsets.first < m_links.size() );
@@ -164,7 +200,8 @@ inline
 std::pair<linkset::const_iterator, linkset::const_iterator>
 linkset::getLinksOfSafe( sentence::id _a ) const
 {
-    return ( m_offsets.empty() || _a < m_offsets.size() ) ?
+    loadIfNeeded();
+    return _a < m_offsets.size() ?
            getLinksOf( _a ) :
            std::make_pair<linkset::const_iterator, linkset::const_iterator>(
                linkset::const_iterator( nullptr ), linkset::const_iterator( nullptr )
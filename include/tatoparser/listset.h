@@ -1,10 +1,11 @@
 #ifndef TATO_LISTSET_H
 #define TATO_LISTSET_H
 
-#include <functional> //hash
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include "sentence.h"
+#include "lazy_loader.h"
+#include "name_interner.h"
 
 NAMESPACE_START
 
@@ -15,10 +16,11 @@ struct listset
 
     // a list is a group of sentence::id
     typedef std::vector< sentence::id > list;
-    typedef std::vector< list > ctn;
-    typedef std::vector< list >::size_type offset;
-    typedef std::hash< std::string >::result_type list_hash;
-    typedef std::unordered_map< list_hash, offset > offset_list;
+
+    // An unique identifier representing a list, numbered from 1 in the order
+    // the lists are first met
+    typedef nameInterner::nameId listId;
+    static const listId INVALID_LISTID = nameInterner::NO_NAME;
 
     /**@brief Checks if a sentence belongs to a list
      * @param[in] _id An identifier for the sentence
@@ -28,9 +30,19 @@ struct listset
 
     /**@brief Checks if a sentence belongs to a list
      * @param[in] _id An identifier for the sentence
-     * @param[in] _hash The hash of the list
+     * @param[in] _list The id of the list
      * @return true if the sentence is part of the list */
-    bool isSentenceInList( sentence::id _id, list_hash _hash ) const;
+    bool isSentenceInList( sentence::id _id, listId _list ) const;
+
+    /**@brief Returns the id of a list
+     * @param[in] _listName The name of the list, in any case
+     * @return INVALID_LISTID if the list does not exist */
+    listId findListId( const std::string & _listName ) const;
+
+    /**@brief Returns the ids of the sentences of a list, in no particular order
+     * @param[in] _list The id of the list
+     * @return nullptr if the list does not exist */
+    const list * findList( listId _list ) const;
 
     /**@brief Checks if a list exists
      * @param[in] _listName The name of the list */
@@ -49,21 +61,46 @@ public:
      * @param[in] _listName The name of the list */
     void addSentenceToList( sentence::id _id, const std::string & _listName );
 
-    /**@brief Computes a hash from the name of a list
-     * @param[in] _listName the name of the list. There should not be any capital letters in.
-     * @return An hash corresponding to that name */
-    static list_hash computeHash( const std::string & _listName );
+    /**@brief Inserts a sentence into a list, without copying its name
+     * @param[in] _id the sentence id
+     * @param[in] _listBegin, _listEnd The name of the list, in any case
+     * @throw std::bad_alloc */
+    void addSentenceToList( sentence::id _id, const char * _listBegin, const char * _listEnd )
+    {
+        const listId newList = m_names.intern( _listBegin, _listEnd, true );
+        if( newList > m_lists.size() )
+            m_lists.resize( newList );
+
+        m_lists[ newList - 1 ].push_back( _id );
+    }
+
+    /**@brief Inserts a sentence into a list once the lists have been parsed,
+     *        unless it is already part of it
+     * @param[in] _id the sentence id
+     * @param[in] _listName The name of the list */
+    void insertIntoList( sentence::id _id, const std::string & _listName );
+
+    /**@brief Removes a sentence from a list once the lists have been parsed
+     * @return false if the sentence was not part of the list */
+    bool removeFromList( sentence::id _id, const std::string & _listName );
+
+    /**@brief Adds the lists of another listset, after those of this one. The
+     *        lists are numbered again.
+     * @throw std::bad_alloc */
+    void merge( listset && _other );
+
+    /**@brief Fills the listset the first time it is queried, rather than now
+     * @param[in] _load A function which adds all the lists to the listset it is given */
+    void loadLazily( lazyLoader<listset>::loadFunction _load ) { m_loader.set( std::move( _load ) ); }
 
 private:
-    // returns the offset inside m_lists, or -1 if it cannot be found
-    offset findOffset( list_hash ) const;
-    void addNewList( list_hash );
-    list & getList( const offset & );
-    const list & getList( const offset & ) const ;
+    void loadIfNeeded() const { m_loader.load( const_cast<listset &>( *this ) ); }
 
 private:
-    ctn m_lists;
-    offset_list m_offsets;
+    // the sentences of each list, the list id being the position plus one
+    std::vector<list> m_lists;
+    nameInterner m_names;
+    lazyLoader<listset> m_loader;
 };
 
 NAMESPACE_END
@@ -0,0 +1,149 @@
+#ifndef TATOPARSER_NAME_INTERNER_H
+#define TATOPARSER_NAME_INTERNER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "namespace.h"
+
+NAMESPACE_START
+
+/**@struct nameInterner
+ * @brief Numbers the distinct names of a file, like the names of the tags,
+ *        from 1 up.
+ *
+ * The names are stored one after the other in a single buffer, and looked up
+ * in an open addressing table, so that interning a name which is already
+ * known allocates nothing. A name can be lowered as it is interned, which
+ * spares a copy of the names read from a file. Only the ASCII letters are
+ * lowered, like toLower() does. */
+struct nameInterner
+{
+    typedef uint32_t nameId;
+    static const nameId NO_NAME = 0;
+
+    nameInterner(): m_names(), m_nameBegin( 1, 0 ), m_hashes(), m_slots() { }
+
+    /**@brief Returns the number of a name, and gives the next number to a
+     *        name which has none yet
+     * @param[in] _lowerCase true if the name has to be lowered first
+     * @throw std::bad_alloc */
+    nameId intern( const char * _begin, const char * _end, bool _lowerCase )
+    {
+        const uint64_t hash = computeHash( _begin, _end, _lowerCase );
+        size_t slot = findSlot( _begin, _end, _lowerCase, hash );
+
+        if( m_slots.size() != 0 && m_slots[slot] != NO_NAME )
+            return m_slots[slot];
+
+        // the table is kept at most half full
+        if( 2 * ( size() + 1 ) > m_slots.size() )
+        {
+            grow();
+            slot = findSlot( _begin, _end, _lowerCase, hash );
+        }
+
+        for( const char * character = _begin; character != _end; ++character )
+            m_names.push_back( _lowerCase ? lower( *character ) : *character );
+
+        m_nameBegin.push_back( m_names.size() );
+        m_hashes.push_back( hash );
+
+        return m_slots[slot] = static_cast<nameId>( size() );
+    }
+
+    /**@brief Returns the number of a name
+     * @return NO_NAME if the name was never interned */
+    nameId find( const char * _begin, const char * _end, bool _lowerCase ) const
+    {
+        return m_slots.empty() ? NO_NAME : m_slots[ findSlot( _begin, _end, _lowerCase, computeHash( _begin, _end, _lowerCase ) ) ];
+    }
+
+    /**@brief Returns the number of a name, which is already lowered if need be
+     * @return NO_NAME if the name was never interned */
+    nameId find( const std::string & _name ) const
+    {
+        return find( _name.data(), _name.data() + _name.size(), false );
+    }
+
+    /**@brief Returns the name which has a number */
+    std::string getName( nameId _id ) const
+    {
+        return std::string( m_names.begin() + static_cast<std::ptrdiff_t>( m_nameBegin[_id - 1] ),
+                            m_names.begin() + static_cast<std::ptrdiff_t>( m_nameBegin[_id] ) );
+    }
+
+    /**@brief Returns how many names have a number */
+    size_t size() const { return m_hashes.size(); }
+
+private:
+    static char lower( char _character )
+    {
+        return _character >= 'A' && _character <= 'Z' ? static_cast<char>( _character - 'A' + 'a' ) : _character;
+    }
+
+    // FNV-1a, of the lowered name if need be
+    static uint64_t computeHash( const char * _begin, const char * _end, bool _lowerCase )
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for( const char * character = _begin; character != _end; ++character )
+            hash = ( hash ^ static_cast<unsigned char>( _lowerCase ? lower( *character ) : *character ) ) * 1099511628211ULL;
+
+        return hash;
+    }
+
+    // the slot which holds a name, or the empty slot where it would be
+    size_t findSlot( const char * _begin, const char * _end, bool _lowerCase, uint64_t _hash ) const
+    {
+        const size_t mask = m_slots.size() - 1;
+        const size_t length = static_cast<size_t>( _end - _begin );
+
+        for( size_t slot = _hash & mask; m_slots.size() != 0; slot = ( slot + 1 ) & mask )
+        {
+            const nameId id = m_slots[slot];
+            if( id == NO_NAME )
+                return slot;
+
+            if( m_hashes[id - 1] != _hash || m_nameBegin[id] - m_nameBegin[id - 1] != length )
+                continue;
+
+            const char * name = m_names.data() + m_nameBegin[id - 1];
+            const char * character = _begin;
+            while( character != _end && ( _lowerCase ? lower( *character ) : *character ) == *name )
+                ++character, ++name;
+
+            if( character == _end )
+                return slot;
+        }
+
+        return 0;
+    }
+
+    void grow()
+    {
+        m_slots.assign( m_slots.empty() ? 64 : 2 * m_slots.size(), nameId( NO_NAME ) );
+
+        const size_t mask = m_slots.size() - 1;
+        for( size_t id = 1; id <= size(); ++id )
+        {
+            size_t slot = m_hashes[id - 1] & mask;
+            while( m_slots[slot] != NO_NAME )
+                slot = ( slot + 1 ) & mask;
+
+            m_slots[slot] = static_cast<nameId>( id );
+        }
+    }
+
+private:
+    // the names, one after the other, and where each of them begins
+    std::vector<char>       m_names;
+    std::vector<size_t>     m_nameBegin;
+
+    // the hash of each name, and the table which finds a name from its hash
+    std::vector<uint64_t>   m_hashes;
+    std::vector<nameId>     m_slots;
+};
+
+NAMESPACE_END
+
+#endif // TATOPARSER_NAME_INTERNER_H
@@ -1,31 +1,62 @@
 #ifndef TATO_PARSER_SENTENCE_H
 #define TATO_PARSER_SENTENCE_H
 
+#include <cstddef>
 #include <cstdint>
+#include <string>
 #include "namespace.h"
 
 NAMESPACE_START
 
+/**@struct textSlice
+ * @brief A range of characters inside a buffer owned by someone else, like a
+ *        mapped file. The characters are not followed by a null character. */
+struct textSlice
+{
+    textSlice(): m_begin( nullptr ), m_end( nullptr ) { }
+    textSlice( const char * _begin, const char * _end ): m_begin( _begin ), m_end( _end ) { }
+
+    /**@brief Constructs a slice from a range of pointers, like a boost::iterator_range */
+    template<typename RANGE> explicit
+    textSlice( const RANGE & _range ): m_begin( _range.begin() ), m_end( _range.end() ) { }
+
+    const char * begin() const { return m_begin; }
+    const char * end() const { return m_end; }
+    size_t size() const { return static_cast<size_t>( m_end - m_begin ); }
+
+    const char * m_begin;
+    const char * m_end;
+};
+
 struct sentence
 {
     /**@brief A number that identifies the sentence uniquely */
     typedef uint32_t id;
     static const uint32_t INVALID_ID = 0;
 
+    /**@brief A number that identifies the author of a sentence in a dataset,
+     *        see dataset::findUserId() */
+    typedef uint32_t userId;
+    static const userId NO_USER = 0;
+
+    /**@brief The longest language code that can be stored, like "tlh" or "\N" */
+    static const size_t MAX_LANG_SIZE = 4;
+
     /**@brief Constructs a sentence
      * @param[in] _id   An unique identifier for the sentence
      * @param[in] _lang The letters of the country
      * @param[in] _data The text that coposes the sentence
      * @param[in] _author The nickname of the creator of the sentence
      * @param[in] _creationDate When the sentence was first entered
-     * @param[in] _lastModifiedDate When the sentence was last modified */
+     * @param[in] _lastModifiedDate When the sentence was last modified
+     * @warning Only the language is copied, the other slices must outlive the sentence */
     explicit sentence(
         sentence::id _id   = INVALID_ID,
-        const char * _lang = nullptr,
-        const char * _data = nullptr,
-        const char * _author = nullptr,
-        const char * _creationDate = nullptr,
-        const char * _lastModifiedDate = nullptr
+        textSlice _lang = textSlice(),
+        textSlice _data = textSlice(),
+        textSlice _author = textSlice(),
+        textSlice _creationDate = textSlice(),
+        textSlice _lastModifiedDate = textSlice()
     );
 
     /**@brief Destructs a sentence */
@@ -44,22 +75,57 @@ struct sentence
      * @return A number that identify uniquely this sentence */
     id getId() const;
 
-    /**@brief Returns a pointer to the data */
-    const char * str() const { return m_data; }
+    /**@brief Returns a pointer to the first character of the text
+     * @warning The text is not null-terminated, use size() or end() */
+    const char * begin() const { return m_data; }
+
+    /**@brief Returns a pointer past the last character of the text */
+    const char * end() const { return m_data + m_size; }
+
+    /**@brief Returns the length of the text in bytes */
+    size_t size() const { return m_size; }
+
+    /**@brief Returns a copy of the text */
+    std::string str() const { return std::string( begin(), end() ); }
 
     /**@brief Returns a pointer to a character string representing the language */
     const char * lang() const { return m_lang; }
 
-    /**@brief Returns a pointer to the author nickname */
-    bool belongsTo( const std::string & _user ) const { return _user == m_author; }
+    /**@brief Returns the language packed in an integer, see packLanguage */
+    uint32_t getLangKey() const;
+
+    /**@brief Tells whether the sentence was written by a given user */
+    bool belongsTo( const std::string & _user ) const;
+
+    /**@brief Returns the nickname of the creator of the sentence, or an
+     *        empty slice if it is not known */
+    textSlice getAuthor() const { return textSlice( m_author, m_author + m_authorSize ); }
+
+    /**@brief Returns the number of the author in the dataset which holds the
+     *        sentence, or NO_USER if the author is not known or the sentence
+     *        is not in a dataset */
+    userId getUserId() const { return m_user; }
+
+    /**@brief Returns when the sentence was last modified, as written in
+     *        sentences_detailed.csv, or an empty slice if it is not known */
+    textSlice getLastModifiedDate() const { return textSlice( m_lastModifiedDate, m_lastModifiedDate + m_lastModifiedDateSize ); }
+
+private:
+    // the dataset numbers the authors of its sentences
+    friend struct dataset;
 
 private:
     id           m_id;
-    const char * m_lang;
+    uint32_t     m_size;
     const char * m_data;
     const char * m_author;
     const char * m_creationDate;
     const char * m_lastModifiedDate;
+    uint16_t     m_authorSize;
+    uint16_t     m_creationDateSize;
+    uint16_t     m_lastModifiedDateSize;
+    char         m_lang[MAX_LANG_SIZE + 1];
+    userId       m_user;
 };
 
 // -------------------------------------------------------------------------- //
@@ -69,7 +135,42 @@ inline sentence::id sentence::getId() const
     return m_id;
 }
 
+// -------------------------------------------------------------------------- //
+
+/**@brief Packs a language code of at most sentence::MAX_LANG_SIZE characters
+ *        into an integer, to count or compare languages quickly.
+ * @return 0 if the code is too long to be the language of a sentence */
+inline uint32_t packLanguage( const char * _lang, size_t _size )
+{
+    if( _size > sentence::MAX_LANG_SIZE )
+        return 0;
+
+    uint32_t key = 0;
+    for( size_t i = 0; i < _size; ++i )
+        key |= static_cast<uint32_t>( static_cast<unsigned char>( _lang[i] ) ) << ( 8 * i );
+
+    return key;
+}
+
+// -------------------------------------------------------------------------- //
 
+inline uint32_t sentence::getLangKey() const
+{
+    // the language is padded with null characters, which add nothing to the
+    // key: without stopping at the first one, this is a single load
+    uint32_t key = 0;
+    for( size_t i = 0; i < MAX_LANG_SIZE; ++i )
+        key |= static_cast<uint32_t>( static_cast<unsigned char>( m_lang[i] ) ) << ( 8 * i );
+
+    return key;
+}
+
+// -------------------------------------------------------------------------- //
+
+inline bool sentence::belongsTo( const std::string & _user ) const
+{
+    return _user.size() == m_authorSize && _user.compare( 0, m_authorSize, m_author, m_authorSize ) == 0;
+}
 
 NAMESPACE_END
 #endif  // TATO_PARSER_SENTENCE_H
@@ -0,0 +1,145 @@
+#ifndef TATOPARSER_STATISTICS_H
+#define TATOPARSER_STATISTICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "namespace.h"
+
+#ifndef TATO_DELETE
+#   define TATO_DELETE
+#endif
+
+NAMESPACE_START
+
+/**@struct statistics
+ * @brief Where the time of a run goes: how long each stage took, how many
+ *        times it ran, and how many items it produced, like the lines of a
+ *        file or the sentences kept by a filter.
+ *
+ * The stages are kept in the order they were first recorded. Several threads
+ * can record stages at the same time. */
+struct statistics
+{
+    struct stage
+    {
+        explicit stage( const std::string & _name )
+            : m_name( _name )
+            , m_calls( 0 )
+            , m_nanoseconds( 0 )
+            , m_items( 0 )
+            , m_isSelection( false )
+        {
+        }
+
+        std::string m_name;
+        uint64_t    m_calls;
+        uint64_t    m_nanoseconds;
+        uint64_t    m_items;
+
+        // each call produced one item or none, like a filter keeping a sentence
+        bool        m_isSelection;
+    };
+
+    statistics(): m_mutex(), m_stages() { }
+
+    /**@brief Adds some time, some calls and some items to a stage, creating
+     *        it if it is the first time it is recorded */
+    void record( const std::string & _stage, uint64_t _nanoseconds, uint64_t _calls = 1, uint64_t _items = 0 )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        add( _stage, _nanoseconds, _calls, _items );
+    }
+
+    /**@brief Records a stage which selects some of the items it is given, like
+     *        a filter, so that its selectivity can be reported
+     * @param[in] _calls How many items it was given
+     * @param[in] _kept How many of them it kept */
+    void recordSelection( const std::string & _stage, uint64_t _nanoseconds, uint64_t _calls, uint64_t _kept )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        add( _stage, _nanoseconds, _calls, _kept ).m_isSelection = true;
+    }
+
+    /**@brief Returns a copy of the stages recorded so far */
+    std::vector<stage> getStages() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_stages;
+    }
+
+private:
+    stage & add( const std::string & _stage, uint64_t _nanoseconds, uint64_t _calls, uint64_t _items )
+    {
+        std::vector<stage>::iterator found = m_stages.begin();
+        while( found != m_stages.end() && found->m_name != _stage )
+            ++found;
+
+        if( found == m_stages.end() )
+            found = m_stages.insert( found, stage( _stage ) );
+
+        found->m_calls += _calls;
+        found->m_nanoseconds += _nanoseconds;
+        found->m_items += _items;
+
+        return *found;
+    }
+
+private:
+    statistics( const statistics & ) TATO_DELETE;
+    statistics & operator=( const statistics & ) TATO_DELETE;
+
+private:
+    mutable std::mutex  m_mutex;
+    std::vector<stage>  m_stages;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@struct scopedTimer
+ * @brief Records the time between its construction and its destruction as one
+ *        call of a stage. Without statistics, it does not even read the clock. */
+struct scopedTimer
+{
+    typedef std::chrono::steady_clock clock;
+
+    /**@param[in] _statistics Where the stage is recorded, or nullptr */
+    scopedTimer( statistics * _statistics, const std::string & _stage )
+        : m_statistics( _statistics )
+        , m_stage( _statistics != nullptr ? _stage : std::string() )
+        , m_items( 0 )
+        , m_start( _statistics != nullptr ? clock::now() : clock::time_point() )
+    {
+    }
+
+    ~scopedTimer()
+    {
+        if( m_statistics != nullptr )
+            m_statistics->record( m_stage, elapsed( m_start ), 1, m_items );
+    }
+
+    /**@brief Sets how many items the stage produced */
+    void setItems( uint64_t _items ) { m_items = _items; }
+
+    /**@brief Returns how many nanoseconds have passed since a point in time */
+    static uint64_t elapsed( clock::time_point _start )
+    {
+        return static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now() - _start ).count() );
+    }
+
+private:
+    scopedTimer( const scopedTimer & ) TATO_DELETE;
+    scopedTimer & operator=( const scopedTimer & ) TATO_DELETE;
+
+private:
+    statistics *        m_statistics;
+    std::string         m_stage;
+    uint64_t            m_items;
+    clock::time_point   m_start;
+};
+
+NAMESPACE_END
+
+#endif // TATOPARSER_STATISTICS_H
@@ -2,11 +2,11 @@
 #define TAGSET_H
 
 #include <cstdint> // for tagId
-#include <functional> // for struct hash<>
-#include <map>
 #include <vector>
 #include "namespace.h"
 #include "sentence.h"
+#include "lazy_loader.h"
+#include "name_interner.h"
 
 NAMESPACE_START
 
@@ -17,9 +17,10 @@ struct tagset
     tagset();
     tagset & operator=( tagset && ) = default;
 
-    // An unique identifier representing the tag of the sentence
-    typedef uint16_t tagId;
-    static const tagId INVALID_TAGID = 0;
+    // An unique identifier representing the tag of the sentence, numbered
+    // from 1 in the order the tags are first met
+    typedef nameInterner::nameId tagId;
+    static const tagId INVALID_TAGID = nameInterner::NO_NAME;
 
     /**@brief Returns an id corresponding to a tag
      * @param[in] _tagName The name of the tag, for instance "maths. The name should be lower-case."
@@ -32,16 +33,60 @@ struct tagset
      * @throw std::bad_alloc */
     void tagSentence( sentence::id _id, const std::string & _tagName );
 
-    bool isSentenceTagged( sentence::id _id, tagId _tag );
+    /**@brief Adds a new tag for a given sentence, without copying its name
+     * @param[in] _tagBegin, _tagEnd The name of the tag, in any case
+     * @throw std::bad_alloc */
+    void tagSentence( sentence::id _id, const char * _tagBegin, const char * _tagEnd )
+    {
+        tagSentence( _id, m_names.intern( _tagBegin, _tagEnd, true ) );
+    }
+
+    /**@brief Adds the tags of another tagset, after those of this one. The
+     *        tags are numbered again.
+     * @throw std::bad_alloc */
+    void merge( tagset && _other );
+
+    /**@brief Returns the id of a tag without creating one, so that several
+     *        threads can look tags up at the same time
+     * @param[in] _tagName The name of the tag, in lower case
+     * @return INVALID_TAGID if no sentence has this tag */
+    tagId findTagId( const std::string & _tagName ) const;
+
+    /**@brief Checks whether a sentence has a tag. Several threads can call it
+     *        at the same time. */
+    bool isSentenceTagged( sentence::id _id, tagId _tag ) const;
+
+    /**@brief Returns the ids of the sentences which have a tag, in no
+     *        particular order. Several threads can call it at the same time. */
+    const std::vector<sentence::id> & getTaggedSentences( tagId _tag ) const;
+
+    /**@brief Tags a sentence once the tags have been parsed, unless it
+     *        already has the tag
+     * @throw std::bad_alloc */
+    void addTag( sentence::id _id, const std::string & _tagName );
+
+    /**@brief Removes a tag from a sentence once the tags have been parsed
+     * @return false if the sentence did not have the tag */
+    bool removeTag( sentence::id _id, const std::string & _tagName );
+
+    /**@brief Fills the tagset the first time it is queried, rather than now
+     * @param[in] _load A function which tags the sentences of the tagset it is given */
+    void loadLazily( lazyLoader<tagset>::loadFunction _load ) { m_loader.set( std::move( _load ) ); }
 
 private:
     void tagSentence( sentence::id _id, tagId _tag );
 
+    // returns the id of a tag, creating one for a new tag
+    tagId findOrCreateTagId( const std::string & _tagName );
+
+    void loadIfNeeded() const { m_loader.load( const_cast<tagset &>( *this ) ); }
+
     typedef std::vector<sentence::id> sentenceList;
-    typedef std::map<tagId, sentenceList> tagToSentencesMap;
 
-    tagToSentencesMap m_tagToSentences;
-    std::map<std::string, tagId> m_nameToId;
+    // the sentences of each tag, the tag id being the position plus one
+    std::vector<sentenceList> m_tagToSentences;
+    nameInterner m_names;
+    lazyLoader<tagset> m_loader;
 };
 
 // -------------------------------------------------------------------------- //
@@ -53,16 +98,19 @@ std::string toLower( const std::string & _name );
 inline
 tagset::tagId tagset::getTagId( const std::string & _tagName )
 {
-    assert( toLower( _tagName ) == _tagName );
-
-    static tagId idGenerator = 0;
+    // an id given before the tags are loaded would not match theirs
+    loadIfNeeded();
+    return findOrCreateTagId( _tagName );
+}
 
-    tagId & ret = m_nameToId[_tagName];
+// -------------------------------------------------------------------------- //
 
-    if( ret == 0 )
-        ret = ++idGenerator;
+inline
+tagset::tagId tagset::findOrCreateTagId( const std::string & _tagName )
+{
+    assert( toLower( _tagName ) == _tagName );
 
-    return ret;
+    return m_names.intern( _tagName.data(), _tagName.data() + _tagName.size(), false );
 }
 
 // -------------------------------------------------------------------------- //
@@ -70,8 +118,20 @@ tagset::tagId tagset::getTagId( const std::string & _tagName )
 inline
 void tagset::tagSentence( sentence::id _id, const std::string & _tagName )
 {
-    return tagSentence( _id, getTagId( toLower( _tagName ) ) );
+    tagSentence( _id, _tagName.data(), _tagName.data() + _tagName.size() );
 }
+
+// -------------------------------------------------------------------------- //
+
+inline
+void tagset::tagSentence( sentence::id _id, tagset::tagId _newTag )
+{
+    if( _newTag > m_tagToSentences.size() )
+        m_tagToSentences.resize( _newTag );
+
+    m_tagToSentences[ _newTag - 1 ].push_back( _id );
+}
+
 NAMESPACE_END
 
 #endif //TAGSET_H
@@ -0,0 +1,110 @@
+#ifndef TATOPARSER_BITMAP_H
+#define TATOPARSER_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+NAMESPACE_START
+
+/**@struct sentenceBitmap
+ * @brief A set of sentences, as one bit per position in the dataset. The sets
+ *        are combined 64 sentences at a time. */
+struct sentenceBitmap
+{
+    typedef uint64_t word;
+    static const size_t BITS_PER_WORD = 64;
+
+    /**@brief Constructs an empty set
+     * @param[in] _size How many sentences the dataset holds */
+    explicit sentenceBitmap( size_t _size = 0 )
+        : m_size( _size )
+        , m_words( ( _size + BITS_PER_WORD - 1 ) / BITS_PER_WORD, 0 )
+    {
+    }
+
+    /**@brief Returns how many sentences the dataset holds */
+    size_t size() const { return m_size; }
+
+    void set( size_t _position )
+    {
+        m_words[ _position / BITS_PER_WORD ] |= word( 1 ) << ( _position % BITS_PER_WORD );
+    }
+
+    bool test( size_t _position ) const
+    {
+        return ( m_words[ _position / BITS_PER_WORD ] >> ( _position % BITS_PER_WORD ) ) & 1;
+    }
+
+    /**@brief Keeps the sentences which are also in another set */
+    sentenceBitmap & operator&=( const sentenceBitmap & _other )
+    {
+        for( size_t i = 0; i < m_words.size(); ++i )
+            m_words[i] &= _other.m_words[i];
+
+        return *this;
+    }
+
+    /**@brief Adds the sentences of another set */
+    sentenceBitmap & operator|=( const sentenceBitmap & _other )
+    {
+        for( size_t i = 0; i < m_words.size(); ++i )
+            m_words[i] |= _other.m_words[i];
+
+        return *this;
+    }
+
+    /**@brief Removes the sentences of another set */
+    sentenceBitmap & andNot( const sentenceBitmap & _other )
+    {
+        for( size_t i = 0; i < m_words.size(); ++i )
+            m_words[i] &= ~_other.m_words[i];
+
+        return *this;
+    }
+
+    /**@brief Tells whether the set holds no sentence */
+    bool none() const
+    {
+        word any = 0;
+        for( word bits : m_words )
+            any |= bits;
+
+        return any == 0;
+    }
+
+    /**@brief Returns how many sentences the set holds */
+    size_t count() const
+    {
+        size_t nbSentences = 0;
+        for( word bits : m_words )
+            nbSentences += static_cast<size_t>( __builtin_popcountll( bits ) );
+
+        return nbSentences;
+    }
+
+    /**@brief Calls a function with the position of each sentence of a range,
+     *        in increasing order
+     * @param[in] _begin The first position of the range, a multiple of BITS_PER_WORD */
+    template<typename FUNCTION>
+    void forEach( size_t _begin, size_t _end, FUNCTION _function ) const
+    {
+        for( size_t i = _begin / BITS_PER_WORD; i * BITS_PER_WORD < _end; ++i )
+        {
+            for( word bits = m_words[i]; bits != 0; bits &= bits - 1 )
+            {
+                const size_t position = i * BITS_PER_WORD + static_cast<size_t>( __builtin_ctzll( bits ) );
+                if( position < _end )
+                    _function( position );
+            }
+        }
+    }
+
+private:
+    size_t              m_size;
+    std::vector<word>   m_words;
+};
+
+NAMESPACE_END
+
+#endif // TATOPARSER_BITMAP_H
@@ -0,0 +1,197 @@
+#include "prec.h"
+#include "character_inventory.h"
+#include "dataset_cache.h"
+#include <tatoparser/dataset.h>
+#include <unicode/uchar.h>
+#include <unicode/utf8.h>
+
+NAMESPACE_START
+
+const uint32_t characterInventory::alphabet::NO_NUMBER;
+
+// how many characters of each alphabet are stored as the bits of a word
+static const uint32_t NB_FREQUENT_CHARACTERS = 64;
+
+// how many sentences the characters are counted in, to number them from the
+// most frequent one
+static const size_t NB_SAMPLED_SENTENCES = 100000;
+
+// -------------------------------------------------------------------------- //
+
+// the distinct characters of a text, but spaces, punctuation marks and the
+// bytes which are not UTF-8, which a reader never needs to know
+static
+void collectCharacters( const char * _begin, const char * _end, std::vector<UChar32> & characters_ )
+{
+    // the ASCII characters, the most frequent, are told apart with a table
+    static const struct asciiTable
+    {
+        asciiTable()
+        {
+            for( UChar32 character = 0; character < 128; ++character )
+                m_known[character] = u_isUWhiteSpace( character ) || u_ispunct( character ) || u_iscntrl( character );
+        }
+
+        bool m_known[128];
+    } ascii;
+
+    const uint8_t * const text = reinterpret_cast<const uint8_t *>( _begin );
+    const int32_t length = static_cast<int32_t>( _end - _begin );
+    uint64_t asciiCharacters[2] = { 0, 0 };
+
+    characters_.clear();
+    for( int32_t i = 0; i < length; )
+    {
+        UChar32 character;
+        U8_NEXT( text, i, length, character );
+
+        if( character >= 0 && character < 128 )
+        {
+            if( !ascii.m_known[character] )
+                asciiCharacters[character / 64] |= uint64_t( 1 ) << ( character % 64 );
+        }
+        else if( character >= 0 && !u_isUWhiteSpace( character ) && !u_ispunct( character ) )
+            characters_.push_back( character );
+    }
+
+    std::sort( characters_.begin(), characters_.end() );
+    characters_.erase( std::unique( characters_.begin(), characters_.end() ), characters_.end() );
+
+    for( int word = 0; word < 2; ++word )
+    {
+        for( uint64_t bits = asciiCharacters[word]; bits != 0; bits &= bits - 1 )
+            characters_.push_back( word * 64 + __builtin_ctzll( bits ) );
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+std::shared_ptr<const characterInventory> characterInventory::get( const dataset & _dataset )
+{
+    // the inventory last built, for the queries which come after
+    static datasetCache<characterInventory> cache;
+
+    return cache.get( _dataset, [&_dataset]()
+    {
+        std::shared_ptr<characterInventory> inventory( new characterInventory() );
+        inventory->build( _dataset );
+        return std::shared_ptr<const characterInventory>( inventory );
+    } );
+}
+
+// -------------------------------------------------------------------------- //
+
+void characterInventory::build( const dataset & _dataset )
+{
+    std::vector<UChar32> characters;
+
+    // first, the alphabet of each language
+    std::unordered_map<uint32_t, uint16_t> alphabetOfLanguage;
+    m_alphabetOf.reserve( _dataset.size() );
+
+    for( const sentence & current : _dataset )
+    {
+        const auto inserted = alphabetOfLanguage.emplace( current.getLangKey(), static_cast<uint16_t>( m_alphabets.size() ) );
+        if( inserted.second )
+            m_alphabets.push_back( alphabet() );
+
+        m_alphabetOf.push_back( inserted.first->second );
+    }
+
+    // then, in how many sentences of a sample each character is, so that the
+    // most frequent characters are numbered first
+    std::vector< std::unordered_map<int32_t, uint32_t> > frequencies( m_alphabets.size() );
+    const size_t sampleStep = std::max<size_t>( 1, _dataset.size() / NB_SAMPLED_SENTENCES );
+
+    for( size_t position = 0; position < _dataset.size(); position += sampleStep )
+    {
+        const sentence & sampled = *( _dataset.begin() + static_cast<std::ptrdiff_t>( position ) );
+
+        collectCharacters( sampled.begin(), sampled.end(), characters );
+        for( UChar32 character : characters )
+            ++frequencies[ m_alphabetOf[position] ][character];
+    }
+
+    for( size_t language = 0; language < m_alphabets.size(); ++language )
+    {
+        std::vector< std::pair<uint32_t, int32_t> > byFrequency;
+        for( const std::pair<const int32_t, uint32_t> & frequency : frequencies[language] )
+            byFrequency.push_back( std::make_pair( frequency.second, frequency.first ) );
+
+        std::sort( byFrequency.begin(), byFrequency.end(),
+            []( const std::pair<uint32_t, int32_t> & _a, const std::pair<uint32_t, int32_t> & _b )
+            {
+                return _a.first != _b.first ? _a.first > _b.first : _a.second < _b.second;
+            } );
+
+        for( const std::pair<uint32_t, int32_t> & frequency : byFrequency )
+            m_alphabets[language].add( frequency.second );
+    }
+
+    // and lastly, the characters of each sentence, those which were not in
+    // the sample being numbered as they come
+    m_frequent.assign( _dataset.size(), 0 );
+    m_rareBegin.assign( 1, 0 );
+    m_rareBegin.reserve( _dataset.size() + 1 );
+
+    size_t position = 0;
+    for( dataset::const_iterator current = _dataset.begin(); current != _dataset.end(); ++current, ++position )
+    {
+        alphabet & numbers = m_alphabets[ m_alphabetOf[position] ];
+
+        collectCharacters( current->begin(), current->end(), characters );
+        for( UChar32 character : characters )
+        {
+            uint32_t number = numbers.find( character );
+            if( number == alphabet::NO_NUMBER )
+                number = numbers.add( character );
+
+            if( number < NB_FREQUENT_CHARACTERS )
+                m_frequent[position] |= uint64_t( 1 ) << number;
+            else
+                m_rare.push_back( number - NB_FREQUENT_CHARACTERS );
+        }
+
+        m_rareBegin.push_back( static_cast<uint32_t>( m_rare.size() ) );
+    }
+
+    qlog::info << "The character inventory holds " << m_alphabets.size() << " alphabets and "
+               << m_rare.size() << " rare characters\n";
+}
+
+// -------------------------------------------------------------------------- //
+
+characterInventory::knownCharacters characterInventory::learn( const std::string & _characters ) const
+{
+    knownCharacters known;
+    known.m_frequent.assign( m_alphabets.size(), 0 );
+    known.m_rare.resize( m_alphabets.size() );
+
+    for( size_t language = 0; language < m_alphabets.size(); ++language )
+        known.m_rare[language].assign( m_alphabets[language].m_size / 64 + 1, 0 );
+
+    std::vector<UChar32> characters;
+    collectCharacters( _characters.data(), _characters.data() + _characters.size(), characters );
+
+    for( size_t language = 0; language < m_alphabets.size(); ++language )
+    {
+        for( UChar32 character : characters )
+        {
+            const uint32_t number = m_alphabets[language].find( character );
+            if( number == alphabet::NO_NUMBER )
+                continue;
+
+            if( number < NB_FREQUENT_CHARACTERS )
+                known.m_frequent[language] |= uint64_t( 1 ) << number;
+            else
+            {
+                const uint32_t rare = number - NB_FREQUENT_CHARACTERS;
+                known.m_rare[language][rare / 64] |= uint64_t( 1 ) << ( rare % 64 );
+            }
+        }
+    }
+
+    return known;
+}
+
+NAMESPACE_END
@@ -0,0 +1,119 @@
+#ifndef TATOPARSER_CHARACTER_INVENTORY_H
+#define TATOPARSER_CHARACTER_INVENTORY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+NAMESPACE_START
+
+struct dataset;
+
+/**@struct characterInventory
+ * @brief The distinct characters of each sentence, to find quickly the
+ *        sentences written only with some characters.
+ *
+ * The characters of each language are numbered from the most frequent to the
+ * least. The 64 most frequent ones of a sentence are stored as the bits of a
+ * word, so that the characters of most sentences in alphabetic scripts are
+ * checked with a single and-not. The others, like most CJK characters, are
+ * stored as a list of their numbers. Spaces and punctuation marks are left
+ * out, they are always considered known. */
+struct characterInventory
+{
+    /**@struct knownCharacters
+     * @brief Some characters, as the numbers they have in each alphabet */
+    struct knownCharacters
+    {
+        // per alphabet, the 64 most frequent characters, and the others
+        std::vector<uint64_t>                   m_frequent;
+        std::vector< std::vector<uint64_t> >    m_rare;
+    };
+
+    /**@brief Returns the inventory of some sentences, built on first use and
+     *        kept for the next calls with the same sentences, like the
+     *        queries of a server. */
+    static std::shared_ptr<const characterInventory> get( const dataset & _dataset );
+
+    /**@brief Numbers some characters in the alphabet of each language
+     * @param[in] _characters The characters, in UTF-8 */
+    knownCharacters learn( const std::string & _characters ) const;
+
+    /**@brief Counts the distinct characters of a sentence which are not known
+     * @param[in] _position The position of the sentence in the dataset
+     * @param[in] _maxUnknown Stops counting past this number
+     * @return A number greater than _maxUnknown if there are more */
+    unsigned countUnknown( size_t _position, const knownCharacters & _known, unsigned _maxUnknown ) const
+    {
+        const uint16_t alphabet = m_alphabetOf[_position];
+        unsigned nbUnknown = static_cast<unsigned>( __builtin_popcountll( m_frequent[_position] & ~_known.m_frequent[alphabet] ) );
+
+        const std::vector<uint64_t> & rareKnown = _known.m_rare[alphabet];
+        for( uint32_t i = m_rareBegin[_position]; i < m_rareBegin[_position + 1] && nbUnknown <= _maxUnknown; ++i )
+        {
+            const uint32_t rare = m_rare[i];
+            nbUnknown += static_cast<unsigned>( ~( rareKnown[rare / 64] >> ( rare % 64 ) ) & 1 );
+        }
+
+        return nbUnknown;
+    }
+
+    /**@brief Returns how many sentences are in the inventory */
+    size_t size() const { return m_alphabetOf.size(); }
+
+private:
+    characterInventory(): m_alphabets(), m_alphabetOf(), m_frequent(), m_rareBegin(), m_rare() { }
+
+    void build( const dataset & _dataset );
+
+    /**@struct alphabet
+     * @brief The numbers of the characters of a language */
+    struct alphabet
+    {
+        static const uint32_t NO_NUMBER = static_cast<uint32_t>( -1 );
+
+        alphabet(): m_size( 0 ), m_others() { std::fill( m_ascii, m_ascii + 128, NO_NUMBER ); }
+
+        uint32_t find( int32_t _character ) const
+        {
+            if( _character < 128 )
+                return m_ascii[_character];
+
+            const std::unordered_map<int32_t, uint32_t>::const_iterator number = m_others.find( _character );
+            return number != m_others.end() ? number->second : NO_NUMBER;
+        }
+
+        // gives the next number to a character which has none yet
+        uint32_t add( int32_t _character )
+        {
+            uint32_t & number = _character < 128 ? m_ascii[_character] : m_others.emplace( _character, NO_NUMBER ).first->second;
+            if( number == NO_NUMBER )
+                number = m_size++;
+
+            return number;
+        }
+
+        uint32_t                                m_size;
+        uint32_t                                m_ascii[128];
+        std::unordered_map<int32_t, uint32_t>   m_others;
+    };
+
+private:
+    std::vector<alphabet>   m_alphabets;
+
+    // per sentence, the alphabet of its language and its frequent characters
+    std::vector<uint16_t>   m_alphabetOf;
+    std::vector<uint64_t>   m_frequent;
+
+    // the numbers of the rare characters of the sentences, minus 64, one
+    // sentence after the other
+    std::vector<uint32_t>   m_rareBegin;
+    std::vector<uint32_t>   m_rare;
+};
+
+NAMESPACE_END
+
+#endif // TATOPARSER_CHARACTER_INVENTORY_H
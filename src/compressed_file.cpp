@@ -0,0 +1,693 @@
+#include "prec_library.h"
+#include "compressed_file.h"
+#include "file_mapper.h"
+#include <fstream>
+
+#if HAVE_LIBZ == 1
+#   include <zlib.h>
+#endif
+#if HAVE_LIBBZ2 == 1
+#   include <bzlib.h>
+#endif
+#if HAVE_LIBLZMA == 1
+#   include <lzma.h>
+#endif
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+// size of the buffers the decompressed data is written into
+static const size_t CHUNK_SIZE = 16 * 1024 * 1024;
+
+// how many decompressed chunks can wait for the parser before the
+// decompression thread stops and waits
+static const size_t MAX_READY_CHUNKS = 4;
+
+// size of the buffer the compressed data is read into
+static const size_t INPUT_BUFFER_SIZE = 1024 * 1024;
+
+// tar archives are made of blocks of 512 bytes
+static const size_t TAR_BLOCK_SIZE = 512;
+
+// -------------------------------------------------------------------------- //
+
+compressionFormat detectCompression( const std::string & _filename )
+{
+    std::ifstream file( _filename.c_str(), std::ios_base::binary | std::ios_base::in );
+    unsigned char magic[6] = { 0, 0, 0, 0, 0, 0 };
+
+    if( !file.is_open() || !file.read( reinterpret_cast<char *>( magic ), sizeof( magic ) ) )
+        return UNCOMPRESSED;
+
+    if( magic[0] == 0x1f && magic[1] == 0x8b )
+        return GZIP;
+
+    if( magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h' )
+        return BZIP2;
+
+    if( magic[0] == 0xfd && magic[1] == '7' && magic[2] == 'z' &&
+        magic[3] == 'X'  && magic[4] == 'Z' && magic[5] == 0x00 )
+        return XZ;
+
+    return UNCOMPRESSED;
+}
+
+// -------------------------------------------------------------------------- //
+
+bool isCompressionSupported( compressionFormat _format )
+{
+    switch( _format )
+    {
+        case UNCOMPRESSED: return true;
+#       if HAVE_LIBZ == 1
+        case GZIP: return true;
+#       endif
+#       if HAVE_LIBBZ2 == 1
+        case BZIP2: return true;
+#       endif
+#       if HAVE_LIBLZMA == 1
+        case XZ: return true;
+#       endif
+        default: return false;
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+const char * getCompressionName( compressionFormat _format )
+{
+    switch( _format )
+    {
+        case GZIP:  return "gzip";
+        case BZIP2: return "bzip2";
+        case XZ:    return "xz";
+        default:    return "none";
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@struct decoder
+ * @brief Produces the decompressed content of a file */
+struct decoder
+{
+    virtual ~decoder() { }
+
+    /**@brief Decompresses at most _size bytes
+     * @return The number of bytes written, 0 at the end of the file
+     * @throw corrupted_file */
+    virtual size_t read( char * _out, size_t _size ) = 0;
+
+    /**@brief Reads exactly _size bytes, unless the end of the file is reached
+     * @return The number of bytes written */
+    size_t readFully( char * _out, size_t _size )
+    {
+        size_t total = 0;
+        for( size_t n; total < _size && ( n = read( _out + total, _size - total ) ) != 0; )
+            total += n;
+
+        return total;
+    }
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@struct compressedDecoder
+ * @brief Reads compressed bytes from a file, for the decoders to consume */
+struct compressedDecoder : public decoder
+{
+    explicit
+    compressedDecoder( const std::string & _filename )
+        :m_filename( _filename )
+        ,m_file( _filename.c_str(), std::ios_base::binary | std::ios_base::in )
+        ,m_input( new char[INPUT_BUFFER_SIZE] )
+    {
+        if( !m_file.is_open() )
+            throw invalid_file( _filename );
+    }
+
+protected:
+    /**@brief Reads the next block of compressed data
+     * @return The number of bytes read, 0 at the end of the file */
+    size_t refill()
+    {
+        m_file.read( m_input.get(), INPUT_BUFFER_SIZE );
+
+        if( m_file.bad() )
+            throw invalid_file( m_filename );
+
+        return static_cast<size_t>( m_file.gcount() );
+    }
+
+    const std::string           m_filename;
+    std::ifstream               m_file;
+    std::unique_ptr<char[]>     m_input;
+};
+
+// -------------------------------------------------------------------------- //
+
+#if HAVE_LIBZ == 1
+/**@struct gzipDecoder
+ * @brief Decompresses gzip files, including the ones made of several members */
+struct gzipDecoder : public compressedDecoder
+{
+    explicit
+    gzipDecoder( const std::string & _filename )
+        :compressedDecoder( _filename )
+        ,m_stream()
+        ,m_inMember( false )
+        ,m_eof( false )
+    {
+        // 15 is the largest window, +32 detects gzip and zlib headers
+        if( inflateInit2( &m_stream, 15 + 32 ) != Z_OK )
+            throw std::bad_alloc();
+    }
+
+    ~gzipDecoder()
+    {
+        inflateEnd( &m_stream );
+    }
+
+    size_t read( char * _out, size_t _size ) TATO_OVERRIDE
+    {
+        m_stream.next_out = reinterpret_cast<Bytef *>( _out );
+        m_stream.avail_out = static_cast<uInt>( _size );
+
+        while( m_stream.avail_out != 0 && !m_eof )
+        {
+            if( m_stream.avail_in == 0 )
+            {
+                const size_t nbRead = refill();
+                if( nbRead == 0 )
+                {
+                    // the file ends in the middle of a member
+                    if( m_inMember )
+                        throw corrupted_file( m_filename );
+
+                    m_eof = true;
+                    break;
+                }
+
+                m_stream.next_in = reinterpret_cast<Bytef *>( m_input.get() );
+                m_stream.avail_in = static_cast<uInt>( nbRead );
+            }
+
+            m_inMember = true;
+            const int ret = inflate( &m_stream, Z_NO_FLUSH );
+
+            if( ret == Z_STREAM_END )
+            {
+                // another member may follow (pigz, concatenated files…)
+                m_inMember = false;
+                if( inflateReset( &m_stream ) != Z_OK )
+                    throw corrupted_file( m_filename );
+            }
+            else if( ret != Z_OK && ret != Z_BUF_ERROR )
+                throw corrupted_file( m_filename );
+        }
+
+        return _size - m_stream.avail_out;
+    }
+
+private:
+    z_stream    m_stream;
+    bool        m_inMember;
+    bool        m_eof;
+};
+#endif // HAVE_LIBZ
+
+// -------------------------------------------------------------------------- //
+
+#if HAVE_LIBBZ2 == 1
+/**@struct bzip2Decoder
+ * @brief Decompresses bzip2 files, including concatenated streams (pbzip2) */
+struct bzip2Decoder : public compressedDecoder
+{
+    explicit
+    bzip2Decoder( const std::string & _filename )
+        :compressedDecoder( _filename )
+        ,m_stream()
+        ,m_inStream( false )
+        ,m_eof( false )
+    {
+        if( BZ2_bzDecompressInit( &m_stream, 0, 0 ) != BZ_OK )
+            throw std::bad_alloc();
+    }
+
+    ~bzip2Decoder()
+    {
+        BZ2_bzDecompressEnd( &m_stream );
+    }
+
+    size_t read( char * _out, size_t _size ) TATO_OVERRIDE
+    {
+        m_stream.next_out = _out;
+        m_stream.avail_out = static_cast<unsigned int>( _size );
+
+        while( m_stream.avail_out != 0 && !m_eof )
+        {
+            if( m_stream.avail_in == 0 )
+            {
+                const size_t nbRead = refill();
+                if( nbRead == 0 )
+                {
+                    if( m_inStream )
+                        throw corrupted_file( m_filename );
+
+                    m_eof = true;
+                    break;
+                }
+
+                m_stream.next_in = m_input.get();
+                m_stream.avail_in = static_cast<unsigned int>( nbRead );
+            }
+
+            m_inStream = true;
+            const int ret = BZ2_bzDecompress( &m_stream );
+
+            if( ret == BZ_STREAM_END )
+            {
+                // restart the decoder in case another stream follows, keeping
+                // the input that has not been consumed yet
+                char * const nextIn = m_stream.next_in;
+                const unsigned int availIn = m_stream.avail_in;
+                char * const nextOut = m_stream.next_out;
+                const unsigned int availOut = m_stream.avail_out;
+
+                m_inStream = false;
+                BZ2_bzDecompressEnd( &m_stream );
+                if( BZ2_bzDecompressInit( &m_stream, 0, 0 ) != BZ_OK )
+                    throw std::bad_alloc();
+
+                m_stream.next_in = nextIn;
+                m_stream.avail_in = availIn;
+                m_stream.next_out = nextOut;
+                m_stream.avail_out = availOut;
+            }
+            else if( ret != BZ_OK )
+                throw corrupted_file( m_filename );
+        }
+
+        return _size - m_stream.avail_out;
+    }
+
+private:
+    bz_stream   m_stream;
+    bool        m_inStream;
+    bool        m_eof;
+};
+#endif // HAVE_LIBBZ2
+
+// -------------------------------------------------------------------------- //
+
+#if HAVE_LIBLZMA == 1
+/**@struct xzDecoder
+ * @brief Decompresses xz files. Files made of several blocks are decompressed
+ *        in parallel when liblzma supports it. */
+struct xzDecoder : public compressedDecoder
+{
+    explicit
+    xzDecoder( const std::string & _filename )
+        :compressedDecoder( _filename )
+        ,m_stream() // same as LZMA_STREAM_INIT
+        ,m_action( LZMA_RUN )
+        ,m_eof( false )
+    {
+        lzma_ret ret;
+
+#       if LZMA_VERSION >= 50040002
+        lzma_mt options;
+        memset( &options, 0, sizeof( options ) );
+        options.flags = LZMA_CONCATENATED;
+        options.threads = std::max( 1u, std::thread::hardware_concurrency() );
+        options.memlimit_threading = UINT64_C( 1 ) << 30;
+        options.memlimit_stop = UINT64_MAX;
+        ret = lzma_stream_decoder_mt( &m_stream, &options );
+#       else
+        ret = lzma_stream_decoder( &m_stream, UINT64_MAX, LZMA_CONCATENATED );
+#       endif
+
+        if( ret != LZMA_OK )
+            throw std::bad_alloc();
+    }
+
+    ~xzDecoder()
+    {
+        lzma_end( &m_stream );
+    }
+
+    size_t read( char * _out, size_t _size ) TATO_OVERRIDE
+    {
+        m_stream.next_out = reinterpret_cast<uint8_t *>( _out );
+        m_stream.avail_out = _size;
+
+        while( m_stream.avail_out != 0 && !m_eof )
+        {
+            if( m_stream.avail_in == 0 && m_action == LZMA_RUN )
+            {
+                const size_t nbRead = refill();
+                if( nbRead == 0 )
+                    m_action = LZMA_FINISH;
+
+                m_stream.next_in = reinterpret_cast<const uint8_t *>( m_input.get() );
+                m_stream.avail_in = nbRead;
+            }
+
+            const lzma_ret ret = lzma_code( &m_stream, m_action );
+
+            if( ret == LZMA_STREAM_END )
+                m_eof = true;
+            else if( ret != LZMA_OK )
+                throw corrupted_file( m_filename );
+        }
+
+        return _size - m_stream.avail_out;
+    }
+
+private:
+    lzma_stream m_stream;
+    lzma_action m_action;
+    bool        m_eof;
+};
+#endif // HAVE_LIBLZMA
+
+// -------------------------------------------------------------------------- //
+
+/**@struct tarExtractor
+ * @brief Returns the content of the first regular file of a tar archive, or
+ *        the data untouched if it is not a tar archive */
+struct tarExtractor : public decoder
+{
+    explicit
+    tarExtractor( std::unique_ptr<decoder> && _source, const std::string & _filename )
+        :m_source( std::move( _source ) )
+        ,m_filename( _filename )
+        ,m_header()
+        ,m_pending( 0 )
+        ,m_pendingOffset( 0 )
+        ,m_isTar( false )
+        ,m_remaining( 0 )
+        ,m_done( false )
+    {
+        // look at the first block to know if this is an archive
+        m_pending = m_source->readFully( m_header, TAR_BLOCK_SIZE );
+
+        if( m_pending == TAR_BLOCK_SIZE && memcmp( m_header + 257, "ustar", 5 ) == 0 )
+        {
+            m_isTar = true;
+            m_pending = 0;
+            findFirstFile();
+        }
+    }
+
+    size_t read( char * _out, size_t _size ) TATO_OVERRIDE
+    {
+        if( !m_isTar )
+        {
+            // hand over the bytes that were read to look for a tar header
+            if( m_pendingOffset < m_pending )
+            {
+                const size_t nbCopied = std::min( _size, m_pending - m_pendingOffset );
+                memcpy( _out, m_header + m_pendingOffset, nbCopied );
+                m_pendingOffset += nbCopied;
+                return nbCopied;
+            }
+
+            return m_source->read( _out, _size );
+        }
+
+        if( m_done || m_remaining == 0 )
+            return 0;
+
+        const size_t nbRead = m_source->read( _out, static_cast<size_t>( std::min<uint64_t>( _size, m_remaining ) ) );
+        if( nbRead == 0 )
+            throw corrupted_file( m_filename );
+
+        m_remaining -= nbRead;
+        return nbRead;
+    }
+
+private:
+    // parses an octal number as found in tar headers
+    static uint64_t parseOctal( const char * _field, size_t _size )
+    {
+        uint64_t value = 0;
+        for( size_t i = 0; i < _size && _field[i] >= '0' && _field[i] <= '7'; ++i )
+            value = value * 8 + static_cast<uint64_t>( _field[i] - '0' );
+
+        return value;
+    }
+
+    // skips the entries of the archive until a regular file is found, m_header
+    // containing the header of the first entry
+    void findFirstFile()
+    {
+        char skipped[TAR_BLOCK_SIZE];
+
+        for( ;; )
+        {
+            const uint64_t size = parseOctal( m_header + 124, 12 );
+            const char type = m_header[156];
+
+            if( type == '0' || type == '\0' )
+            {
+                m_remaining = size;
+                return;
+            }
+
+            // skip the data of the entry (directory, long name, pax header…)
+            for( uint64_t nbBlocks = ( size + TAR_BLOCK_SIZE - 1 ) / TAR_BLOCK_SIZE; nbBlocks; --nbBlocks )
+            {
+                if( m_source->readFully( skipped, TAR_BLOCK_SIZE ) != TAR_BLOCK_SIZE )
+                    throw corrupted_file( m_filename );
+            }
+
+            // an empty block marks the end of the archive
+            if( m_source->readFully( m_header, TAR_BLOCK_SIZE ) != TAR_BLOCK_SIZE ||
+                m_header[0] == '\0' )
+            {
+                m_done = true;
+                return;
+            }
+        }
+    }
+
+private:
+    std::unique_ptr<decoder>    m_source;
+    const std::string           m_filename;
+    char                        m_header[TAR_BLOCK_SIZE];
+    size_t                      m_pending;
+    size_t                      m_pendingOffset;
+    bool                        m_isTar;
+    uint64_t                    m_remaining;
+    bool                        m_done;
+};
+
+// -------------------------------------------------------------------------- //
+
+static
+std::unique_ptr<decoder> createDecoder( const std::string & _filename, compressionFormat _format )
+{
+    std::unique_ptr<decoder> ret;
+
+    switch( _format )
+    {
+#       if HAVE_LIBZ == 1
+        case GZIP:  ret.reset( new gzipDecoder( _filename ) ); break;
+#       endif
+#       if HAVE_LIBBZ2 == 1
+        case BZIP2: ret.reset( new bzip2Decoder( _filename ) ); break;
+#       endif
+#       if HAVE_LIBLZMA == 1
+        case XZ:    ret.reset( new xzDecoder( _filename ) ); break;
+#       endif
+        default:    throw unsupported_compression( _filename );
+    }
+
+    return ret;
+}
+
+// -------------------------------------------------------------------------- //
+
+decompressedStream::decompressedStream( const std::string & _filename, compressionFormat _format )
+    :m_filename( _filename )
+    ,m_source( createDecoder( _filename, _format ) ) // errors reach the caller directly
+    ,m_mutex()
+    ,m_chunkReady()
+    ,m_slotFree()
+    ,m_buffers()
+    ,m_freeBuffers()
+    ,m_readyChunks()
+    ,m_finished( false )
+    ,m_stop( false )
+    ,m_error()
+    ,m_producer()
+{
+    llog::info << "decompressing " << _filename << " (" << getCompressionName( _format ) << ")\n";
+    m_producer = std::thread( &decompressedStream::produce, this );
+}
+
+// -------------------------------------------------------------------------- //
+
+decompressedStream::~decompressedStream() TATO_NO_THROW
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stop = true;
+    }
+    m_slotFree.notify_all();
+
+    if( m_producer.joinable() )
+        m_producer.join();
+}
+
+// -------------------------------------------------------------------------- //
+
+size_t decompressedStream::acquireBuffer( size_t _size )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    // do not get too far ahead of the parser
+    m_slotFree.wait( lock, [this]() { return m_stop || m_readyChunks.size() < MAX_READY_CHUNKS; } );
+
+    if( m_stop )
+        return static_cast<size_t>( -1 );
+
+    size_t index;
+    if( m_freeBuffers.empty() )
+    {
+        m_buffers.push_back( buffer() );
+        index = m_buffers.size() - 1;
+    }
+    else
+    {
+        index = m_freeBuffers.back();
+        m_freeBuffers.pop_back();
+    }
+
+    buffer & chosen = m_buffers[index];
+    if( chosen.m_size < _size )
+    {
+        chosen.m_data.reset( new char[_size] );
+        chosen.m_size = _size;
+    }
+
+    return index;
+}
+
+// -------------------------------------------------------------------------- //
+
+void decompressedStream::publish( const inputChunk & _chunk )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_readyChunks.push_back( _chunk );
+    }
+    m_chunkReady.notify_one();
+}
+
+// -------------------------------------------------------------------------- //
+
+void decompressedStream::produce()
+{
+    try
+    {
+        tarExtractor input( std::move( m_source ), m_filename );
+        std::unique_ptr<char[]> carry;  // the beginning of a line cut at the end of a chunk
+        size_t carrySize = 0;
+        size_t bufferSize = CHUNK_SIZE;
+
+        for( bool eof = false; !eof; )
+        {
+            const size_t index = acquireBuffer( bufferSize );
+            if( index == static_cast<size_t>( -1 ) )
+                return;
+
+            // no need to lock: the buffer is not visible to the parser yet
+            char * const data = m_buffers[index].m_data.get();
+            const size_t size = m_buffers[index].m_size;
+
+            if( carrySize )
+                memcpy( data, carry.get(), carrySize );
+
+            const size_t filled = carrySize + input.readFully( data + carrySize, size - carrySize );
+            eof = filled < size;
+            carrySize = 0;
+
+            // the chunk stops after the last complete line, the rest is carried
+            // over to the next one
+            size_t chunkSize = filled;
+            if( !eof )
+            {
+                const char * lastNewLine = data + filled;
+                while( lastNewLine != data && *( lastNewLine - 1 ) != '\n' )
+                    --lastNewLine;
+
+                chunkSize = static_cast<size_t>( lastNewLine - data );
+                carrySize = filled - chunkSize;
+                carry.reset( new char[carrySize] );
+                memcpy( carry.get(), data + chunkSize, carrySize );
+
+                // a single line does not fit in a buffer: use larger ones
+                bufferSize = std::max( CHUNK_SIZE, 2 * carrySize );
+            }
+
+            inputChunk chunk;
+            chunk.m_begin = data;
+            chunk.m_end = data + chunkSize;
+            chunk.m_buffer = index;
+
+            if( chunkSize )
+                publish( chunk );
+            else
+                release( chunk );
+        }
+    }
+    catch( ... )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_finished = true;
+    }
+    m_chunkReady.notify_all();
+}
+
+// -------------------------------------------------------------------------- //
+
+bool decompressedStream::next( inputChunk & chunk_ )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_chunkReady.wait( lock, [this]() { return m_finished || !m_readyChunks.empty(); } );
+
+    if( !m_readyChunks.empty() )
+    {
+        chunk_ = m_readyChunks.front();
+        m_readyChunks.pop_front();
+        lock.unlock();
+        m_slotFree.notify_one();
+        return true;
+    }
+
+    if( m_error )
+        std::rethrow_exception( m_error );
+
+    return false;
+}
+
+// -------------------------------------------------------------------------- //
+
+void decompressedStream::release( const inputChunk & _chunk )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    assert( _chunk.m_buffer < m_buffers.size() );
+    m_freeBuffers.push_back( _chunk.m_buffer );
+}
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
@@ -0,0 +1,124 @@
+#ifndef LIBTATOPARSER_COMPRESSED_FILE_H
+#define LIBTATOPARSER_COMPRESSED_FILE_H
+
+#include "tatoparser/namespace.h"
+#include "input_stream.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+/**@brief The formats a file can be compressed with */
+enum compressionFormat
+{
+    UNCOMPRESSED,
+    GZIP,
+    BZIP2,
+    XZ
+};
+
+/**@brief Guesses how a file is compressed by looking at its first bytes
+ * @param[in] _filename The path to the file
+ * @return UNCOMPRESSED if the format is not recognized or the file cannot be read */
+compressionFormat detectCompression( const std::string & _filename );
+
+/**@brief Tells whether the library was built with support for a given format */
+bool isCompressionSupported( compressionFormat _format );
+
+/**@brief Returns a human readable name for a format, like "gzip" */
+const char * getCompressionName( compressionFormat _format );
+
+/**@struct corrupted_file
+ * @brief An exception thrown if a compressed file cannot be decompressed */
+struct corrupted_file
+{
+    corrupted_file( const std::string & _filename ): m_filename( _filename ) { }
+    std::string m_filename;
+};
+
+/**@struct unsupported_compression
+ * @brief An exception thrown if the library was built without support for
+ *        the format a file is compressed with */
+struct unsupported_compression
+{
+    unsupported_compression( const std::string & _filename ): m_filename( _filename ) { }
+    std::string m_filename;
+};
+
+struct decoder;
+
+/**@struct decompressedStream
+ * @brief Decompresses a gzip, bzip2 or xz file on a dedicated thread.
+ *
+ * The decompressed data is written in a ring of large buffers which are handed
+ * over to the parser as soon as they are full, so that decompressing and
+ * parsing happen at the same time. If the file is a tar archive, the content
+ * of the first regular file it contains is returned. */
+struct decompressedStream : public inputStream
+{
+    /**@brief Opens a compressed file and starts decompressing it
+     * @throw invalid_file if the file cannot be opened,
+     *        unsupported_compression if the format is not supported */
+    decompressedStream( const std::string & _filename, compressionFormat _format );
+
+    /**@brief Stops the decompression thread and frees every buffer */
+    ~decompressedStream() TATO_NO_THROW;
+
+    /**@brief Waits for the next chunk of decompressed lines
+     * @throw corrupted_file if the decompression failed */
+    bool next( inputChunk & chunk_ ) TATO_OVERRIDE;
+
+    void release( const inputChunk & _chunk ) TATO_OVERRIDE;
+
+private:
+    struct buffer
+    {
+        std::unique_ptr<char[]> m_data;
+        size_t                  m_size;
+    };
+
+    // body of the decompression thread
+    void produce();
+
+    // returns the index of a buffer of at least _size bytes, or -1 if the
+    // stream is being destroyed
+    size_t acquireBuffer( size_t _size );
+
+    void publish( const inputChunk & _chunk );
+
+private:
+    const std::string           m_filename;
+    std::unique_ptr<decoder>    m_source;   // moved to the decompression thread
+
+    std::mutex                  m_mutex;
+    std::condition_variable     m_chunkReady;
+    std::condition_variable     m_slotFree;
+
+    std::vector<buffer>         m_buffers;
+    std::vector<size_t>         m_freeBuffers;
+    std::deque<inputChunk>      m_readyChunks;
+
+    bool                        m_finished;
+    bool                        m_stop;
+    std::exception_ptr          m_error;
+
+    std::thread                 m_producer;
+
+private:
+    decompressedStream( const decompressedStream & ) TATO_DELETE;
+    decompressedStream & operator=( const decompressedStream & ) TATO_DELETE;
+};
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
+
+#endif // LIBTATOPARSER_COMPRESSED_FILE_H
@@ -0,0 +1,55 @@
+#include "prec_library.h"
+#include "csv_diff.h"
+#include "file_mapper.h"
+#include <fstream>
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+// -------------------------------------------------------------------------- //
+
+// tells whether a line starts with a given prefix
+static
+bool startsWith( const std::string & _line, const char * _prefix )
+{
+    return _line.compare( 0, strlen( _prefix ), _prefix ) == 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+csvDiff readDiff( const std::string & _filename )
+{
+    std::ifstream file( _filename.c_str() );
+    if( !file.is_open() )
+        throw invalid_file( _filename );
+
+    csvDiff diff;
+    std::string line;
+
+    while( std::getline( file, line ) )
+    {
+        // the names of the files being compared
+        if( startsWith( line, "--- " ) || startsWith( line, "+++ " ) )
+            continue;
+
+        // the lines of a csv file all start with a number, so that anything
+        // else is a hunk marker, a context line or a "\ No newline" remark
+        if( line.size() < 2 || line[1] < '0' || line[1] > '9' )
+            continue;
+
+        if( line[0] == '+' )
+            diff.m_added.append( line, 1, std::string::npos ).push_back( '\n' );
+        else if( line[0] == '-' )
+            diff.m_removed.append( line, 1, std::string::npos ).push_back( '\n' );
+    }
+
+    if( file.bad() )
+        throw invalid_file( _filename );
+
+    return diff;
+}
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
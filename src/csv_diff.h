@@ -0,0 +1,49 @@
+#ifndef LIBTATOPARSER_CSV_DIFF_H
+#define LIBTATOPARSER_CSV_DIFF_H
+
+#include "tatoparser/namespace.h"
+#include <string>
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+/**@struct csvDiff
+ * @brief The lines that a unified diff (diff -u old.csv new.csv) adds to and
+ *        removes from a csv file. Each line ends with a '\n', so that the
+ *        parsers can read them as they read the csv files. */
+struct csvDiff
+{
+    std::string m_added;
+    std::string m_removed;
+};
+
+/**@brief Reads a unified diff of a csv file. The headers, the hunk markers
+ *        and the context lines are skipped.
+ * @throw invalid_file if the file cannot be read */
+csvDiff readDiff( const std::string & _filename );
+
+/**@brief Calls a function for each line of a diff, with the
+ *        first field as a number and the rest of the line, without the '\t'
+ * @tparam FUNCTION void( unsigned long, const std::string & ) */
+template<typename FUNCTION>
+void forEachDiffLine( const std::string & _lines, FUNCTION _function )
+{
+    size_t begin = 0;
+    while( begin < _lines.size() )
+    {
+        const size_t end = _lines.find( '\n', begin );
+        const size_t tab = _lines.find( '\t', begin );
+
+        if( tab < end )
+            _function( std::stoul( _lines.substr( begin, tab - begin ) ), _lines.substr( tab + 1, end - tab - 1 ) );
+
+        begin = end + 1;
+    }
+}
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
+
+#endif // LIBTATOPARSER_CSV_DIFF_H
@@ -15,7 +15,7 @@ struct datainfo
 
 
     // number of lines in links.csv
-    typename fastLinkParser<char *>::nb_of_lines m_nbLinks;
+    typename fastLinkParser<const char *>::nb_of_lines m_nbLinks;
 
     // the id which had the greatest value out of all the parsed sentences
     sentence::id m_highestId;
@@ -1,14 +1,31 @@
 #include "prec_library.h"
 #include "tatoparser/dataset.h"
 #include "datainfo.h"
+#include <atomic>
 
 NAMESPACE_START
 
 // -------------------------------------------------------------------------- //
 
+// each dataset counts its changes from its own range of numbers, so that two
+// datasets never have the same generation
+static
+uint64_t firstGeneration()
+{
+    static std::atomic<uint64_t> nbDatasets( 0 );
+    return ++nbDatasets << 32;
+}
+
+// -------------------------------------------------------------------------- //
+
 dataset::dataset()
     :m_allSentences()
     ,m_fastAccess()
+    ,m_highestId( sentence::INVALID_ID )
+    ,m_languages()
+    ,m_generation( firstGeneration() )
+    ,m_users()
+    ,m_sentencesOfUser()
 {
 }
 
@@ -30,24 +47,241 @@ void dataset::allocate( const size_t _nbSentences )
 
 // -------------------------------------------------------------------------- //
 
-void dataset::prepare( const datainfo & _info ) TATO_RESTRICT
+// Calls a function on each part of a range of items, each part on its own
+// thread, with the number of the part and the bounds of its items
+template<typename FUNCTION>
+static
+void forEachPart( size_t _nbItems, size_t _nbParts, FUNCTION _function )
+{
+    const size_t partSize = _nbItems / _nbParts;
+
+    std::vector< std::future<void> > parts;
+    for( size_t part = 1; part < _nbParts; ++part )
+    {
+        const size_t last = part + 1 == _nbParts ? _nbItems : ( part + 1 ) * partSize;
+        parts.push_back( std::async( std::launch::async, _function, part, part * partSize, last ) );
+    }
+
+    _function( 0, 0, _nbParts == 1 ? _nbItems : partSize );
+    for( std::future<void> & part : parts )
+        part.get();
+}
+
+// -------------------------------------------------------------------------- //
+
+void dataset::prepare( const datainfo & _info, const unsigned _nbThreads ) TATO_RESTRICT
 {
     m_fastAccess.resize( _info.m_highestId + 1, static_cast<size_t>( -1 ) );
     const size_t nbSentences = m_allSentences.size();
 
-    for( size_t index = 0; index < nbSentences; ++index )
+    // below that, starting the threads costs more than it saves
+    static const size_t MIN_SENTENCES_PER_THREAD = 64 * 1024;
+    const size_t nbThreads = std::max<size_t>( 1, std::min<size_t>( _nbThreads, nbSentences / MIN_SENTENCES_PER_THREAD ) );
+
+    // the ids are unique, so each thread writes to its own entries
+    forEachPart( nbSentences, nbThreads, [this]( size_t, size_t _first, size_t _last )
+    {
+        for( size_t index = _first; index < _last; ++index )
+        {
+            const sentence & TATO_RESTRICT curSentence = m_allSentences[ index ];
+            assert( curSentence.getId() != sentence::INVALID_ID );
+            assert( curSentence.getId() < static_cast<sentence::id>( m_fastAccess.size() ) );
+            m_fastAccess[curSentence.getId()] = index;
+        }
+    } );
+
+    // the sentences of each user, which the users' filters look up instead of
+    // reading the author of every sentence. There are none without authors
+    m_sentencesOfUser.clear();
+    if( m_users.size() == 0 )
+        return;
+
+    // each part counts the sentences of each user it holds, and then writes
+    // their ids after those of the parts before it
+    std::vector< std::vector<size_t> > positions( nbThreads, std::vector<size_t>( m_users.size() + 1, 0 ) );
+    forEachPart( nbSentences, nbThreads, [this, &positions]( size_t _part, size_t _first, size_t _last )
+    {
+        std::vector<size_t> & counts = positions[_part];
+        for( size_t index = _first; index < _last; ++index )
+            ++counts[ m_allSentences[index].getUserId() ];
+    } );
+
+    m_sentencesOfUser.resize( m_users.size() );
+    for( size_t user = 1; user <= m_users.size(); ++user )
+    {
+        size_t nbSentencesOfUser = 0;
+        for( std::vector<size_t> & counts : positions )
+        {
+            const size_t count = counts[user];
+            counts[user] = nbSentencesOfUser;
+            nbSentencesOfUser += count;
+        }
+
+        m_sentencesOfUser[user - 1].resize( nbSentencesOfUser );
+    }
+
+    forEachPart( nbSentences, nbThreads, [this, &positions]( size_t _part, size_t _first, size_t _last )
+    {
+        std::vector<size_t> & nextPositions = positions[_part];
+        for( size_t index = _first; index < _last; ++index )
+        {
+            const sentence & TATO_RESTRICT curSentence = m_allSentences[ index ];
+            const sentence::userId user = curSentence.getUserId();
+            if( user != sentence::NO_USER )
+                m_sentencesOfUser[user - 1][ nextPositions[user]++ ] = curSentence.getId();
+        }
+    } );
+}
+
+// -------------------------------------------------------------------------- //
+
+const dataset::sentenceIds & dataset::getSentencesOf( const sentence::userId _user ) const
+{
+    static const sentenceIds noSentence;
+
+    if( _user == sentence::NO_USER || _user > m_sentencesOfUser.size() )
+        return noSentence;
+
+    return m_sentencesOfUser[_user - 1];
+}
+
+// -------------------------------------------------------------------------- //
+
+void dataset::addToUser( const sentence::userId _user, const sentence::id _id )
+{
+    if( _user == sentence::NO_USER || m_fastAccess.empty() )
+        return;
+
+    if( _user > m_sentencesOfUser.size() )
+        m_sentencesOfUser.resize( _user );
+
+    m_sentencesOfUser[_user - 1].push_back( _id );
+}
+
+// -------------------------------------------------------------------------- //
+
+void dataset::removeFromUser( const sentence::userId _user, const sentence::id _id )
+{
+    if( _user == sentence::NO_USER || _user > m_sentencesOfUser.size() )
+        return;
+
+    sentenceIds & ids = m_sentencesOfUser[_user - 1];
+    const sentenceIds::iterator removed = std::find( ids.begin(), ids.end(), _id );
+    if( removed != ids.end() )
+    {
+        *removed = ids.back();
+        ids.pop_back();
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+size_t dataset::countSentencesIn( const std::string & _lang ) const
+{
+    const languageCounts::const_iterator count = m_languages.find( packLanguage( _lang.data(), _lang.size() ) );
+    return count == m_languages.end() ? 0 : count->second;
+}
+
+// -------------------------------------------------------------------------- //
+
+// the dates are written as "2014-06-17 10:59:03", so that they compare as
+// strings, and are "\N" or empty when they are not known
+static
+bool isOlder( const textSlice & _date, const textSlice & _reference )
+{
+    const auto isKnown = []( const textSlice & _d ) { return _d.size() > 2; };
+
+    return isKnown( _date ) && isKnown( _reference ) &&
+           std::lexicographical_compare( _date.begin(), _date.end(), _reference.begin(), _reference.end() );
+}
+
+// -------------------------------------------------------------------------- //
+
+bool dataset::updateSentence( const sentence & _sentence )
+{
+    const sentence::id id = _sentence.getId();
+    assert( id != sentence::INVALID_ID );
+
+    sentence * const stored = m_fastAccess.empty() ? nullptr : operator[]( id );
+    if( stored != nullptr )
+    {
+        if( isOlder( _sentence.getLastModifiedDate(), stored->getLastModifiedDate() ) )
+            return false;
+
+        --m_languages[ stored->getLangKey() ];
+        ++m_languages[ _sentence.getLangKey() ];
+
+        const sentence::userId previousUser = stored->getUserId();
+        *stored = _sentence;
+        stored->m_user = internUser( _sentence );
+
+        if( stored->m_user != previousUser )
+        {
+            removeFromUser( previousUser, id );
+            addToUser( stored->m_user, id );
+        }
+
+        ++m_generation;
+        return true;
+    }
+
+    if( id >= m_fastAccess.size() )
+        m_fastAccess.resize( id + 1, static_cast<size_t>( -1 ) );
+
+    m_allSentences.push_back( _sentence );
+    m_fastAccess[id] = m_allSentences.size() - 1;
+
+    sentence & added = m_allSentences.back();
+    added.m_user = internUser( _sentence );
+    addToUser( added.m_user, id );
+
+    if( id > m_highestId )
+        m_highestId = id;
+
+    ++m_languages[ _sentence.getLangKey() ];
+    ++m_generation;
+    return true;
+}
+
+// -------------------------------------------------------------------------- //
+
+bool dataset::removeSentence( sentence::id _id )
+{
+    const sentence * const removed = m_fastAccess.empty() ? nullptr : operator[]( _id );
+    if( removed == nullptr )
+        return false;
+
+    const size_t index = m_fastAccess[_id];
+    --m_languages[ removed->getLangKey() ];
+    removeFromUser( removed->getUserId(), _id );
+
+    if( index + 1 != m_allSentences.size() )
     {
-        const sentence & TATO_RESTRICT curSentence = m_allSentences[ index ];
-        assert( curSentence.getId() != sentence::INVALID_ID );
-        assert( curSentence.getId() < static_cast<sentence::id>( m_fastAccess.size() ) );
-        m_fastAccess[curSentence.getId()] = index;
+        m_allSentences[index] = m_allSentences.back();
+        m_fastAccess[ m_allSentences[index].getId() ] = index;
     }
+
+    m_allSentences.pop_back();
+    m_fastAccess[_id] = static_cast<size_t>( -1 );
+
+    // m_highestId is left as is: it remains an upper bound
+    ++m_generation;
+    return true;
 }
 
 // -------------------------------------------------------------------------- //
 //
 void dataset::merge( dataset && _other )
 {
+    // the other dataset numbered its users on its own
+    std::vector<sentence::userId> userIds( _other.m_users.size() + 1, sentence::NO_USER );
+    for( size_t user = 1; user < userIds.size(); ++user )
+    {
+        const std::string name = _other.m_users.getName( static_cast<sentence::userId>( user ) );
+        userIds[user] = m_users.intern( name.data(), name.data() + name.size(), false );
+    }
+
+    const size_t firstMerged = m_allSentences.size();
     m_allSentences.insert(
         m_allSentences.end(),
         std::make_move_iterator( _other.m_allSentences.begin() ),
@@ -58,5 +292,21 @@ void dataset::merge( dataset && _other )
         std::make_move_iterator( _other.m_fastAccess.begin() ),
         std::make_move_iterator( _other.m_fastAccess.end() )
     );
+
+    for( size_t index = firstMerged; index < m_allSentences.size(); ++index )
+        m_allSentences[index].m_user = userIds[ m_allSentences[index].m_user ];
+
+    if( _other.m_highestId > m_highestId )
+        m_highestId = _other.m_highestId;
+
+    for( const languageCounts::value_type & language : _other.m_languages )
+        m_languages[ language.first ] += language.second;
+
+    _other.m_highestId = sentence::INVALID_ID;
+    _other.m_languages.clear();
+    _other.m_users = nameInterner();
+
+    ++m_generation;
+    ++_other.m_generation;
 }
 NAMESPACE_END
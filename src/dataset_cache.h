@@ -0,0 +1,67 @@
+#ifndef TATOPARSER_DATASET_CACHE_H
+#define TATOPARSER_DATASET_CACHE_H
+
+#include <tatoparser/dataset.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+NAMESPACE_START
+
+/**@struct datasetCache
+ * @brief Keeps what was last computed from some sentences, for the next calls
+ *        with the same sentences, like the queries of a server. It is
+ *        computed again once the sentences have changed. */
+template<typename T>
+struct datasetCache
+{
+    datasetCache()
+        :m_mutex()
+        ,m_dataset( nullptr )
+        ,m_generation( 0 )
+        ,m_value()
+    {
+    }
+
+    /**@brief Returns what was computed from some sentences, or computes it
+     * @param[in] _build Called with no argument to compute it. What it
+     *            returns is not kept if it is null. */
+    template<typename BUILDER>
+    std::shared_ptr<const T> get( const dataset & _dataset, BUILDER _build );
+
+private:
+    datasetCache( const datasetCache & ) TATO_DELETE;
+    datasetCache & operator=( const datasetCache & ) TATO_DELETE;
+
+private:
+    std::mutex                  m_mutex;
+    const dataset *             m_dataset;
+    uint64_t                    m_generation;
+    std::shared_ptr<const T>    m_value;
+};
+
+// -------------------------------------------------------------------------- //
+
+template<typename T>
+template<typename BUILDER>
+std::shared_ptr<const T> datasetCache<T>::get( const dataset & _dataset, BUILDER _build )
+{
+    // the calls which come at the same time wait for the first one to compute it
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( m_value && m_dataset == &_dataset && m_generation == _dataset.getGeneration() )
+        return m_value;
+
+    std::shared_ptr<const T> value = _build();
+    if( value )
+    {
+        m_dataset = &_dataset;
+        m_generation = _dataset.getGeneration();
+        m_value = value;
+    }
+
+    return value;
+}
+
+NAMESPACE_END
+#endif // TATOPARSER_DATASET_CACHE_H
@@ -60,6 +60,42 @@ void cout_display::writeSentence(
 
 // ------------------------------------------------------------------------- //
 
+stream_display::stream_display( std::ostream & _output,
+                                const std::string & _separator )
+    : m_output( _output )
+    , m_separator { _separator }
+{
+}
+
+void stream_display::writeSentence(
+    const sentence & _sentence, const flag _flags, const unsigned _lineNumber,
+    const sentence * _translation )
+{
+    if( _flags & DISPLAY_LINE_NUMBER )
+        m_output << _lineNumber << m_separator;
+
+    if( _flags & DISPLAY_IDS )
+        m_output << _sentence.getId() << m_separator;
+
+    if( _flags & DISPLAY_LANGUAGES )
+        m_output << _sentence.lang() << m_separator;
+
+    m_output.write( _sentence.begin(), static_cast<std::streamsize>( _sentence.size() ) );
+
+    if( _flags & DISPLAY_FIRST_TRANSL && _translation )
+    {
+        m_output << m_separator;
+        m_output.write( _translation->begin(), static_cast<std::streamsize>( _translation->size() ) );
+    }
+
+    m_output << '\n';
+
+    if( !m_output )
+        throw cannot_write();
+}
+
+// ------------------------------------------------------------------------- //
+
 ncurses_display::ncurses_display()
     : m_window { initscr() }
 {
@@ -2,6 +2,7 @@
 #define DISPLAY_H
 
 #include <cstdint>
+#include <ostream>
 #include <string>
 #include <curses.h>
 
@@ -78,6 +79,35 @@ private:
     const std::string m_separator;
 };
 
+/**
+ * @struct stream_display
+ * @author qdii
+ * @desc A display that writes on any stream, without colors, like the
+ *       answers of the server */
+struct stream_display : public display
+{
+    virtual ~stream_display() noexcept(true) = default;
+    /**
+     * @brief Constructs a stream_display
+     * @param[in] _output The stream to write to, which must outlive the display
+     * @param[in] _separator A string used to separate the different items */
+    stream_display( std::ostream & _output, const std::string & _separator );
+
+    /**
+     * @brief Writes a sentence to the stream
+     * @param[in] _sentence The sentence to write
+     * @param[in] _flags Information on what data to write
+     * @param[in] _lineNumber Which line should the sentence be output at
+     * @param[in] _translation A translation to display, or nullptr */
+    virtual void writeSentence( const sentence & _sentence, display::flag _flags,
+                                unsigned _lineNumber,
+                                const sentence * _translation ) override final;
+
+private:
+    std::ostream & m_output;
+    const std::string m_separator;
+};
+
 /**
  * @struct ncurses_display
  * @author qdii
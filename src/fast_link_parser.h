@@ -4,6 +4,8 @@
 #include <algorithm>
 #include "tatoparser/namespace.h"
 #include "tatoparser/linkset.h"
+#include "line_counter.h"
+#include "parse_monitor.h"
 
 #pragma GCC visibility push(hidden)
 
@@ -23,45 +25,123 @@ struct fastLinkParser
     fastLinkParser( iterator _begin, iterator _end )
         : m_begin( _begin )
         , m_end( _end )
-        , m_abort( false )
     {
     }
 
     /**@brief Parses the file
      * @return The number of links parsed
-     * @param[in] allLinks_ A container that will be filled with the links */
-    nb_of_lines start( linkset & allLinks_ ) TATO_NO_THROW;
+     * @param[in] allLinks_ A container that will be filled with the links,
+     *            unless the parsing is cancelled
+     * @param[in] _monitor Tells when to stop, and where to report the progress */
+    nb_of_lines start( linkset & allLinks_, const parseMonitor & _monitor = parseMonitor() ) TATO_NO_THROW;
+
+    /**@brief Parses the buffer and appends the links to a container, without
+     *        clearing what it already contains.
+     * @param[in,out] line_ The number of the first line of the buffer in its
+     *        file, advanced past the lines parsed
+     * @return The number of links parsed
+     * @throw std::bad_alloc */
+    nb_of_lines feed( linkset & allLinks_, size_t & line_ );
+
+    /**@brief Counts the lines in the file
+     * @param[in] _nbThreads How many threads can count at the same time */
+    nb_of_lines countLines( unsigned _nbThreads = 1 ) const;
 
-    /**@brief Counts the lines in the file */
-    nb_of_lines countLines() const;
+    /**@brief Estimates the number of lines in the file, without reading all of it
+     * @return An upper bound of the number of lines, in all but rare cases */
+    nb_of_lines countLinesFast() const;
 
-    /**@brief Cancels a parsing operation */
-    void abort() { m_abort = true; }
+    /**@brief Reads the first id of the last line, which is the highest one as
+     *        links.csv is sorted by its first column.
+     * @return The id, or sentence::INVALID_ID if the buffer is empty */
+    sentence::id getLastFirstId() const;
 
 private:
     iterator m_begin, m_end;
-    volatile bool m_abort;
 };
 
 // -------------------------------------------------------------------------- //
 
 template<typename iterator> inline
 typename fastLinkParser<iterator>::nb_of_lines
-fastLinkParser<iterator>::countLines() const
+fastLinkParser<iterator>::countLines( unsigned _nbThreads ) const
+{
+    return static_cast<nb_of_lines>( countLinesParallel( m_begin, m_end, _nbThreads ) );
+}
+
+// -------------------------------------------------------------------------- //
+
+template<typename iterator> inline
+typename fastLinkParser<iterator>::nb_of_lines
+fastLinkParser<iterator>::countLinesFast() const
+{
+    return static_cast<nb_of_lines>( estimateLines( m_begin, m_end ) );
+}
+
+// -------------------------------------------------------------------------- //
+
+template<typename iterator> inline
+sentence::id fastLinkParser<iterator>::getLastFirstId() const
+{
+    iterator lineEnd = m_end;
+    while( lineEnd != m_begin && *( lineEnd - 1 ) == '\n' )
+        --lineEnd;
+
+    iterator lineBegin = lineEnd;
+    while( lineBegin != m_begin && *( lineBegin - 1 ) != '\n' )
+        --lineBegin;
+
+    sentence::id id = 0;
+    for( ; lineBegin != lineEnd && *lineBegin >= '0' && *lineBegin <= '9'; ++lineBegin )
+        id = 10 * id + static_cast<sentence::id>( *lineBegin - '0' );
+
+    return id;
+}
+
+// -------------------------------------------------------------------------- //
+
+template<typename iterator>
+typename fastLinkParser<iterator>::nb_of_lines
+fastLinkParser<iterator>::start( linkset & TATO_RESTRICT allLinks_, const parseMonitor & _monitor ) TATO_NO_THROW
 {
-    return std::count( m_begin, m_end, '\n' );
+    linkset temporaryLinkContainer;
+    nb_of_lines nbLinks = 0;
+
+    // an empty linkset only holds the memory reserved by allocate(): the
+    // temporary container takes it over
+    if( allLinks_.size() == 0 )
+        temporaryLinkContainer = std::move( allLinks_ );
+
+    try
+    {
+        nbLinks = static_cast<nb_of_lines>( feedByChunks< fastLinkParser<iterator> >( m_begin, m_end, temporaryLinkContainer, _monitor ) );
+    }
+    catch ( std::bad_alloc & )
+    {
+        llog::error << "Not enough memory.\n";
+        return 0;
+    }
+
+    // if no error occurred, we swap containers
+    if ( !_monitor.isCancelled() )
+    {
+        allLinks_ = std::move( temporaryLinkContainer );
+    }
+
+    llog::info << "parsed " << nbLinks << " links.\n";
+
+    return nbLinks;
 }
 
 // -------------------------------------------------------------------------- //
 
 template<typename iterator>
 typename fastLinkParser<iterator>::nb_of_lines
-fastLinkParser<iterator>::start( linkset & TATO_RESTRICT allLinks_ ) TATO_NO_THROW
+fastLinkParser<iterator>::feed( linkset & TATO_RESTRICT allLinks_, size_t & line_ )
 {
     nb_of_lines nbLinks = 0;
     register iterator ptr = m_begin;
     iterator ptrEnd = m_end;
-    linkset temporaryLinkContainer;
 
     if( ptr == nullptr || ptr == ptrEnd )
         return 0;
@@ -69,7 +149,7 @@ fastLinkParser<iterator>::start( linkset & TATO_RESTRICT allLinks_ ) TATO_NO_THR
     sentence::id firstId = 0;
     sentence::id id = 0;
 
-    for (register char c; ptr != ptrEnd && !m_abort;)
+    for (register char c; ptr != ptrEnd;)
     {
         c = *ptr++;
 
@@ -92,30 +172,16 @@ fastLinkParser<iterator>::start( linkset & TATO_RESTRICT allLinks_ ) TATO_NO_THR
             }
             else if( c == '\n' )
             {
-                try
-                {
-                    temporaryLinkContainer.addLink( firstId, id );
-                    ++nbLinks;
-                }
-                catch ( std::bad_alloc & )
-                {
-                    llog::error << "Not enough memory.\n";
-                    break;
-                }
+                allLinks_.addLink( firstId, id );
+                ++nbLinks;
             }
 
             id = 0;
         }
     }
 
-    // if no error occurred, we swap containers
-    if ( ptrEnd == ptr )
-    {
-        allLinks_ = std::move( temporaryLinkContainer );
-    }
-
-    llog::info << "parsed " << nbLinks << " links.\n";
-
+    // each line holds a link
+    line_ += nbLinks;
     return nbLinks;
 }
 
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include "tatoparser/namespace.h"
+#include "parse_monitor.h"
 
 #pragma GCC visibility push(hidden)
 
@@ -21,24 +22,30 @@ struct fastListParser
     fastListParser( iterator _begin, iterator _end )
         : m_begin( _begin )
         , m_end( _end )
-        , m_abort( false )
     {
     }
 
     /**@brief Parses the file
      * @return The number of lists parsed
-     * @param[in] allLists A container that will be filled with the links */
-    size_t start( listset & allLinks_ ) TATO_NO_THROW;
+     * @param[in] allLists A container that will be filled with the links,
+     *            unless the parsing is cancelled
+     * @param[in] _monitor Tells when to stop, and where to report the progress
+     * @param[in] _nbThreads How many threads can parse parts of the buffer */
+    size_t start( listset & allLinks_, const parseMonitor & _monitor = parseMonitor(), unsigned _nbThreads = 1 ) TATO_NO_THROW;
+
+    /**@brief Parses the buffer and appends the lists to a container, without
+     *        clearing what it already contains.
+     * @param[in,out] line_ The number of the first line of the buffer in its
+     *        file, advanced past the lines parsed
+     * @return The number of lines parsed
+     * @throw std::bad_alloc */
+    size_t feed( listset & allLists_, size_t & line_ );
 
     /**@brief Counts the lines in the file */
     size_t countLines() const;
 
-    /**@brief Cancels a parsing operation */
-    void abort() { m_abort = true; }
-
 private:
     iterator m_begin, m_end;
-    volatile bool m_abort;
 };
 
 // -------------------------------------------------------------------------- //
@@ -52,59 +59,72 @@ size_t fastListParser<iterator>::countLines() const
 // -------------------------------------------------------------------------- //
 
 template<typename iterator>
-size_t fastListParser<iterator>::start( listset & TATO_RESTRICT allLists_ ) TATO_NO_THROW
+size_t fastListParser<iterator>::start( listset & TATO_RESTRICT allLists_, const parseMonitor & _monitor, unsigned _nbThreads ) TATO_NO_THROW
 {
     llog::info << "parsing lists.csv\n";
 
     size_t lineCount = 0;
-    bool parsingId = true;
     listset temporaryListContainer;
 
-    sentence::id current_id = 0;
-    iterator current_pos, name_begin;
-    char c;
-
-    for( current_pos = m_begin; current_pos != m_end && !m_abort; ++current_pos )
+    try
     {
-        c = *current_pos;
-        if( ( c != '\t' ) && ( c != '\n' ) )
-        {
-            if( parsingId )
-                current_id = 10 * current_id + static_cast<sentence::id>( c - '0' );
-        }
-        else if( c == '\t' )
-        {
-            assert( parsingId );
-            parsingId = false;
-            name_begin = current_pos+1;
-        }
-        else if( c == '\n' )
-        {
-            assert( !parsingId );
-            *current_pos = '\0';
-            try
-            {
-                temporaryListContainer.addSentenceToList( current_id, std::string( name_begin, current_pos ) );
-                ++lineCount;
-            }
-            catch( std::bad_alloc & )
-            {
-                llog::error << "Out of memory\n";
-                break;
-            }
-            current_id = 0;
-            parsingId = true;
-        }
+        lineCount = feedInParallel< fastListParser<iterator> >( m_begin, m_end, temporaryListContainer, _monitor, _nbThreads );
+    }
+    catch( std::bad_alloc & )
+    {
+        llog::error << "Out of memory\n";
+        return 0;
     }
 
     // if no error occurred, we switch containers
-    if ( current_pos == m_end )
+    if ( !_monitor.isCancelled() )
         allLists_ = std::move( temporaryListContainer );
 
     llog::info << "parsed " << lineCount << " lines.\n";
     return lineCount;
 }
 
+// -------------------------------------------------------------------------- //
+
+template<typename iterator>
+size_t fastListParser<iterator>::feed( listset & TATO_RESTRICT allLists_, size_t & line_ )
+{
+    size_t lineCount = 0;
+
+    for( iterator cursor = m_begin; cursor != m_end; )
+    {
+        // parsing the sentence id
+        sentence::id current_id = 0;
+        while( cursor != m_end && *cursor != '\t' && *cursor != '\n' )
+            current_id = 10 * current_id + static_cast<sentence::id>( *cursor++ - '0' );
+
+        if( cursor == m_end )
+            break;
+
+        // a line without a list name is skipped
+        if( *cursor == '\n' )
+        {
+            ++cursor;
+            ++line_;
+            continue;
+        }
+
+        // the name of the list runs to the end of the line, and the last line
+        // counts only if it ends with a '\n'
+        const iterator name_begin = ++cursor;
+        cursor = std::find( cursor, m_end, '\n' );
+        if( cursor == m_end )
+            break;
+
+        allLists_.addSentenceToList( current_id, name_begin, cursor );
+        ++lineCount;
+        ++line_;
+        ++cursor;
+    }
+
+    return lineCount;
+}
+
 NAMESPACE_END
 
 #pragma GCC visibility pop
@@ -3,13 +3,15 @@
 
 #include <boost/spirit/include/qi.hpp>
 #include "tatoparser/namespace.h"
+#include "line_counter.h"
+#include "parse_monitor.h"
 
 #pragma GCC visibility push(hidden)
 
 NAMESPACE_START
 
 /**@brief Parses the sentences_detailed .csv out of a buffer
- * @tparam iterator An input/output iterator to read and write into the buffer
+ * @tparam iterator An input iterator to read the buffer
  * @struct fastDetailedParser */
 template<typename iterator>
 struct fastDetailedParser
@@ -20,23 +22,31 @@ struct fastDetailedParser
     fastDetailedParser( iterator _begin, iterator _end );
 
     /**@brief Start parsing the buffer and fill up a dataset with the sentences
+      *@param[in] _monitor Tells when to stop, and where to report the progress
       *@return The number of sentences parsed. */
-    size_t          start( dataset & _data ) TATO_NO_THROW;
+    size_t          start( dataset & _data, const parseMonitor & _monitor = parseMonitor() ) TATO_NO_THROW;
+
+    /**@brief Parses the buffer and appends the sentences to a dataset, without
+      *       clearing what it already contains.
+      *@param[in,out] line_ The number of the first line of the buffer in its
+      *       file, which the warnings refer to, advanced past the lines parsed
+      *@return The number of sentences parsed.
+      *@throw std::bad_alloc */
+    size_t          feed( dataset & data_, size_t & line_ );
 
     /**@brief Returns the number of lines in the buffer
+      *@param[in] _nbThreads How many threads can count at the same time
       *@warning If some lines are fucked up in the file, the number of sentences
       *         will be inferior to the number of lines. */
-    size_t          countLines() const;
+    size_t          countLines( unsigned _nbThreads = 1 ) const;
 
-    /**@brief Estimate the number of lines in the buffer*/
+    /**@brief Estimate the number of lines in the buffer, without reading all of it
+      *@return An upper bound of the number of lines, in all but rare cases */
     size_t          countLinesFast() const;
 
-    /**@brief Cancels a parsing operation */
-    void abort() { m_abort = true; }
 
 private:
     iterator m_begin, m_end;
-    volatile bool m_abort;
 };
 
 // -------------------------------------------------------------------------- //
@@ -44,18 +54,43 @@ template<typename iterator>
 fastDetailedParser<iterator>::fastDetailedParser( iterator _begin, iterator _end )
     :m_begin( _begin )
     ,m_end( _end )
-    ,m_abort( false )
 {
 }
 
 // -------------------------------------------------------------------------- //
 template<typename iterator>
-size_t fastDetailedParser<iterator>::start( dataset & _data ) TATO_NO_THROW
+size_t fastDetailedParser<iterator>::start( dataset & _data, const parseMonitor & _monitor ) TATO_NO_THROW
+{
+    dataset temporarySentenceContainer;
+    size_t nbSentences = 0;
+
+    // an empty dataset only holds the memory reserved by allocate(): the
+    // temporary container takes it over
+    if( _data.size() == 0 )
+        temporarySentenceContainer = std::move( _data );
+
+    try
+    {
+        nbSentences = feedByChunks< fastDetailedParser<iterator> >( m_begin, m_end, temporarySentenceContainer, _monitor );
+    }
+    catch( const std::bad_alloc & )
+    {
+        llog::error << "Not enough memory.\n";
+        return 0;
+    }
+
+    _data = std::move( temporarySentenceContainer );
+
+    return nbSentences;
+}
+
+// -------------------------------------------------------------------------- //
+template<typename iterator>
+size_t fastDetailedParser<iterator>::feed( dataset & data_, size_t & line_ )
 {
     namespace qi = boost::spirit::qi;
 
     size_t nbSentences = 0;
-    size_t line = 1;
 
     // memory to parse
     auto begin = m_begin;
@@ -69,10 +104,7 @@ size_t fastDetailedParser<iterator>::start( dataset & _data ) TATO_NO_THROW
     boost::iterator_range<iterator> creationDateRange;
     boost::iterator_range<iterator> lastModifiedDateRange;
 
-    dataset temporarySentenceContainer;
-    bool parsingFailed = false;
-
-    while( !m_abort )
+    for( ;; )
     {
         if( qi::parse( begin, end, (
             // grammar for a single line of CSV
@@ -96,28 +128,13 @@ size_t fastDetailedParser<iterator>::start( dataset & _data ) TATO_NO_THROW
         ), id, langRange, sentenceRange, authorRange,
         creationDateRange, lastModifiedDateRange ) )
         {
-            // ok, we managed to parse a sentence.
-            // change separators into string endings
-            *( langRange.end() ) = '\0';
-            *( sentenceRange.end() ) = '\0';
-            *( authorRange.end() ) = '\0';
-            *( creationDateRange.end() ) = '\0';
-            *( lastModifiedDateRange.end() ) = '\0';
-
-            try
-            {
-                temporarySentenceContainer.addSentence(
-                    id, langRange.begin(), sentenceRange.begin(),
-                    authorRange.begin(), creationDateRange.begin(),
-                    lastModifiedDateRange.begin()
-                );
-            }
-            catch( const std::bad_alloc & )
-            {
-                llog::error << "Not enough memory.\n";
-                parsingFailed = true;
-                break;
-            }
+            // ok, we managed to parse a sentence. the buffer is left untouched,
+            // the sentence only remembers where its fields are
+            data_.addSentence(
+                id, textSlice( langRange ), textSlice( sentenceRange ),
+                textSlice( authorRange ), textSlice( creationDateRange ),
+                textSlice( lastModifiedDateRange )
+            );
 
             nbSentences++;
         }
@@ -125,7 +142,7 @@ size_t fastDetailedParser<iterator>::start( dataset & _data ) TATO_NO_THROW
         {
             // we failed at parsing the sentence, and we're not at the end of
             // the file yet
-            llog::warning << "Failed to parse sentence from line " << line << std::endl;
+            llog::warning << "Failed to parse sentence from line " << line_ << std::endl;
 
             // skip over the nearest \n and try again.
             while ( ++begin != end && *begin != '\n' );
@@ -139,22 +156,18 @@ size_t fastDetailedParser<iterator>::start( dataset & _data ) TATO_NO_THROW
             break;
         }
 
-        line++;
+        line_++;
     }
 
-    if( !parsingFailed )
-        _data = std::move( temporarySentenceContainer );
-
     return nbSentences;
 }
 
 // -------------------------------------------------------------------------- //
 
 template<typename iterator>
-size_t fastDetailedParser<iterator>::countLines() const
+size_t fastDetailedParser<iterator>::countLines( unsigned _nbThreads ) const
 {
-    const size_t nbSentences =
-        std::count( m_begin, m_end, '\n' );
+    const size_t nbSentences = countLinesParallel( m_begin, m_end, _nbThreads );
     llog::info << "number of sentences: " << nbSentences << '\n';
     return nbSentences;
 }
@@ -164,11 +177,9 @@ size_t fastDetailedParser<iterator>::countLines() const
 template<typename iterator>
 size_t fastDetailedParser<iterator>::countLinesFast() const
 {
-    const size_t nbChars =
-        reinterpret_cast<size_t>( &*m_end ) - reinterpret_cast<size_t>( &*m_begin );
-    static const size_t AVERAGE_NB_BYTES_PER_SENTENCE = 100;
-    llog::info << "estimated number of sentences: " << nbChars / AVERAGE_NB_BYTES_PER_SENTENCE << '\n';
-    return nbChars / AVERAGE_NB_BYTES_PER_SENTENCE;
+    const size_t nbSentences = estimateLines( m_begin, m_end );
+    llog::info << "estimated number of sentences: " << nbSentences << '\n';
+    return nbSentences;
 }
 
 NAMESPACE_END
@@ -5,6 +5,8 @@
 #include <boost/spirit/include/qi.hpp>
 
 #include "tatoparser/namespace.h"
+#include "line_counter.h"
+#include "parse_monitor.h"
 #include "tatoparser/dataset.h"
 
 #pragma GCC visibility push(hidden)
@@ -12,7 +14,7 @@
 NAMESPACE_START
 
 /**@brief Parses the sentences out of a buffer
- * @tparam iterator An input/output iterator to read and write into the buffer
+ * @tparam iterator An input iterator to read the buffer
  * @struct fastSentenceParser */
 template<typename iterator>
 struct fastSentenceParser
@@ -23,23 +25,31 @@ struct fastSentenceParser
     fastSentenceParser( iterator _begin, iterator _end );
 
     /**@brief Start parsing the buffer and fill up a dataset with the sentences
+      *@param[in] _monitor Tells when to stop, and where to report the progress
       *@return The number of sentences parsed. */
-    size_t          start( dataset & _data ) TATO_NO_THROW;
+    size_t          start( dataset & _data, const parseMonitor & _monitor = parseMonitor() ) TATO_NO_THROW;
+
+    /**@brief Parses the buffer and appends the sentences to a dataset, without
+      *       clearing what it already contains.
+      *@param[in,out] line_ The number of the first line of the buffer in its
+      *       file, which the warnings refer to, advanced past the lines parsed
+      *@return The number of sentences parsed.
+      *@throw std::bad_alloc */
+    size_t          feed( dataset & data_, size_t & line_ );
 
     /**@brief Returns the number of lines in the buffer
+      *@param[in] _nbThreads How many threads can count at the same time
       *@warning If some lines are fucked up in the file, the number of sentences
       *         will be inferior to the number of lines. */
-    size_t          countLines() const;
+    size_t          countLines( unsigned _nbThreads = 1 ) const;
 
-    /**@brief Estimate the number of lines in the buffer*/
+    /**@brief Estimate the number of lines in the buffer, without reading all of it
+      *@return An upper bound of the number of lines, in all but rare cases */
     size_t          countLinesFast() const;
 
-    /**@brief Cancels a parsing operation */
-    void abort() { m_abort = true; }
 
 private:
     iterator m_begin, m_end;
-    bool    m_abort;
 };
 
 // -------------------------------------------------------------------------- //
@@ -48,17 +58,15 @@ template<typename iterator>
 fastSentenceParser<iterator>::fastSentenceParser( iterator _begin, iterator _end )
     :m_begin( _begin )
     ,m_end( _end )
-    ,m_abort( false )
 {
 }
 
 // -------------------------------------------------------------------------- //
 
 template<typename iterator>
-size_t fastSentenceParser<iterator>::countLines() const
+size_t fastSentenceParser<iterator>::countLines( unsigned _nbThreads ) const
 {
-    const size_t nbSentences =
-        std::count( m_begin, m_end, '\n' );
+    const size_t nbSentences = countLinesParallel( m_begin, m_end, _nbThreads );
     llog::info << "number of sentences: " << nbSentences << '\n';
     return nbSentences;
 }
@@ -68,24 +76,48 @@ size_t fastSentenceParser<iterator>::countLines() const
 template<typename iterator>
 size_t fastSentenceParser<iterator>::countLinesFast() const
 {
-    const size_t nbChars =
-        reinterpret_cast<size_t>( &*m_end ) - reinterpret_cast<size_t>( &*m_begin );
-    static const size_t AVERAGE_NB_BYTES_PER_SENTENCE = 56;
-    llog::info << "estimated number of sentences: " << nbChars / AVERAGE_NB_BYTES_PER_SENTENCE << '\n';
-    return nbChars / AVERAGE_NB_BYTES_PER_SENTENCE;
+    const size_t nbSentences = estimateLines( m_begin, m_end );
+    llog::info << "estimated number of sentences: " << nbSentences << '\n';
+    return nbSentences;
 }
 
 
 // -------------------------------------------------------------------------- //
 
 template<typename iterator>
-size_t fastSentenceParser<iterator>::start( dataset & TATO_RESTRICT _data ) TATO_NO_THROW
+size_t fastSentenceParser<iterator>::start( dataset & TATO_RESTRICT _data, const parseMonitor & _monitor ) TATO_NO_THROW
+{
+    dataset temporarySentenceContainer;
+    size_t nbSentences = 0;
+
+    // an empty dataset only holds the memory reserved by allocate(): the
+    // temporary container takes it over
+    if( _data.size() == 0 )
+        temporarySentenceContainer = std::move( _data );
+
+    try
+    {
+        nbSentences = feedByChunks< fastSentenceParser<iterator> >( m_begin, m_end, temporarySentenceContainer, _monitor );
+    }
+    catch( const std::bad_alloc & )
+    {
+        llog::error << "Not enough memory.\n";
+        return 0;
+    }
+
+    _data = std::move( temporarySentenceContainer );
+
+    return nbSentences;
+}
+
+// -------------------------------------------------------------------------- //
+
+template<typename iterator>
+size_t fastSentenceParser<iterator>::feed( dataset & TATO_RESTRICT data_, size_t & line_ )
 {
     namespace qi = boost::spirit::qi;
-    bool parsingFailed = false;
 
     size_t nbSentences = 0;
-    size_t line = 1;
 
     // memory to parse
     auto begin = m_begin;
@@ -96,9 +128,7 @@ size_t fastSentenceParser<iterator>::start( dataset & TATO_RESTRICT _data ) TATO
     boost::iterator_range<iterator> langRange;
     boost::iterator_range<iterator> sentenceRange;
 
-    dataset temporarySentenceContainer;
-
-    while( !m_abort )
+    for( ;; )
     {
         // try to parse a sentence... (note: it will simply fail when at the
         // end of file)
@@ -114,28 +144,16 @@ size_t fastSentenceParser<iterator>::start( dataset & TATO_RESTRICT _data ) TATO
             qi::raw[+~qi::char_( '\n' )] >> '\n'
         ), id, langRange, sentenceRange ) )
         {
-            // ok, we managed to parse a sentence.
-            // change separators into string endings
-            *( langRange.end() ) = '\0';
-            *( sentenceRange.end() ) = '\0';
-
-            try
-            {
-                temporarySentenceContainer.addSentence( id, langRange.begin(), sentenceRange.begin() );
-                nbSentences++;
-            }
-            catch( const std::bad_alloc & )
-            {
-                llog::error << "Not enough memory.\n";
-                parsingFailed = true;
-                break;
-            }
+            // ok, we managed to parse a sentence. the buffer is left untouched,
+            // the sentence only remembers where its fields are
+            data_.addSentence( id, textSlice( langRange ), textSlice( sentenceRange ) );
+            nbSentences++;
         }
         else if( begin != end )
         {
             // we failed at parsing the sentence, and we're not at the end of
             // the file yet
-            llog::warning << "Failed to parse sentence from line " << line << std::endl;
+            llog::warning << "Failed to parse sentence from line " << line_ << std::endl;
 
             // skip over the nearest \n and try again.
             while ( ++begin != end && *begin != '\n' );
@@ -150,12 +168,9 @@ size_t fastSentenceParser<iterator>::start( dataset & TATO_RESTRICT _data ) TATO
             break;
         }
 
-        line++;
+        line_++;
     }
 
-    if( !parsingFailed )
-        _data = std::move( temporarySentenceContainer );
-
     return nbSentences;
 }
 
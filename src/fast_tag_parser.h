@@ -2,6 +2,7 @@
 #define LIBTATOPARSER_FAST_TAG_PARSER_H
 
 #include "tatoparser/tagset.h"
+#include "parse_monitor.h"
 
 #pragma GCC visibility push(hidden)
 
@@ -13,19 +14,26 @@ struct fastTagParser
     fastTagParser( iterator _begin, iterator _end )
         :m_begin( _begin )
         ,m_end( _end )
-        ,m_abort( false )
     {
     }
 
-    int start( tagset & _tagset ) TATO_NO_THROW;
+    /**@brief Parses the buffer and fills a container with the tags, unless
+     *        the parsing is cancelled
+     * @param[in] _monitor Tells when to stop, and where to report the progress
+     * @param[in] _nbThreads How many threads can parse parts of the buffer */
+    int start( tagset & _tagset, const parseMonitor & _monitor = parseMonitor(), unsigned _nbThreads = 1 ) TATO_NO_THROW;
+
+    /**@brief Parses the buffer and appends the tags to a container, without
+     *        clearing what it already contains.
+     * @param[in,out] line_ The number of the first line of the buffer in its
+     *        file, advanced past the lines parsed
+     * @return The number of tags parsed
+     * @throw std::bad_alloc */
+    size_t feed( tagset & tagset_, size_t & line_ );
     size_t countTags();
 
-    /**@brief Cancels a parsing operation */
-    void abort() { m_abort = true; }
-
 private:
     iterator m_begin, m_end;
-    bool m_abort;
 };
 
 // -------------------------------------------------------------------------- //
@@ -40,56 +48,71 @@ size_t fastTagParser<iterator>::countTags()
 
 
 template<typename iterator>
-int fastTagParser<iterator>::start( tagset & TATO_RESTRICT _tagset ) TATO_NO_THROW
+int fastTagParser<iterator>::start( tagset & TATO_RESTRICT _tagset, const parseMonitor & _monitor, unsigned _nbThreads ) TATO_NO_THROW
+{
+    tagset temporaryTagContainer;
+
+    try
+    {
+        feedInParallel< fastTagParser<iterator> >( m_begin, m_end, temporaryTagContainer, _monitor, _nbThreads );
+    }
+    catch( const std::bad_alloc & )
+    {
+        llog::error << "Out of memory.\n";
+        return 0;
+    }
+
+    if( !_monitor.isCancelled() )
+        _tagset = std::move( temporaryTagContainer );
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+template<typename iterator>
+size_t fastTagParser<iterator>::feed( tagset & TATO_RESTRICT tagset_, size_t & line_ )
 {
     register iterator cursor = m_begin;
     register iterator const end = m_end;
 
     sentence::id sentenceId = sentence::INVALID_ID;
-    tagset temporaryTagContainer;
+    size_t nbTags = 0;
 
-    for ( char * tagName = nullptr; cursor != end && !m_abort; )
+    for ( iterator tagName = nullptr; cursor != end; )
     {
         sentenceId = static_cast<sentence::id>( *cursor++ - '0' );
 
         // parsing the sentence id
-        while( *cursor != '\t' )
+        while( cursor != end && *cursor != '\t' )
         {
             assert( *cursor >= '0' && *cursor <= '9' );
             sentenceId = sentenceId * 10 + static_cast<sentence::id>( *cursor++ - '0' );
         }
 
         // skip '\t'
+        if( cursor == end )
+            break;
         ++cursor;
-        assert( cursor != end );
 
         // record character string for tag name
         tagName = cursor;
 
-        // skip to the end of the string
-        while ( ++cursor != end && *cursor != '\n' );
-
-        assert( cursor < end );
+        // skip to the end of the line, the last one may not have a '\n'
+        while ( cursor != end && *cursor != '\n' )
+            ++cursor;
 
-        // replace the new line character with a NULL character to have a C string
-        *cursor++ = '\0';
+        // add an entry, the name being lowered as it is looked up
+        tagset_.tagSentence( sentenceId, tagName, cursor );
+        ++nbTags;
 
-        // add an entry
-        try
-        {
-            temporaryTagContainer.tagSentence( sentenceId, tagName );
-        }
-        catch( const std::bad_alloc & )
-        {
-            llog::error << "Out of memory.\n";
-            break;
-        }
+        if( cursor != end )
+            ++cursor;
     }
 
-    if( cursor == end )
-        _tagset = std::move( temporaryTagContainer );
-
-    return 0;
+    // each line holds a tag
+    line_ += nbTags;
+    return nbTags;
 }
 
 NAMESPACE_END
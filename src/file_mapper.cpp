@@ -16,68 +16,210 @@
 NAMESPACE_START
 
 #if HAVE_SYS_MMAN_H == 1
-fileMapper::fileMapper( const std::string & _filename, bool _rdOnly )
+
+// how far ahead of the parsers the kernel is asked to read
+static const size_t READAHEAD_WINDOW = 32 * 1024 * 1024;
+
+// -------------------------------------------------------------------------- //
+
+static
+size_t getPageSize()
+{
+    const long pageSize = sysconf( _SC_PAGESIZE );
+    return pageSize > 0 ? static_cast<size_t>( pageSize ) : 4096;
+}
+
+// -------------------------------------------------------------------------- //
+
+// madvise() wants a page-aligned address
+static
+void adviseRange( const char * _begin, size_t _size, int _advice )
+{
+    const size_t pageSize = getPageSize();
+    const uintptr_t address = reinterpret_cast<uintptr_t>( _begin );
+    const uintptr_t alignedAddress = address & ~( static_cast<uintptr_t>( pageSize ) - 1 );
+
+    if( _size == 0 )
+        return;
+
+    if( madvise( reinterpret_cast<void *>( alignedAddress ), _size + ( address - alignedAddress ), _advice ) != 0 )
+        llog::info << "madvise( " << _advice << " ) failed on " << static_cast<const void *>( _begin ) << '\n';
+}
+
+// -------------------------------------------------------------------------- //
+
+fileMapper::fileMapper( const std::string & _filename, accessPattern _pattern, mappingFlag _flags )
     :m_size( 0 )
     ,m_region( nullptr )
+    ,m_readahead()
+    ,m_stopReadahead( false )
 {
-    const int fileDescriptor
-        = open( _filename.c_str(), _rdOnly ? O_RDONLY : O_RDWR );
+    // the parsers never write into the buffer, so the file can be opened
+    // read-only, by users who cannot write to it too
+    const int fileDescriptor = open( _filename.c_str(), O_RDONLY );
+
+    if( fileDescriptor == -1 )
+        throw invalid_file( _filename );
+
+    // getting the file size
+    struct stat st;
+    const int ret = fstat( fileDescriptor, &st );
 
-    if( fileDescriptor != 0 )
+    if( ret == -1 )
     {
-        // getting the file size
-        struct stat st;
-        const int ret = fstat( fileDescriptor, &st );
-
-        if( ret == -1 )
-            throw invalid_file( _filename );
-
-        m_size = static_cast<size_t>( st.st_size );
-
-        // size is given in off_t but mmap takes size_t
-        // so if size_t is smaller, there is a chance that only
-        // the first part of the file is mapped.
-        if ( static_cast<uint64_t>( st.st_size ) != static_cast<uint64_t>( m_size ) )
-            throw map_failed();
-
-        // map the region
-        m_region =
-            static_cast<char *>(
-                mmap(
-                    nullptr, m_size,
-                    _rdOnly ? PROT_READ : PROT_READ | PROT_WRITE,
-                    MAP_PRIVATE, fileDescriptor, 0
-                )
-            );
-
-        if( m_region == reinterpret_cast<void *>( -1 ) )
-            throw map_failed();
-
-        llog::info << "mapped " << _filename << " to " << static_cast<void *>( m_region ) << std::endl;
-    }
-    else
+        close( fileDescriptor );
         throw invalid_file( _filename );
+    }
+
+    m_size = static_cast<size_t>( st.st_size );
+
+    // size is given in off_t but mmap takes size_t
+    // so if size_t is smaller, there is a chance that only
+    // the first part of the file is mapped.
+    if ( static_cast<uint64_t>( st.st_size ) != static_cast<uint64_t>( m_size ) )
+    {
+        close( fileDescriptor );
+        throw map_failed();
+    }
+
+    // map the region. a shared read-only mapping points straight to the page
+    // cache: no page is ever copied, and processes mapping the same file
+    // share the same memory.
+    int mapFlags = MAP_SHARED;
+#   ifdef MAP_POPULATE
+    if( _flags & MAPPING_POPULATE )
+        mapFlags |= MAP_POPULATE;
+#   endif
+
+    void * const region =
+        mmap(
+            nullptr, m_size,
+            PROT_READ,
+            mapFlags, fileDescriptor, 0
+        );
+
+    // the mapping holds its own reference to the file
+    close( fileDescriptor );
+
+    if( region == MAP_FAILED )
+        throw map_failed();
+
+    m_region = static_cast<const char *>( region );
+
+    llog::info << "mapped " << _filename << " to " << static_cast<const void *>( m_region ) << std::endl;
+
+#   ifdef MADV_HUGEPAGE
+    // only taken into account if the kernel can back files with huge pages,
+    // ignored otherwise
+    if( _flags & MAPPING_LONG_LIVED )
+        adviseRange( m_region, m_size, MADV_HUGEPAGE );
+#   endif
+
+    advise( _pattern );
 }
 
 // -------------------------------------------------------------------------- //
 
 fileMapper::~fileMapper() TATO_NO_THROW
 {
+    stopReadahead();
+
     // unmap the region if it was mapped
     if( m_region )
     {
-        munmap( m_region, m_size );
-        llog::info << "unmapped region " << static_cast<void *>( m_region ) << std::endl;
+        munmap( const_cast<char *>( m_region ), m_size );
+        llog::info << "unmapped region " << static_cast<const void *>( m_region ) << std::endl;
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+void fileMapper::advise( accessPattern _pattern )
+{
+    switch( _pattern )
+    {
+        case NORMAL_ACCESS:
+            adviseRange( m_region, m_size, MADV_NORMAL );
+            break;
+
+        case SEQUENTIAL_ACCESS:
+            // the kernel reads ahead more aggressively, and starts reading
+            // the beginning of the file right now
+            adviseRange( m_region, m_size, MADV_SEQUENTIAL );
+            adviseRange( m_region, std::min( m_size, READAHEAD_WINDOW ), MADV_WILLNEED );
+            break;
+
+        case RANDOM_ACCESS:
+            adviseRange( m_region, m_size, MADV_RANDOM );
+            break;
     }
 }
 
 // -------------------------------------------------------------------------- //
 
+void fileMapper::startReadahead( unsigned _nbStreams )
+{
+    stopReadahead();
+
+    if( _nbStreams == 0 || m_size == 0 )
+        return;
+
+    m_stopReadahead = false;
+    m_readahead = std::thread( &fileMapper::readahead, this, _nbStreams );
+}
+
+// -------------------------------------------------------------------------- //
+
+void fileMapper::stopReadahead()
+{
+    if( m_readahead.joinable() )
+    {
+        m_stopReadahead = true;
+        m_readahead.join();
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+void fileMapper::readahead( unsigned _nbStreams )
+{
+    const size_t pageSize = getPageSize();
+    const size_t streamSize = ( m_size + _nbStreams - 1 ) / _nbStreams;
+
+    // the thread moves window after window in each part of the mapping, in
+    // turns, so that every parser finds its pages already there. While a
+    // window is faulted in, the kernel is asked to read the next one.
+    volatile char sink = 0;
+    for( size_t offset = 0; offset < streamSize && !m_stopReadahead; offset += READAHEAD_WINDOW )
+    {
+        for( unsigned stream = 0; stream < _nbStreams && !m_stopReadahead; ++stream )
+        {
+            const size_t begin = stream * streamSize + offset;
+            if( begin >= m_size )
+                continue;
+
+            const size_t end = std::min( { begin + READAHEAD_WINDOW, ( stream + 1 ) * streamSize, m_size } );
+
+            if( end < m_size )
+                adviseRange( m_region + end, std::min( READAHEAD_WINDOW, m_size - end ), MADV_WILLNEED );
+
+            for( size_t page = begin; page < end && !m_stopReadahead; page += pageSize )
+                sink = m_region[page];
+        }
+    }
+
+    ( void ) sink;
+}
+
+// -------------------------------------------------------------------------- //
+
 #else // HAVE_SYS_MMAN_H
 
-fileMapper::fileMapper( const std::string & _filename, bool /* _rdOnly */ )
+fileMapper::fileMapper( const std::string & _filename, accessPattern, mappingFlag )
     :m_size( 0 )
     ,m_region( nullptr )
+    ,m_readahead()
+    ,m_stopReadahead( false )
 {
     // get the file size
     std::ifstream filestream(
@@ -129,6 +271,14 @@ fileMapper::~fileMapper() TATO_NO_THROW
 {
     delete [] m_region;
 }
+
+// -------------------------------------------------------------------------- //
+
+// the whole file is already in memory, there is nothing to read ahead
+void fileMapper::advise( accessPattern ) { }
+void fileMapper::startReadahead( unsigned ) { }
+void fileMapper::stopReadahead() { }
+void fileMapper::readahead( unsigned ) { }
 #endif // HAVE_SYS_MMAN_H
 
 NAMESPACE_END
@@ -2,7 +2,9 @@
 #define LIBTATOPARSER_FILE_MAPPER_H
 
 #include "tatoparser/namespace.h"
+#include <atomic>
 #include <string>
+#include <thread>
 
 #pragma GCC visibility push(hidden)
 
@@ -22,41 +24,82 @@ struct map_failed
 {
 };
 
+/**@brief How the content of a mapping is going to be read, so that the kernel
+ *        can schedule the disk reads accordingly */
+enum accessPattern
+{
+    NORMAL_ACCESS,      // nothing particular, the kernel default
+    SEQUENTIAL_ACCESS,  // read once from the beginning to the end, like a parser does
+    RANDOM_ACCESS       // looked up here and there
+};
+
+/**@brief Options that change how a file is mapped */
+typedef uint32_t mappingFlag;
+
+// reads the whole file when it is mapped, instead of faulting each page in
+// when it is first accessed
+static const mappingFlag MAPPING_POPULATE   = 1<<0;
+
+// the mapping is kept for as long as the data it contains, so it asks for
+// transparent huge pages to lower the TLB pressure
+static const mappingFlag MAPPING_LONG_LIVED = 1<<1;
+
 /**@struct fileMapper
- * @brief Maps a file to memory */
+ * @brief Maps a file to memory, read-only.
+ *
+ * The mapping is shared, so that several processes working on the same file
+ * use the same physical pages, which are the ones of the page cache. */
 struct fileMapper
 {
     /**@brief Constructs a fileMapper by setting up the mapping
+     * @param[in] _fileName The file to map
+     * @param[in] _pattern How the mapping is going to be read first
+     * @param[in] _flags A combination of MAPPING_* flags
      * @throw invalid_file If the file can’t be opened, map_failed if mapping
      * the file fails. */
     explicit
-    fileMapper( const std::string & _fileName, bool _rdOnly = false );
+    fileMapper( const std::string & _fileName,
+                accessPattern _pattern = SEQUENTIAL_ACCESS,
+                mappingFlag _flags = 0 );
 
     /**@brief Unset a mapping */
     ~fileMapper() TATO_NO_THROW;
 
-    /**@brief Returns a pointer to the first byte of the mapping */
-    char * getRegion()  { return m_region; }
+    /**@brief Tells the kernel that the mapping will now be read differently,
+     *        for instance once the parsing is over. */
+    void advise( accessPattern _pattern );
 
-    /**@brief Returns a const pointer to the first byte of the mapping */
+    /**@brief Starts a thread that faults the pages in ahead of the parsers
+     * @param[in] _nbStreams How many parsers read the mapping at the same time,
+     *            each one starting at the beginning of an equal part of it. */
+    void startReadahead( unsigned _nbStreams );
+
+    /**@brief Stops the readahead thread, if it is still running */
+    void stopReadahead();
+
+    /**@brief Returns a pointer to the first byte of the mapping */
     const char * getRegion() const { return m_region; }
 
     /**@brief Returns the size of the mapping in bytes */
     size_t getSize() const { return m_size; }
 
 public: // support for iterators
-    typedef char *          iterator;
+    typedef const char *    iterator;
     typedef const char *    const_iterator;
 
-    iterator        begin()         { return getRegion(); }
     const_iterator  begin() const   { return getRegion(); }
-
-    iterator        end()           { return getRegion() + getSize(); }
     const_iterator  end() const     { return getRegion() + getSize(); }
 
 private:
-    size_t m_size;
-    char * m_region;
+    // body of the readahead thread
+    void readahead( unsigned _nbStreams );
+
+private:
+    size_t              m_size;
+    const char *        m_region;
+
+    std::thread         m_readahead;
+    std::atomic<bool>   m_stopReadahead;
 
 private:
     fileMapper( const fileMapper & ) TATO_DELETE;
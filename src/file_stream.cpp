@@ -0,0 +1,653 @@
+#include "prec_library.h"
+#include "file_stream.h"
+#include "file_mapper.h"
+#include <condition_variable>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if HAVE_LINUX_IO_URING_H == 1
+#   include <linux/io_uring.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   include <sys/uio.h>
+#endif
+
+#if HAVE_LINUX_IO_URING_H == 1 && defined( __NR_io_uring_setup ) && defined( __NR_io_uring_enter )
+#   define TATO_USE_IO_URING
+#endif
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+// size of the blocks the file is read in
+static const size_t READ_BLOCK_SIZE = 8 * 1024 * 1024;
+
+// how many blocks are being read at the same time
+static const unsigned QUEUE_DEPTH = 4;
+
+// free space before each block, where the end of the line cut by the
+// previous block is copied
+static const size_t HEAD_ROOM = 64 * 1024;
+
+// the buffers are aligned on pages
+static const size_t BUFFER_ALIGNMENT = 4096;
+
+// -------------------------------------------------------------------------- //
+
+// reads _size bytes unless the end of the file is reached, and returns how
+// many were read, or -errno
+static
+ssize_t readFully( int _fileDescriptor, char * _out, size_t _size, uint64_t _offset )
+{
+    size_t total = 0;
+    while( total < _size )
+    {
+        const ssize_t ret = pread( _fileDescriptor, _out + total, _size - total, static_cast<off_t>( _offset + total ) );
+
+        if( ret == 0 )
+            break;
+
+        if( ret < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            return -errno;
+        }
+
+        total += static_cast<size_t>( ret );
+    }
+
+    return static_cast<ssize_t>( total );
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@struct blockReader
+ * @brief Reads blocks of a file asynchronously. Each read is identified by
+ *        a slot, lower than QUEUE_DEPTH, which is free again once waited for. */
+struct blockReader
+{
+    virtual ~blockReader() { }
+
+    /**@brief Returns the name of the reading method, for logs */
+    virtual const char * getName() const = 0;
+
+    /**@brief Starts reading _size bytes at _offset into _out */
+    virtual void submit( unsigned _slot, char * _out, size_t _size, uint64_t _offset ) = 0;
+
+    /**@brief Waits for a read to be over
+     * @return The number of bytes read, which is lower than requested only at
+     *         the end of the file
+     * @throw invalid_file */
+    virtual size_t wait( unsigned _slot ) = 0;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@struct preadReader
+ * @brief Reads blocks with pread() on a pool of threads */
+struct preadReader : public blockReader
+{
+    preadReader( int _fileDescriptor, const std::string & _filename )
+        :m_fileDescriptor( _fileDescriptor )
+        ,m_filename( _filename )
+        ,m_requests( QUEUE_DEPTH )
+        ,m_queue()
+        ,m_mutex()
+        ,m_work()
+        ,m_done()
+        ,m_stop( false )
+        ,m_threads()
+    {
+        for( unsigned i = 0; i < QUEUE_DEPTH; ++i )
+            m_threads.push_back( std::thread( &preadReader::work, this ) );
+    }
+
+    ~preadReader() TATO_NO_THROW
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+        }
+        m_work.notify_all();
+
+        for( std::thread & thread : m_threads )
+            thread.join();
+    }
+
+    const char * getName() const TATO_OVERRIDE
+    {
+        return "pread";
+    }
+
+    void submit( unsigned _slot, char * _out, size_t _size, uint64_t _offset ) TATO_OVERRIDE
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            request & newRequest = m_requests[_slot];
+            newRequest.m_out = _out;
+            newRequest.m_size = _size;
+            newRequest.m_offset = _offset;
+            newRequest.m_done = false;
+            m_queue.push_back( _slot );
+        }
+        m_work.notify_one();
+    }
+
+    size_t wait( unsigned _slot ) TATO_OVERRIDE
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_done.wait( lock, [this, _slot]() { return m_requests[_slot].m_done; } );
+
+        if( m_requests[_slot].m_result < 0 )
+            throw invalid_file( m_filename );
+
+        return static_cast<size_t>( m_requests[_slot].m_result );
+    }
+
+private:
+    struct request
+    {
+        char *      m_out;
+        size_t      m_size;
+        uint64_t    m_offset;
+        bool        m_done;
+        ssize_t     m_result;
+    };
+
+    // body of the threads: the requests left are read before leaving
+    void work()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        for( ;; )
+        {
+            m_work.wait( lock, [this]() { return m_stop || !m_queue.empty(); } );
+
+            if( m_queue.empty() )
+                return;
+
+            const unsigned slot = m_queue.front();
+            m_queue.pop_front();
+            const request toRead = m_requests[slot];
+
+            lock.unlock();
+            const ssize_t result = readFully( m_fileDescriptor, toRead.m_out, toRead.m_size, toRead.m_offset );
+            lock.lock();
+
+            m_requests[slot].m_result = result;
+            m_requests[slot].m_done = true;
+            m_done.notify_all();
+        }
+    }
+
+private:
+    const int                   m_fileDescriptor;
+    const std::string           m_filename;
+
+    std::vector<request>        m_requests;
+    std::deque<unsigned>        m_queue;
+
+    std::mutex                  m_mutex;
+    std::condition_variable     m_work;
+    std::condition_variable     m_done;
+    bool                        m_stop;
+
+    std::vector<std::thread>    m_threads;
+};
+
+// -------------------------------------------------------------------------- //
+
+#ifdef TATO_USE_IO_URING
+/**@struct uringReader
+ * @brief Reads blocks with io_uring, without any thread.
+ *
+ * The rings are set up with the raw system calls, so that liburing is not
+ * needed. */
+struct uringReader : public blockReader
+{
+    uringReader( int _fileDescriptor, const std::string & _filename )
+        :m_fileDescriptor( _fileDescriptor )
+        ,m_filename( _filename )
+        ,m_ringDescriptor( -1 )
+        ,m_sqRing( MAP_FAILED ), m_sqRingSize( 0 )
+        ,m_cqRing( MAP_FAILED ), m_cqRingSize( 0 )
+        ,m_sqes( MAP_FAILED ), m_sqesSize( 0 )
+        ,m_sqTail( nullptr ), m_sqMask( nullptr ), m_sqArray( nullptr )
+        ,m_cqHead( nullptr ), m_cqTail( nullptr ), m_cqMask( nullptr ), m_cqes( nullptr )
+        ,m_requests( QUEUE_DEPTH )
+    {
+        io_uring_params params;
+        memset( &params, 0, sizeof( params ) );
+
+        // fails on kernels older than 5.1, or if a seccomp policy forbids it
+        m_ringDescriptor = static_cast<int>( syscall( __NR_io_uring_setup, QUEUE_DEPTH, &params ) );
+        if( m_ringDescriptor < 0 )
+            return;
+
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+        m_sqesSize = params.sq_entries * sizeof( io_uring_sqe );
+
+        m_sqRing = mmap( nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringDescriptor, IORING_OFF_SQ_RING );
+        m_cqRing = mmap( nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringDescriptor, IORING_OFF_CQ_RING );
+        m_sqes = mmap( nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringDescriptor, IORING_OFF_SQES );
+
+        if( m_sqRing == MAP_FAILED || m_cqRing == MAP_FAILED || m_sqes == MAP_FAILED )
+        {
+            unmapRings();
+            return;
+        }
+
+        char * const sqRing = static_cast<char *>( m_sqRing );
+        char * const cqRing = static_cast<char *>( m_cqRing );
+
+        m_sqTail  = reinterpret_cast<unsigned *>( sqRing + params.sq_off.tail );
+        m_sqMask  = reinterpret_cast<unsigned *>( sqRing + params.sq_off.ring_mask );
+        m_sqArray = reinterpret_cast<unsigned *>( sqRing + params.sq_off.array );
+        m_cqHead  = reinterpret_cast<unsigned *>( cqRing + params.cq_off.head );
+        m_cqTail  = reinterpret_cast<unsigned *>( cqRing + params.cq_off.tail );
+        m_cqMask  = reinterpret_cast<unsigned *>( cqRing + params.cq_off.ring_mask );
+        m_cqes    = reinterpret_cast<io_uring_cqe *>( cqRing + params.cq_off.cqes );
+    }
+
+    ~uringReader() TATO_NO_THROW
+    {
+        unmapRings();
+    }
+
+    /**@brief Tells whether the kernel accepted to create the rings */
+    bool isValid() const
+    {
+        return m_ringDescriptor >= 0;
+    }
+
+    const char * getName() const TATO_OVERRIDE
+    {
+        return "io_uring";
+    }
+
+    void submit( unsigned _slot, char * _out, size_t _size, uint64_t _offset ) TATO_OVERRIDE
+    {
+        request & newRequest = m_requests[_slot];
+        newRequest.m_vector.iov_base = _out;
+        newRequest.m_vector.iov_len = _size;
+        newRequest.m_offset = _offset;
+        newRequest.m_done = false;
+        newRequest.m_result = 0;
+
+        // only this thread writes the tail of the submission queue
+        const unsigned tail = *m_sqTail;
+        const unsigned index = tail & *m_sqMask;
+
+        io_uring_sqe & sqe = static_cast<io_uring_sqe *>( m_sqes )[index];
+        memset( &sqe, 0, sizeof( sqe ) );
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = m_fileDescriptor;
+        sqe.off = _offset;
+        sqe.addr = reinterpret_cast<uint64_t>( &newRequest.m_vector );
+        sqe.len = 1;
+        sqe.user_data = _slot;
+
+        m_sqArray[index] = index;
+        __atomic_store_n( m_sqTail, tail + 1, __ATOMIC_RELEASE );
+
+        if( enter( 1, 0, 0 ) < 0 )
+        {
+            // the read could not be queued, wait() will report it
+            newRequest.m_done = true;
+            newRequest.m_result = -errno;
+        }
+    }
+
+    size_t wait( unsigned _slot ) TATO_OVERRIDE
+    {
+        request & pending = m_requests[_slot];
+
+        while( !pending.m_done )
+        {
+            // only this thread moves the head of the completion queue
+            const unsigned head = *m_cqHead;
+
+            if( head == __atomic_load_n( m_cqTail, __ATOMIC_ACQUIRE ) )
+            {
+                if( enter( 0, 1, IORING_ENTER_GETEVENTS ) < 0 )
+                    throw invalid_file( m_filename );
+                continue;
+            }
+
+            const io_uring_cqe & completion = m_cqes[head & *m_cqMask];
+            request & completed = m_requests[static_cast<unsigned>( completion.user_data )];
+            completed.m_result = completion.res;
+            completed.m_done = true;
+
+            __atomic_store_n( m_cqHead, head + 1, __ATOMIC_RELEASE );
+        }
+
+        if( pending.m_result < 0 )
+            throw invalid_file( m_filename );
+
+        // a read can stop before the end of the block: the rest is read here
+        size_t nbRead = static_cast<size_t>( pending.m_result );
+        if( nbRead != 0 && nbRead < pending.m_vector.iov_len )
+        {
+            const ssize_t rest =
+                readFully( m_fileDescriptor, static_cast<char *>( pending.m_vector.iov_base ) + nbRead,
+                           pending.m_vector.iov_len - nbRead, pending.m_offset + nbRead );
+
+            if( rest < 0 )
+                throw invalid_file( m_filename );
+
+            nbRead += static_cast<size_t>( rest );
+        }
+
+        return nbRead;
+    }
+
+private:
+    struct request
+    {
+        iovec       m_vector;
+        uint64_t    m_offset;
+        bool        m_done;
+        int32_t     m_result;
+    };
+
+    int enter( unsigned _toSubmit, unsigned _minComplete, unsigned _flags )
+    {
+        int ret;
+        do
+        {
+            ret = static_cast<int>( syscall( __NR_io_uring_enter, m_ringDescriptor, _toSubmit, _minComplete, _flags, nullptr, 0 ) );
+        }
+        while( ret < 0 && errno == EINTR );
+
+        return ret;
+    }
+
+    void unmapRings()
+    {
+        if( m_sqes != MAP_FAILED )
+            munmap( m_sqes, m_sqesSize );
+        if( m_cqRing != MAP_FAILED )
+            munmap( m_cqRing, m_cqRingSize );
+        if( m_sqRing != MAP_FAILED )
+            munmap( m_sqRing, m_sqRingSize );
+        if( m_ringDescriptor >= 0 )
+            close( m_ringDescriptor );
+
+        m_sqes = m_cqRing = m_sqRing = MAP_FAILED;
+        m_ringDescriptor = -1;
+    }
+
+private:
+    const int               m_fileDescriptor;
+    const std::string       m_filename;
+    int                     m_ringDescriptor;
+
+    void *                  m_sqRing;
+    size_t                  m_sqRingSize;
+    void *                  m_cqRing;
+    size_t                  m_cqRingSize;
+    void *                  m_sqes;
+    size_t                  m_sqesSize;
+
+    unsigned *              m_sqTail;
+    unsigned *              m_sqMask;
+    unsigned *              m_sqArray;
+    unsigned *              m_cqHead;
+    unsigned *              m_cqTail;
+    unsigned *              m_cqMask;
+    io_uring_cqe *          m_cqes;
+
+    std::vector<request>    m_requests;
+};
+#endif // TATO_USE_IO_URING
+
+// -------------------------------------------------------------------------- //
+
+static
+std::unique_ptr<blockReader> createBlockReader( int _fileDescriptor, const std::string & _filename )
+{
+#ifdef TATO_USE_IO_URING
+    uringReader * const uring = new uringReader( _fileDescriptor, _filename );
+    std::unique_ptr<blockReader> reader( uring );
+    if( uring->isValid() )
+        return reader;
+#endif
+
+    return std::unique_ptr<blockReader>( new preadReader( _fileDescriptor, _filename ) );
+}
+
+// -------------------------------------------------------------------------- //
+
+fileStream::fileStream( const std::string & _filename )
+    :m_filename( _filename )
+    ,m_fileDescriptor( open( _filename.c_str(), O_RDONLY ) )
+    ,m_fileSize( 0 )
+    ,m_nextOffset( 0 )
+    ,m_buffers()
+    ,m_freeBuffers()
+    ,m_pendingReads()
+    ,m_carry()
+    ,m_reader()
+{
+    if( m_fileDescriptor == -1 )
+        throw invalid_file( _filename );
+
+    struct stat st;
+    if( fstat( m_fileDescriptor, &st ) == -1 )
+    {
+        close( m_fileDescriptor );
+        throw invalid_file( _filename );
+    }
+
+    m_fileSize = static_cast<uint64_t>( st.st_size );
+
+#   ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise( m_fileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL );
+#   endif
+
+    try
+    {
+        m_reader = createBlockReader( m_fileDescriptor, _filename );
+        llog::info << "reading " << _filename << " with " << m_reader->getName() << '\n';
+
+        // start reading right now, the parser is not created yet
+        submitReads();
+    }
+    catch( ... )
+    {
+        m_reader.reset();
+        close( m_fileDescriptor );
+        throw;
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+fileStream::~fileStream() TATO_NO_THROW
+{
+    // the reads still going on write into the buffers that are about to be freed
+    for( const pendingRead & pending : m_pendingReads )
+    {
+        try
+        {
+            m_reader->wait( pending.m_slot );
+        }
+        catch( const invalid_file & )
+        {
+        }
+    }
+
+    m_reader.reset();
+    close( m_fileDescriptor );
+}
+
+// -------------------------------------------------------------------------- //
+
+const char * fileStream::getReaderName() const
+{
+    return m_reader->getName();
+}
+
+// -------------------------------------------------------------------------- //
+
+size_t fileStream::acquireBuffer( size_t _size )
+{
+    size_t index;
+    if( m_freeBuffers.empty() )
+    {
+        m_buffers.push_back( buffer() );
+        m_buffers.back().m_size = 0;
+        index = m_buffers.size() - 1;
+    }
+    else
+    {
+        index = m_freeBuffers.back();
+        m_freeBuffers.pop_back();
+    }
+
+    buffer & chosen = m_buffers[index];
+    if( chosen.m_size < HEAD_ROOM + _size )
+    {
+        void * data = nullptr;
+        if( posix_memalign( &data, BUFFER_ALIGNMENT, HEAD_ROOM + _size ) != 0 )
+        {
+            m_freeBuffers.push_back( index );
+            throw std::bad_alloc();
+        }
+
+        chosen.m_data.reset( static_cast<char *>( data ) );
+        chosen.m_size = HEAD_ROOM + _size;
+    }
+
+    return index;
+}
+
+// -------------------------------------------------------------------------- //
+
+void fileStream::submitReads()
+{
+    while( m_pendingReads.size() < QUEUE_DEPTH && m_nextOffset < m_fileSize )
+    {
+        pendingRead read;
+        read.m_offset = m_nextOffset;
+        read.m_size = static_cast<size_t>( std::min<uint64_t>( READ_BLOCK_SIZE, m_fileSize - m_nextOffset ) );
+        read.m_buffer = acquireBuffer( READ_BLOCK_SIZE );
+
+        // the blocks are waited for in order, so the slot of the block read
+        // QUEUE_DEPTH blocks earlier is free
+        read.m_slot = static_cast<unsigned>( ( m_nextOffset / READ_BLOCK_SIZE ) % QUEUE_DEPTH );
+
+        m_reader->submit( read.m_slot, m_buffers[read.m_buffer].m_data.get() + HEAD_ROOM, read.m_size, read.m_offset );
+        m_pendingReads.push_back( read );
+        m_nextOffset += read.m_size;
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+const char * fileStream::prependCarry( size_t & index_, size_t _size )
+{
+    const size_t carrySize = m_carry.size();
+
+    if( carrySize <= HEAD_ROOM )
+    {
+        char * const begin = m_buffers[index_].m_data.get() + HEAD_ROOM - carrySize;
+        std::copy( m_carry.begin(), m_carry.end(), begin );
+        return begin;
+    }
+
+    // the line is longer than the head room: both are copied into a larger buffer
+    const size_t index = acquireBuffer( carrySize + _size );
+    char * const begin = m_buffers[index].m_data.get() + HEAD_ROOM;
+    std::copy( m_carry.begin(), m_carry.end(), begin );
+    memcpy( begin + carrySize, m_buffers[index_].m_data.get() + HEAD_ROOM, _size );
+
+    m_freeBuffers.push_back( index_ );
+    index_ = index;
+
+    return begin;
+}
+
+// -------------------------------------------------------------------------- //
+
+bool fileStream::next( inputChunk & chunk_ )
+{
+    for( ;; )
+    {
+        size_t index;
+        size_t nbRead = 0;
+
+        if( m_pendingReads.empty() )
+        {
+            // the file does not end with '\n': its last line is handed over as is
+            if( m_carry.empty() )
+                return false;
+
+            index = acquireBuffer( 0 );
+        }
+        else
+        {
+            const pendingRead read = m_pendingReads.front();
+            m_pendingReads.pop_front();
+
+            nbRead = m_reader->wait( read.m_slot );
+            index = read.m_buffer;
+
+            // the slot is free again: read further while the parser works
+            submitReads();
+        }
+
+        const bool lastBlock = m_pendingReads.empty();
+        const size_t total = m_carry.size() + nbRead;
+        const char * const begin = prependCarry( index, nbRead );
+        const char * end = begin + total;
+        m_carry.clear();
+
+        // the chunk stops after the last complete line, the rest is carried
+        // over to the next block
+        if( !lastBlock )
+        {
+            const char * lastNewLine = end;
+            while( lastNewLine != begin && *( lastNewLine - 1 ) != '\n' )
+                --lastNewLine;
+
+            m_carry.assign( lastNewLine, end );
+            end = lastNewLine;
+        }
+
+        if( begin == end )
+        {
+            // not a single complete line in this block
+            m_freeBuffers.push_back( index );
+
+            if( lastBlock && m_carry.empty() )
+                return false;
+
+            continue;
+        }
+
+        chunk_.m_begin = begin;
+        chunk_.m_end = end;
+        chunk_.m_buffer = index;
+
+        return true;
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+void fileStream::release( const inputChunk & _chunk )
+{
+    m_freeBuffers.push_back( _chunk.m_buffer );
+}
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
@@ -0,0 +1,102 @@
+#ifndef LIBTATOPARSER_FILE_STREAM_H
+#define LIBTATOPARSER_FILE_STREAM_H
+
+#include "tatoparser/namespace.h"
+#include "input_stream.h"
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+struct blockReader;
+
+/**@struct fileStream
+ * @brief Reads a file in large blocks, several of them being read at the same
+ *        time, and hands them over to the parser as soon as they arrive.
+ *
+ * This is an alternative to fileMapper for the volumes on which page faults
+ * are slow and unpredictable, like network file systems. The blocks are read
+ * with io_uring when the kernel supports it, and with pread() on a few
+ * threads otherwise. */
+struct fileStream : public inputStream
+{
+    /**@brief Opens a file and starts reading its first blocks
+     * @throw invalid_file if the file cannot be opened */
+    explicit fileStream( const std::string & _filename );
+
+    /**@brief Waits for the pending reads and frees every buffer */
+    ~fileStream() TATO_NO_THROW;
+
+    /**@brief Waits for the next block and returns its complete lines
+     * @throw invalid_file if reading the file failed */
+    bool next( inputChunk & chunk_ ) TATO_OVERRIDE;
+
+    void release( const inputChunk & _chunk ) TATO_OVERRIDE;
+
+    /**@brief Returns the name of the method used to read the file, for logs */
+    const char * getReaderName() const;
+
+private:
+    // a block of the file that is being read
+    struct pendingRead
+    {
+        size_t      m_buffer;
+        uint64_t    m_offset;
+        size_t      m_size;
+        unsigned    m_slot;     // identifies the read for the reader
+    };
+
+    struct alignedDeleter
+    {
+        void operator()( char * _buffer ) const { free( _buffer ); }
+    };
+
+    struct buffer
+    {
+        std::unique_ptr<char, alignedDeleter>   m_data;
+        size_t                                  m_size;
+    };
+
+    // returns the index of a buffer of at least _size bytes, after the head room
+    size_t acquireBuffer( size_t _size );
+
+    // starts reading blocks until enough of them are pending
+    void submitReads();
+
+    // copies the carried over characters just before the _size bytes read in
+    // a buffer, which can be replaced by a larger one, and returns where
+    // they start
+    const char * prependCarry( size_t & index_, size_t _size );
+
+private:
+    const std::string           m_filename;
+    int                         m_fileDescriptor;
+    uint64_t                    m_fileSize;
+    uint64_t                    m_nextOffset;   // of the next block to read
+
+    std::vector<buffer>         m_buffers;
+    std::vector<size_t>         m_freeBuffers;
+    std::deque<pendingRead>     m_pendingReads;
+
+    // the end of the last line of the previous block, which was not complete
+    std::vector<char>           m_carry;
+
+    // declared last so that it is destroyed before the buffers it writes into
+    std::unique_ptr<blockReader> m_reader;
+
+private:
+    fileStream( const fileStream & ) TATO_DELETE;
+    fileStream & operator=( const fileStream & ) TATO_DELETE;
+};
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
+
+#endif // LIBTATOPARSER_FILE_STREAM_H
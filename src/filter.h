@@ -1,12 +1,47 @@
 #ifndef FILTER_H
 #define FILTER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <vector>
+#include <tatoparser/sentence.h>
 
 NAMESPACE_START
 
-struct sentence;
+struct dataset;
+
+/**@brief How many consecutive sentences are given at once to parseBlock() */
+static const size_t FILTER_BLOCK_SIZE = 1024;
+
+/**@brief The index of a sentence in a block */
+typedef uint16_t blockIndex;
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Removes from a selection the sentences which a predicate rejects,
+ *        without branching on the result of the predicate
+ * @param[in] _block Consecutive sentences
+ * @param[in,out] selection_ The indexes of the selected sentences of _block,
+ *                in increasing order
+ * @param[in] _nbSelected How many indexes selection_ holds
+ * @return How many sentences are still selected, at the start of selection_ */
+template<typename PREDICATE> inline
+size_t narrowSelection( const sentence * _block, blockIndex * selection_, size_t _nbSelected, PREDICATE _keep )
+{
+    size_t nbKept = 0;
+
+    for( size_t i = 0; i < _nbSelected; ++i )
+    {
+        const blockIndex index = selection_[i];
+        selection_[nbKept] = index;
+        nbKept += _keep( _block[index] ) ? 1 : 0;
+    }
+
+    return nbKept;
+}
+
+// -------------------------------------------------------------------------- //
 
 /**@struct filter
  * @brief Checks that a sentence against a set of criterions */
@@ -21,10 +56,62 @@ struct filter
      * @return true if the sentence matches the set of criterion, false otherwise */
     virtual bool parse( const sentence & _sentence ) = 0;
 
+    /**@brief Checks a block of consecutive sentences, of at most
+     *        FILTER_BLOCK_SIZE sentences, and removes those which do not match
+     *        from a selection, see narrowSelection()
+     * @return How many sentences are still selected */
+    virtual size_t parseBlock( const sentence * _block, blockIndex * selection_, size_t _nbSelected )
+    {
+        return narrowSelection( _block, selection_, _nbSelected, [this]( const sentence & _sentence )
+        {
+            return parse( _sentence );
+        } );
+    }
+
+    /**@brief Called once the csv files have been parsed, before the first
+     *        sentence is checked, to prepare what the checks need */
+    virtual void prepare( const dataset & ) { }
+
     /**@brief Should the sentence be displayed */
     virtual bool postProcess( const sentence & _sentence ) { return true; }
+
+    /**@brief Returns a short name for the filter, like the option which
+     *        creates it, to report what it selects */
+    virtual const char * getName() const = 0;
+
+    /**@brief Returns about how many nanoseconds a call to parse() takes, so
+     *        that the cheap filters can be run before the expensive ones */
+    virtual double getCost() const = 0;
+
+    /**@brief Tells whether the filter can be run before or after any other
+     *        filter. A filter which remembers the sentences it is given must
+     *        only be given those which all the other filters keep. */
+    virtual bool canBeReordered() const { return true; }
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@struct blockFilter
+ * @brief Implements parseBlock() with the parse() of a filter, called directly
+ *        instead of through the table of virtual functions, so that the cheap
+ *        checks are inlined in the loop over the block
+ * @tparam FILTER The filter which derives from blockFilter */
+template<typename FILTER>
+struct blockFilter : public filter
+{
+    size_t parseBlock( const sentence * _block, blockIndex * selection_, size_t _nbSelected ) TATO_OVERRIDE
+    {
+        FILTER & self = static_cast<FILTER &>( *this );
+
+        return narrowSelection( _block, selection_, _nbSelected, [&self]( const sentence & _sentence )
+        {
+            return self.FILTER::parse( _sentence );
+        } );
+    }
 };
 
+// -------------------------------------------------------------------------- //
+
 typedef std::vector< std::shared_ptr< filter > > FilterVector ;
 
 NAMESPACE_END
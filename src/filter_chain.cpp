@@ -0,0 +1,128 @@
+#include "prec.h"
+#include "filter_id.h"
+#include "filter_idlist.h"
+#include "filter_regex.h"
+#include "filter_translation_regex.h"
+#include "filter_link.h"
+#include "filter_list.h"
+#include "filter_lang.h"
+#include "filter_tag.h"
+#include "filter_translatable_in_language.h"
+#include "filter_user.h"
+#include "filter_known_chars.h"
+#include "filter_chain.h"
+
+NAMESPACE_START
+
+// -------------------------------------------------------------------------- //
+
+// a chain compiled in advance: how many filters it replaces, whether some
+// filters have its types, and how it is created from them
+struct chainType
+{
+    size_t m_length;
+    bool ( *m_matches )( const FilterVector::value_type * );
+    std::shared_ptr<filter> ( *m_create )( const FilterVector::value_type * );
+};
+
+// -------------------------------------------------------------------------- //
+
+template<typename... FILTERS> static
+std::shared_ptr<filter> createChain( const FilterVector::value_type * _filters )
+{
+    return std::make_shared< filterChain<FILTERS...> >( _filters );
+}
+
+template<typename... FILTERS> static
+void addChainType( std::vector<chainType> & chainTypes_ )
+{
+    chainTypes_.push_back( chainType { sizeof...( FILTERS ), &fusedPredicate<FILTERS...>::matches, &createChain<FILTERS...> } );
+}
+
+// the filters can be run in any order, so each order is compiled
+template<typename A, typename B> static
+void addPair( std::vector<chainType> & chainTypes_ )
+{
+    addChainType<A, B>( chainTypes_ );
+    addChainType<B, A>( chainTypes_ );
+}
+
+template<typename A, typename B, typename C> static
+void addTriple( std::vector<chainType> & chainTypes_ )
+{
+    addChainType<A, B, C>( chainTypes_ );
+    addChainType<A, C, B>( chainTypes_ );
+    addChainType<B, A, C>( chainTypes_ );
+    addChainType<B, C, A>( chainTypes_ );
+    addChainType<C, A, B>( chainTypes_ );
+    addChainType<C, B, A>( chainTypes_ );
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Returns the chains compiled in advance, the longest first. Those are
+ *        the combinations of options which are the most often used: a
+ *        language with another filter, and a language with its translations
+ *        and a tag or a regular expression. */
+static
+const std::vector<chainType> & getChainTypes()
+{
+    static const std::vector<chainType> chainTypes = []()
+    {
+        std::vector<chainType> types;
+
+        addTriple<filterLang, filterTranslatableInLanguage, filterTag>( types );
+        addTriple<filterLang, filterTranslatableInLanguage, filterRegex>( types );
+
+        addPair<filterLang, filterTag>( types );
+        addPair<filterLang, filterList>( types );
+        addPair<filterLang, filterUser>( types );
+        addPair<filterLang, filterRegex>( types );
+        addPair<filterLang, filterTranslatableInLanguage>( types );
+        addPair<filterLang, filterKnownCharacters>( types );
+        addPair<filterLang, filterTranslationRegex>( types );
+        addPair<filterLang, filterLink>( types );
+        addPair<filterLang, filterIdList>( types );
+        addPair<filterLang, filterId>( types );
+        addPair<filterTag, filterRegex>( types );
+
+        return types;
+    }();
+
+    return chainTypes;
+}
+
+// -------------------------------------------------------------------------- //
+
+void fuseFilters( FilterVector & filters_, size_t _nbFusable )
+{
+    const std::vector<chainType> & chainTypes = getChainTypes();
+    FilterVector fusedFilters;
+    size_t first = 0;
+
+    while( first < _nbFusable )
+    {
+        std::vector<chainType>::const_iterator chain = chainTypes.begin();
+
+        while( chain != chainTypes.end() &&
+               ( first + chain->m_length > _nbFusable || !chain->m_matches( &filters_[first] ) ) )
+        {
+            ++chain;
+        }
+
+        if( chain != chainTypes.end() )
+        {
+            fusedFilters.push_back( chain->m_create( &filters_[first] ) );
+            first += chain->m_length;
+
+            qlog::info << "fused filters " << qlog::color( qlog::blue ) << fusedFilters.back()->getName() << qlog::color() << '\n';
+        }
+        else
+            fusedFilters.push_back( filters_[first++] );
+    }
+
+    fusedFilters.insert( fusedFilters.end(), filters_.begin() + static_cast<ptrdiff_t>( _nbFusable ), filters_.end() );
+    filters_.swap( fusedFilters );
+}
+
+NAMESPACE_END
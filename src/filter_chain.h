@@ -0,0 +1,126 @@
+#ifndef FILTER_CHAIN_H
+#define FILTER_CHAIN_H
+
+#include <string>
+#include <typeinfo>
+#include "filter.h"
+
+NAMESPACE_START
+
+/**@struct fusedPredicate
+ * @brief Checks a sentence against several filters of known types, calling
+ *        their parse() directly so that the compiler can inline them into a
+ *        single test, which stops at the first filter rejecting the sentence
+ * @tparam FILTERS The types of the filters, in the order they are run */
+template<typename... FILTERS>
+struct fusedPredicate;
+
+template<>
+struct fusedPredicate<>
+{
+    explicit fusedPredicate( const FilterVector::value_type * ) { }
+
+    bool operator()( const sentence & ) const { return true; }
+
+    /**@brief Tells whether some filters have the types of the chain */
+    static bool matches( const FilterVector::value_type * ) { return true; }
+};
+
+template<typename FIRST, typename... OTHERS>
+struct fusedPredicate<FIRST, OTHERS...>
+{
+    /**@param[in] _filters The filters, whose types must match the chain */
+    explicit fusedPredicate( const FilterVector::value_type * _filters )
+        : m_first( static_cast<FIRST &>( **_filters ) )
+        , m_others( _filters + 1 )
+    {
+    }
+
+    bool operator()( const sentence & _sentence ) const
+    {
+        return m_first.FIRST::parse( _sentence ) && m_others( _sentence );
+    }
+
+    /**@brief Tells whether some filters have the types of the chain */
+    static bool matches( const FilterVector::value_type * _filters )
+    {
+        return typeid( **_filters ) == typeid( FIRST ) && fusedPredicate<OTHERS...>::matches( _filters + 1 );
+    }
+
+private:
+    FIRST &                     m_first;
+    fusedPredicate<OTHERS...>   m_others;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@struct filterChain
+ * @brief A filter which runs several filters of known types at once
+ * @tparam FILTERS The types of the filters, in the order they are run */
+template<typename... FILTERS>
+struct filterChain : public filter
+{
+    /**@param[in] _filters sizeof...( FILTERS ) filters, whose types must match
+     *            the chain, see fusedPredicate::matches() */
+    explicit filterChain( const FilterVector::value_type * _filters )
+        : m_filters( _filters, _filters + sizeof...( FILTERS ) )
+        , m_predicate( _filters )
+        , m_name()
+    {
+        for( const FilterVector::value_type & chained : m_filters )
+            m_name += ( m_name.empty() ? "" : "+" ) + std::string( chained->getName() );
+    }
+
+    bool parse( const sentence & _sentence ) TATO_OVERRIDE
+    {
+        return m_predicate( _sentence );
+    }
+
+    size_t parseBlock( const sentence * _block, blockIndex * selection_, size_t _nbSelected ) TATO_OVERRIDE
+    {
+        return narrowSelection( _block, selection_, _nbSelected, m_predicate );
+    }
+
+    bool postProcess( const sentence & _sentence ) TATO_OVERRIDE
+    {
+        bool shouldDisplay = true;
+
+        for( const FilterVector::value_type & chained : m_filters )
+            shouldDisplay = shouldDisplay && chained->postProcess( _sentence );
+
+        return shouldDisplay;
+    }
+
+    /**@brief Returns the names of the filters, joined with '+' */
+    const char * getName() const TATO_OVERRIDE { return m_name.c_str(); }
+
+    /**@brief Returns the estimated cost of all the filters */
+    double getCost() const TATO_OVERRIDE
+    {
+        double cost = 0;
+
+        for( const FilterVector::value_type & chained : m_filters )
+            cost += chained->getCost();
+
+        return cost;
+    }
+
+private:
+    FilterVector                m_filters;
+    fusedPredicate<FILTERS...>  m_predicate;
+    std::string                 m_name;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Replaces the consecutive filters whose types match one of the chains
+ *        compiled in advance, for the frequent combinations of options, with
+ *        that chain. The other filters are kept as they are.
+ * @param[in,out] filters_ The filters, in the order they are run
+ * @param[in] _nbFusable How many filters, at the start of filters_, can be
+ *            fused: a filter which cannot be reordered must not be */
+void fuseFilters( FilterVector & filters_, size_t _nbFusable );
+
+NAMESPACE_END
+
+#endif // FILTER_CHAIN_H
@@ -1,6 +1,9 @@
 #ifndef FILTER_FUZZY_H
 #define FILTER_FUZZY_H
 
+#include <tatoparser/dataset.h>
+#include "folded_text.h"
+
 NAMESPACE_START
 
 #include "filter.h"
@@ -163,6 +166,10 @@ struct filterFuzzy : public filter
 {
     filterFuzzy( const std::string & _expression, unsigned int _nbSentencesToKeep )
         :m_expression( _expression )
+        ,m_foldedExpression()
+        ,m_useFoldedText( false )
+        ,m_foldedText()
+        ,m_firstSentence( nullptr )
         ,m_keptSentences()
         ,m_levenshteinValues()
     {
@@ -175,6 +182,25 @@ struct filterFuzzy : public filter
     {
     }
 
+    /**@brief Compares the expression and the sentences once both are
+     *        normalized with NFKC and case-folded, so that the case and the
+     *        width of the characters do not count in the distance */
+    void useFoldedText()
+    {
+        m_useFoldedText = true;
+    }
+
+    /**@brief Folds the expression and the texts of the sentences */
+    void prepare( const dataset & _dataset ) TATO_OVERRIDE
+    {
+        if( !m_useFoldedText || _dataset.size() == 0 )
+            return;
+
+        m_foldedText = foldedText::get( _dataset );
+        m_foldedExpression = foldText( m_expression );
+        m_firstSentence = &*_dataset.begin();
+    }
+
     /**@brief Checks that a sentence is close enough
     * @param[in] _sentence The second sentence.
     * @return True if the passed sentence is linked to the sentence passed in
@@ -186,7 +212,11 @@ struct filterFuzzy : public filter
         assert( m_levenshteinValues.size() == m_keptSentences.size() );
         assert( m_levenshteinValues.capacity() == m_keptSentences.capacity() );
 
-        const lvh_distance distance = levenshtein_distance_word( m_expression, removePunctuation( _sentence.str() ) );
+        const size_t position = static_cast<size_t>( &_sentence - m_firstSentence );
+        const bool isFolded = m_foldedText && &_sentence >= m_firstSentence && position < m_foldedText->size();
+        const foldedText::text text = isFolded ? m_foldedText->getText( position, _sentence ) : foldedText::text( _sentence.begin(), _sentence.end() );
+
+        const lvh_distance distance = levenshtein_distance_word( isFolded ? m_foldedExpression : m_expression, removePunctuation( std::string( text.first, text.second ) ) );
         qlog::warning( INFINITE_DISTANCE == distance ) << "Skipping invalid sentence: " << _sentence.getId() << '\t' << _sentence.str() << '\n';
         //qlog::info << "\tdistance of " << color(green) << _sentence.str() << color() << " and " << color(green) << m_expression << color() << ": " << distance << '\n';
         unsigned int maxIndex = 0;
@@ -231,8 +261,26 @@ struct filterFuzzy : public filter
         return std::find( m_keptSentences.begin(), m_keptSentences.end(), _sentence.getId() ) != m_keptSentences.end();
     }
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "fuzzy"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), which computes
+     *        the distance to each word of the sentence */
+    double getCost() const TATO_OVERRIDE { return 1900; }
+
+    /**@brief The filter keeps the closest of the sentences it is given, so
+     *        it must only be given those which the other filters keep */
+    bool canBeReordered() const TATO_OVERRIDE { return false; }
+
 private:
     const std::string & m_expression;
+
+    // the expression and the texts of the sentences, folded
+    std::string m_foldedExpression;
+    bool m_useFoldedText;
+    std::shared_ptr<const foldedText> m_foldedText;
+    const sentence * m_firstSentence;
+
     std::vector< sentence::id > m_keptSentences;
     std::vector< lvh_distance > m_levenshteinValues;
 };
@@ -8,7 +8,7 @@ NAMESPACE_START
 
 /**@struct filterId
  * @brief Checks that a sentence has a given id */
-struct filterId : public filter
+struct filterId : public blockFilter<filterId>
 {
     /**@brief Constructs a filterId
      * @param[in] The id to check the sentence against */
@@ -25,6 +25,12 @@ struct filterId : public filter
         return _sentence.getId() == m_filteredId;
     }
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "has-id"; }
+
+    /**@brief Returns the estimated cost of a call to parse() */
+    double getCost() const TATO_OVERRIDE { return 5; }
+
 private:
     sentence::id m_filteredId;
 };
@@ -9,7 +9,7 @@ NAMESPACE_START
 
 /**@struct filterIdList
  * @brief Checks that a sentence has any of the given ids */
-struct filterIdList : public filter
+struct filterIdList : public blockFilter<filterIdList>
 {
     /**@brief Constructs a filterId
      * @param[in] The id to check the sentence against */
@@ -27,6 +27,13 @@ struct filterIdList : public filter
         return std::find( m_filteredIds.begin(), m_filteredIds.end(), _sentence.getId() ) != m_filteredIds.end();
     }
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "translates"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), which goes
+     *        through all the ids */
+    double getCost() const TATO_OVERRIDE { return 5 + 0.5 * static_cast<double>( m_filteredIds.size() ); }
+
 private:
     std::vector<sentence::id> m_filteredIds;
 };
@@ -0,0 +1,67 @@
+#ifndef FILTER_KNOWN_CHARS_H
+#define FILTER_KNOWN_CHARS_H
+
+#include <tatoparser/dataset.h>
+#include "filter.h"
+#include "character_inventory.h"
+
+NAMESPACE_START
+
+/**@struct filterKnownCharacters
+ * @brief Checks that a sentence is written with some characters only, or
+ *        with few others. Spaces and punctuation marks do not count.
+ *
+ * The characters of the sentences are looked up in a characterInventory,
+ * built once the csv files have been parsed. */
+struct filterKnownCharacters : public blockFilter<filterKnownCharacters>
+{
+    /**@brief Constructs a filterKnownCharacters
+     * @param[in] _characters The known characters, in UTF-8
+     * @param[in] _maxUnknown How many distinct characters which are not known
+     *            a sentence can hold */
+    filterKnownCharacters( const std::string & _characters, unsigned _maxUnknown )
+        :m_characters( _characters )
+        ,m_maxUnknown( _maxUnknown )
+        ,m_inventory()
+        ,m_known()
+        ,m_firstSentence( nullptr )
+    {
+    }
+
+    /**@brief Looks up the known characters in the alphabet of each language */
+    void prepare( const dataset & _dataset ) TATO_OVERRIDE
+    {
+        if( _dataset.size() == 0 )
+            return;
+
+        m_inventory = characterInventory::get( _dataset );
+        m_known = m_inventory->learn( m_characters );
+        m_firstSentence = &*_dataset.begin();
+    }
+
+    /**@brief Checks that a sentence holds few characters which are not known */
+    bool parse( const sentence & _sentence ) TATO_NO_THROW TATO_OVERRIDE
+    {
+        const size_t position = static_cast<size_t>( &_sentence - m_firstSentence );
+        return m_inventory && &_sentence >= m_firstSentence && position < m_inventory->size() &&
+               m_inventory->countUnknown( position, m_known, m_maxUnknown ) <= m_maxUnknown;
+    }
+
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "only-chars"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), a few words
+     *        for most sentences, and a word per rare character */
+    double getCost() const TATO_OVERRIDE { return 10; }
+
+private:
+    std::string                                 m_characters;
+    unsigned                                    m_maxUnknown;
+    std::shared_ptr<const characterInventory>   m_inventory;
+    characterInventory::knownCharacters         m_known;
+    const sentence *                            m_firstSentence;
+};
+
+NAMESPACE_END
+
+#endif // FILTER_KNOWN_CHARS_H
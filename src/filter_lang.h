@@ -8,13 +8,20 @@ NAMESPACE_START
 
 /**@struct filterLang
  * @brief Checks whether a sentence is in the right language */
-struct filterLang : public filter
+struct filterLang : public blockFilter<filterLang>
 {
     /**@brief Constructs a filterLang
      * @param[in] _lang A language the sentence will be checked against */
     filterLang( const std::vector<std::string> & _lang )
-        : m_languages( _lang )
+        : m_languageKeys()
     {
+        // the languages are compared as integers, see packLanguage. Those which
+        // are too long to be the language of a sentence never match.
+        for( const std::string & language : _lang )
+        {
+            if( language.size() <= sentence::MAX_LANG_SIZE )
+                m_languageKeys.push_back( packLanguage( language.data(), language.size() ) );
+        }
     }
 
     /**@brief Checks that a sentence is in the right language
@@ -22,19 +29,24 @@ struct filterLang : public filter
      * @return true if the sentence is in the right language */
     virtual bool parse( const sentence & _sentence ) TATO_OVERRIDE
     {
-        for(
-            std::vector<std::string>::const_iterator matchLanguage = m_languages.begin();
-            matchLanguage != m_languages.end(); ++matchLanguage )
-        {
-            if( *matchLanguage == _sentence.lang() )
-                return true;
-        }
+        const uint32_t key = _sentence.getLangKey();
+        bool found = false;
 
-        return false;
+        for( uint32_t languageKey : m_languageKeys )
+            found |= languageKey == key;
+
+        return found;
     }
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "language"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), which compares
+     *        the language of the sentence with each language */
+    double getCost() const TATO_OVERRIDE { return 5 + 2 * static_cast<double>( m_languageKeys.size() ); }
+
 private:
-    std::vector<std::string> m_languages;
+    std::vector<uint32_t> m_languageKeys;
 };
 
 NAMESPACE_END
@@ -9,7 +9,7 @@ NAMESPACE_START
 
 /**@struct filterLink
  * @brief Checks that a sentence is linked to another one. */
-struct filterLink : public filter
+struct filterLink : public blockFilter<filterLink>
 {
     /**@brief Constructs a filterLink
      * @param[in] _linkset A list of the links of the sentences
@@ -29,6 +29,13 @@ struct filterLink : public filter
         return m_linkset.areLinked( _sentence.getId(), m_id );
     }
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "is-linked-to"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), a search in the
+     *        links of the sentence */
+    double getCost() const TATO_OVERRIDE { return 50; }
+
 private:
     linkset & m_linkset;
     sentence::id m_id;
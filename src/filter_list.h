@@ -3,37 +3,45 @@
 
 #include <tatoparser/listset.h>
 #include <tatoparser/sentence.h>
-#include <algorithm>
 #include "filter.h"
 
 NAMESPACE_START
 
 /**@struct filterList
  * @brief Filters out sentences that are not part of a given list */
-struct filterList : public filter
+struct filterList : public blockFilter<filterList>
 {
     /**@brief Constructs a filterList
      * @param[in] _listName The name of the list */
     filterList( const std::string & _listName, const listset & _listset )
         :m_listset( _listset )
-        ,m_hash()
+        ,m_listName( _listName )
+        ,m_list( listset::INVALID_LISTID )
     {
-        using namespace qlog;
-        std::string lowerCaseName;
-        std::transform( _listName.begin(), _listName.end(), std::back_inserter( lowerCaseName ), ::tolower );
-        assert( lowerCaseName.size() != 0 );
-        m_hash = listset::computeHash( lowerCaseName );
-        qlog::info << "Computing hash for " << color( yellow ) << lowerCaseName << color() << ": " << color( blue ) << m_hash << color() << '\n';
+        assert( _listName.size() != 0 );
+    }
+
+    /**@brief Looks the list up, once the lists have been parsed */
+    void prepare( const dataset & ) TATO_OVERRIDE
+    {
+        m_list = m_listset.findListId( m_listName );
     }
 
     bool parse( const sentence & _sentence ) TATO_NO_THROW TATO_OVERRIDE
     {
-        return m_listset.isSentenceInList( _sentence.getId(), m_hash );
+        return m_listset.isSentenceInList( _sentence.getId(), m_list );
     }
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "in-list"; }
+
+    /**@brief Returns the estimated cost of a call to parse() */
+    double getCost() const TATO_OVERRIDE { return 150; }
+
 private:
     const listset & m_listset;
-    listset::list_hash m_hash;
+    std::string m_listName;
+    listset::listId m_list;
 };
 NAMESPACE_END
 
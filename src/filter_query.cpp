@@ -0,0 +1,289 @@
+#include "prec.h"
+#include "filter_id.h"
+#include "filter_regex.h"
+#include "filter_translation_regex.h"
+#include "filter_link.h"
+#include "filter_lang.h"
+#include "filter_translatable_in_language.h"
+#include "filter_query.h"
+#include <functional>
+#include <tatoparser/dataset.h>
+#include <tatoparser/linkset.h>
+#include <tatoparser/tagset.h>
+#include <tatoparser/listset.h>
+#include <boost/lexical_cast.hpp>
+
+NAMESPACE_START
+
+/**@struct filterQuery::compiledNode
+ * @brief A node of the expression, whose predicates have been created */
+struct filterQuery::compiledNode
+{
+    explicit compiledNode( queryNode::kind _kind )
+        : m_kind( _kind )
+        , m_filter()
+        , m_lookUp()
+        , m_cost( 0 )
+        , m_children()
+    {
+    }
+
+    queryNode::kind m_kind;
+
+    // a predicate is either checked on each sentence by a filter, or looked
+    // up in an index, which adds the positions of the sentences to a set
+    std::shared_ptr<filter> m_filter;
+    std::function<void( const dataset &, sentenceBitmap & )> m_lookUp;
+
+    // how long checking a sentence takes, to check the cheapest operands first
+    double m_cost;
+
+    std::vector<compiledNode> m_children;
+};
+
+typedef filterQuery::compiledNode compiledNode;
+
+// -------------------------------------------------------------------------- //
+
+// the position of a sentence in the dataset
+static inline
+size_t getPosition( const dataset & _dataset, const sentence & _sentence )
+{
+    return static_cast<size_t>( &_sentence - &*_dataset.begin() );
+}
+
+// -------------------------------------------------------------------------- //
+
+// adds some sentences to a set, those which exist
+static
+void addSentences( const dataset & _dataset, const std::vector<sentence::id> & _ids, sentenceBitmap & selected_ )
+{
+    for( sentence::id id : _ids )
+    {
+        const sentence * const found = _dataset[id];
+        if( found != nullptr )
+            selected_.set( getPosition( _dataset, *found ) );
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+static
+sentence::id readId( const queryNode & _predicate )
+{
+    try
+    {
+        return boost::lexical_cast<sentence::id>( _predicate.m_value );
+    }
+    catch( const boost::bad_lexical_cast & )
+    {
+        throw invalid_query( _predicate.m_name + " expects an id, not \"" + _predicate.m_value + '"' );
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+static
+compiledNode compile( const queryNode & _node, dataset & _dataset, linkset & _linkset, tagset & _tagset, listset & _listset )
+{
+    compiledNode compiled( _node.m_kind );
+
+    if( _node.m_kind != queryNode::PREDICATE )
+    {
+        for( const std::shared_ptr<queryNode> & child : _node.m_children )
+        {
+            compiled.m_children.push_back( compile( *child, _dataset, _linkset, _tagset, _listset ) );
+            compiled.m_cost += compiled.m_children.back().m_cost;
+        }
+
+        // the operands do not depend on each other, so the cheapest can be
+        // checked first, the others only on the sentences it leaves
+        std::stable_sort( compiled.m_children.begin(), compiled.m_children.end(),
+            []( const compiledNode & _a, const compiledNode & _b ) { return _a.m_cost < _b.m_cost; } );
+
+        return compiled;
+    }
+
+    const std::string & name = _node.m_name;
+    const std::string & value = _node.m_value;
+
+    if( name == "has-id" )
+    {
+        const sentence::id id = readId( _node );
+        compiled.m_lookUp = [id]( const dataset & _sentences, sentenceBitmap & selected_ )
+        {
+            addSentences( _sentences, std::vector<sentence::id>( 1, id ), selected_ );
+        };
+    }
+    else if( name == "has-tag" )
+    {
+        const std::string tagName = toLower( value );
+        compiled.m_lookUp = [&_tagset, tagName]( const dataset & _sentences, sentenceBitmap & selected_ )
+        {
+            const tagset::tagId tag = _tagset.findTagId( tagName );
+            if( tag != tagset::INVALID_TAGID )
+                addSentences( _sentences, _tagset.getTaggedSentences( tag ), selected_ );
+        };
+    }
+    else if( name == "in-list" )
+    {
+        const std::string listName = toLower( value );
+        compiled.m_lookUp = [&_listset, listName]( const dataset & _sentences, sentenceBitmap & selected_ )
+        {
+            const listset::list * const sentencesOfList = _listset.findList( _listset.findListId( listName ) );
+            if( sentencesOfList != nullptr )
+                addSentences( _sentences, *sentencesOfList, selected_ );
+        };
+    }
+    else if( name == "language" )
+        compiled.m_filter = std::make_shared<filterLang>( std::vector<std::string>( 1, value ) );
+    else if( name == "user" )
+    {
+        compiled.m_lookUp = [value]( const dataset & _sentences, sentenceBitmap & selected_ )
+        {
+            addSentences( _sentences, _sentences.getSentencesOf( _sentences.findUserId( value ) ), selected_ );
+        };
+    }
+    else if( name == "is-linked-to" )
+        compiled.m_filter = std::make_shared<filterLink>( readId( _node ), _linkset );
+    else if( name == "is-translatable-in" )
+        compiled.m_filter = std::make_shared<filterTranslatableInLanguage>( value, _dataset, _linkset );
+    else if( name == "regex" || name == "regex-nocs" )
+        compiled.m_filter = std::make_shared<filterRegex>( value, name == "regex" );
+    else if( name == "translation-regex" )
+        compiled.m_filter = std::make_shared<filterTranslationRegex>( std::vector<std::string>( 1, value ), _dataset, _linkset );
+    else
+        throw invalid_query( "unknown predicate \"" + name + '"' );
+
+    // looking up a predicate costs nothing per sentence
+    compiled.m_cost = compiled.m_filter ? compiled.m_filter->getCost() : 0;
+    return compiled;
+}
+
+// -------------------------------------------------------------------------- //
+
+// Checks the sentences of a set with a filter, block by block, and returns
+// the set of those it keeps
+static
+sentenceBitmap checkEach( filter & _filter, const dataset & _dataset, const sentenceBitmap & _candidates )
+{
+    sentenceBitmap kept( _candidates.size() );
+    const sentence * const firstSentence = &*_dataset.begin();
+    blockIndex selection[FILTER_BLOCK_SIZE];
+
+    for( size_t block = 0; block < _candidates.size(); block += FILTER_BLOCK_SIZE )
+    {
+        size_t nbSelected = 0;
+        _candidates.forEach( block, std::min( block + FILTER_BLOCK_SIZE, _candidates.size() ), [&]( size_t _position )
+        {
+            selection[nbSelected++] = static_cast<blockIndex>( _position - block );
+        } );
+
+        if( nbSelected > 0 )
+            nbSelected = _filter.parseBlock( firstSentence + block, selection, nbSelected );
+
+        for( size_t i = 0; i < nbSelected; ++i )
+            kept.set( block + selection[i] );
+    }
+
+    return kept;
+}
+
+// -------------------------------------------------------------------------- //
+
+// Returns the sentences of a set which match a node
+static
+sentenceBitmap evaluate( const compiledNode & _node, const dataset & _dataset, const sentenceBitmap & _candidates )
+{
+    switch( _node.m_kind )
+    {
+    case queryNode::PREDICATE:
+    {
+        if( !_node.m_lookUp )
+            return checkEach( *_node.m_filter, _dataset, _candidates );
+
+        sentenceBitmap found( _candidates.size() );
+        _node.m_lookUp( _dataset, found );
+        return found &= _candidates;
+    }
+
+    case queryNode::NOT:
+    {
+        sentenceBitmap notMatching = _candidates;
+        return notMatching.andNot( evaluate( _node.m_children.front(), _dataset, _candidates ) );
+    }
+
+    case queryNode::AND:
+    {
+        sentenceBitmap matching = _candidates;
+        for( size_t i = 0; i < _node.m_children.size() && !matching.none(); ++i )
+            matching = evaluate( _node.m_children[i], _dataset, matching );
+
+        return matching;
+    }
+
+    case queryNode::OR:
+    default:
+    {
+        sentenceBitmap matching( _candidates.size() );
+        sentenceBitmap remaining = _candidates;
+
+        for( size_t i = 0; i < _node.m_children.size() && !remaining.none(); ++i )
+        {
+            const sentenceBitmap matchingChild = evaluate( _node.m_children[i], _dataset, remaining );
+            matching |= matchingChild;
+            remaining.andNot( matchingChild );
+        }
+
+        return matching;
+    }
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+// lets the filters of the predicates prepare themselves too
+static
+void prepareFilters( const compiledNode & _node, const dataset & _dataset )
+{
+    if( _node.m_filter )
+        _node.m_filter->prepare( _dataset );
+
+    for( const compiledNode & child : _node.m_children )
+        prepareFilters( child, _dataset );
+}
+
+// -------------------------------------------------------------------------- //
+
+filterQuery::filterQuery( const queryNode & _query, dataset & _dataset, linkset & _linkset, tagset & _tagset, listset & _listset )
+    : m_query( std::make_shared<compiledNode>( compile( _query, _dataset, _linkset, _tagset, _listset ) ) )
+    , m_firstSentence( nullptr )
+    , m_selected()
+{
+}
+
+// -------------------------------------------------------------------------- //
+
+void filterQuery::prepare( const dataset & _dataset )
+{
+    m_selected = sentenceBitmap( _dataset.size() );
+
+    if( _dataset.size() == 0 )
+        return;
+
+    m_firstSentence = &*_dataset.begin();
+    prepareFilters( *m_query, _dataset );
+
+    // the sentences which have an id
+    sentenceBitmap candidates( _dataset.size() );
+    for( dataset::const_iterator current = _dataset.begin(); current != _dataset.end(); ++current )
+    {
+        if( current->getId() != sentence::INVALID_ID )
+            candidates.set( getPosition( _dataset, *current ) );
+    }
+
+    m_selected = evaluate( *m_query, _dataset, candidates );
+    qlog::info << "the query matches " << m_selected.count() << " sentences\n";
+}
+
+NAMESPACE_END
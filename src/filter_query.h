@@ -0,0 +1,59 @@
+#ifndef FILTER_QUERY_H
+#define FILTER_QUERY_H
+
+#include <memory>
+#include "filter.h"
+#include "bitmap.h"
+#include "query_expression.h"
+
+NAMESPACE_START
+
+struct dataset;
+struct linkset;
+struct tagset;
+struct listset;
+
+/**@struct filterQuery
+ * @brief Keeps the sentences which match a query expression, see parseQuery().
+ *
+ * The expression is evaluated once, before the first sentence is checked, as
+ * a set of sentences. The predicates which can be answered from an index,
+ * like has-tag, in-list and has-id, give their set directly. The others are
+ * only checked on the sentences which can still match, by blocks: the
+ * operands of an "and" are given the sentences the previous ones kept, and
+ * those of an "or" the sentences the previous ones did not. */
+struct filterQuery : public blockFilter<filterQuery>
+{
+    /**@brief Compiles a query expression
+     * @throw boost::regex_error if a regular expression is invalid
+     * @throw invalid_query if a value is invalid, like an id which is not a number */
+    filterQuery( const queryNode & _query, dataset & _dataset, linkset & _linkset, tagset & _tagset, listset & _listset );
+
+    /**@brief Evaluates the expression on all the sentences */
+    void prepare( const dataset & _dataset ) TATO_OVERRIDE;
+
+    /**@brief Checks that a sentence matches the expression */
+    bool parse( const sentence & _sentence ) TATO_NO_THROW TATO_OVERRIDE
+    {
+        const size_t position = static_cast<size_t>( &_sentence - m_firstSentence );
+        return &_sentence >= m_firstSentence && position < m_selected.size() && m_selected.test( position );
+    }
+
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "query"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), a look up in
+     *        the sentences which match */
+    double getCost() const TATO_OVERRIDE { return 2; }
+
+    struct compiledNode;
+
+private:
+    std::shared_ptr<compiledNode>   m_query;
+    const sentence *                m_firstSentence;
+    sentenceBitmap                  m_selected;
+};
+
+NAMESPACE_END
+
+#endif // FILTER_QUERY_H
@@ -4,12 +4,22 @@
 #include <boost/regex/icu.hpp>
 #include <boost/regex.hpp>
 #include <tatoparser/sentence.h>
+#include <tatoparser/dataset.h>
 #include "filter.h"
+#include "trigram_index.h"
+#include "suffix_index.h"
+#include "folded_text.h"
 
 NAMESPACE_START
 
 /**@struct filterRegex
- * @brief Checks that a sentence matches a regular expression */
+ * @brief Checks that a sentence matches a regular expression. With a trigram
+ *        index, see useIndex(), only the sentences which hold the literal
+ *        strings of the expression are checked. With a suffix array, see
+ *        useSubstringIndex(), an expression which only looks for a string is
+ *        only checked on the sentences holding it. A case-insensitive
+ *        expression can be matched against the folded texts of the
+ *        sentences, see useFoldedText(). */
 struct filterRegex : public filter
 {
     /**@brief Construct a filterRegex
@@ -18,8 +28,103 @@ struct filterRegex : public filter
      * @param[in] _cs A boolean set to true if the match is case-sensitive */
     explicit
     filterRegex( const std::string & _regex, bool _cs = true )
-        :m_compiledRegex( boost::make_u32regex( _regex, _cs ? boost::regex_constants::normal : boost::regex_constants::normal | boost::regex_constants::icase ) )
+        :m_regex( _regex )
+        ,m_cs( _cs )
+        ,m_compiledRegex( boost::make_u32regex( _regex, _cs ? boost::regex_constants::normal : boost::regex_constants::normal | boost::regex_constants::icase ) )
+        ,m_foldedRegex()
+        ,m_foldedString()
+        ,m_foldedText()
+        ,m_grams( _cs ? analyzeRegex( _regex ) : gramQuery() )
+        ,m_indexPath()
+        ,m_searchedString()
+        ,m_substringIndexPath()
+        ,m_firstSentence( nullptr )
+        ,m_candidates()
+        ,m_cost( 900 )
     {
+        if( !_cs || !findSearchedString( _regex, m_searchedString ) )
+            m_searchedString.clear();
+    }
+
+    /**@brief Looks the sentences which can match up in a trigram index, once
+     *        the csv files have been parsed. Only the case-sensitive
+     *        expressions which hold a literal string of 3 characters or more,
+     *        or of 2 CJK characters, make use of it.
+     * @param[in] _path Where the index is read, or written when it is built */
+    void useIndex( const std::string & _path )
+    {
+        m_indexPath = _path;
+    }
+
+    /**@brief Looks the sentences which hold the string the expression looks
+     *        for, like '.*XYZ.*', up in a suffix array, once the csv files have
+     *        been parsed. The other expressions do not make use of it.
+     * @param[in] _path Where the suffix array is read, or written when it is built */
+    void useSubstringIndex( const std::string & _path )
+    {
+        m_substringIndexPath = _path;
+    }
+
+    /**@brief Matches a case-insensitive expression against the texts of the
+     *        sentences normalized with NFKC and case-folded, with the case
+     *        folded out of the expression too, rather than folding the case of
+     *        each character as the expression is matched. An expression which
+     *        only looks for a string is first looked for byte to byte. The
+     *        expressions which cannot be folded, like those holding \p{Lu},
+     *        do not make use of it. */
+    void useFoldedText()
+    {
+        std::string folded;
+        if( m_cs || !foldRegex( m_regex, folded ) )
+            return;
+
+        try
+        {
+            m_foldedRegex = boost::make_u32regex( folded );
+        }
+        catch( const boost::regex_error & )
+        {
+            m_foldedRegex = boost::u32regex();
+            return;
+        }
+
+        if( !findSearchedString( folded, m_foldedString ) )
+            m_foldedString.clear();
+    }
+
+    /**@brief Selects the sentences which can match, from the suffix array or
+     *        the trigram index, and folds the texts of the sentences */
+    void prepare( const dataset & _dataset ) TATO_OVERRIDE
+    {
+        if( _dataset.size() == 0 )
+            return;
+
+        m_firstSentence = &*_dataset.begin();
+
+        if( !m_foldedRegex.empty() )
+            m_foldedText = foldedText::get( _dataset );
+
+        // most sentences are rejected by looking for the string
+        if( m_foldedText && !m_foldedString.empty() )
+            m_cost = 150;
+
+        std::shared_ptr<const suffixIndex> substrings;
+        if( m_substringIndexPath.size() && m_searchedString.size() )
+            substrings = suffixIndex::get( _dataset, m_substringIndexPath );
+
+        // a string found more than once every 4 sentences is not worth
+        // locating: each place costs a search among the sentences, and then
+        // most of the sentences would still have to be checked
+        if( substrings && substrings->count( m_searchedString ) <= _dataset.size() / 4 )
+            m_candidates = substrings->select( m_searchedString );
+        else if( m_indexPath.size() && m_grams.m_kind != gramQuery::ALL )
+            m_candidates = trigramIndex::get( _dataset, m_indexPath )->select( m_grams );
+        else
+            return;
+
+        // the sentences which are not candidates are rejected at once
+        const double candidateRatio = static_cast<double>( m_candidates.count() ) / static_cast<double>( _dataset.size() );
+        m_cost = 2 + 900 * candidateRatio;
     }
 
     /**@brief Checks that a sentence matches the regular expression
@@ -28,11 +133,62 @@ struct filterRegex : public filter
        @return true if the sentence matches */
     bool parse( const sentence & _sentence ) TATO_OVERRIDE
     {
-        return boost::u32regex_match( _sentence.str(), m_compiledRegex );
+        if( m_candidates.size() != 0 && !isCandidate( _sentence ) )
+            return false;
+
+        if( m_foldedText && &_sentence >= m_firstSentence && getPosition( _sentence ) < m_foldedText->size() )
+        {
+            const foldedText::text folded = m_foldedText->getText( getPosition( _sentence ), _sentence );
+            if( !m_foldedString.empty() && std::search( folded.first, folded.second, m_foldedString.begin(), m_foldedString.end() ) == folded.second )
+                return false;
+
+            return boost::u32regex_match( folded.first, folded.second, m_foldedRegex );
+        }
+
+        return boost::u32regex_match( _sentence.begin(), _sentence.end(), m_compiledRegex );
+    }
+
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "regex"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), which goes
+     *        through the sentence */
+    double getCost() const TATO_OVERRIDE { return m_cost; }
+
+private:
+    size_t getPosition( const sentence & _sentence ) const
+    {
+        return static_cast<size_t>( &_sentence - m_firstSentence );
+    }
+
+    bool isCandidate( const sentence & _sentence ) const
+    {
+        const size_t position = getPosition( _sentence );
+        return &_sentence >= m_firstSentence && position < m_candidates.size() && m_candidates.test( position );
     }
 
 private:
+    std::string     m_regex;
+    bool            m_cs;
     boost::u32regex m_compiledRegex;
+
+    // the expression for the folded texts, the string it looks for if that
+    // is all it does, and the folded texts
+    boost::u32regex m_foldedRegex;
+    std::string     m_foldedString;
+    std::shared_ptr<const foldedText> m_foldedText;
+
+    // the grams the sentences must hold, and those which do
+    gramQuery       m_grams;
+    std::string     m_indexPath;
+
+    // the string the expression looks for, if that is all it does
+    std::string     m_searchedString;
+    std::string     m_substringIndexPath;
+
+    const sentence* m_firstSentence;
+    sentenceBitmap  m_candidates;
+    double          m_cost;
 };
 
 NAMESPACE_END
@@ -10,14 +10,15 @@ NAMESPACE_START
 
 /**@struct filterTag
  * @brief Checks whether a sentence has a particular tag */
-struct filterTag  : public filter
+struct filterTag : public blockFilter<filterTag>
 {
     /**@brief Constructs a filterTag object
      * @param[in] _allTags A container that stores all the tags
      * @param[in] _name The name of the tag to check for */
-    filterTag( const std::string & _name, tagset & _allTags )
+    filterTag( const std::string & _name, const tagset & _allTags )
         :m_name( _name )
         ,m_tag( tagset::INVALID_TAGID )
+        ,m_tagLookedUp( false )
         ,m_allTags( _allTags )
     {
     }
@@ -27,15 +28,26 @@ struct filterTag  : public filter
     bool parse( const sentence & _sentence ) TATO_NO_THROW TATO_OVERRIDE
     {
         // if we didn’t check the tag id yet, we do it now
-        if( TATO_UNLIKELY( m_tag == tagset::INVALID_TAGID ) )
-            m_tag = m_allTags.getTagId( toLower( m_name ) );
+        if( TATO_UNLIKELY( !m_tagLookedUp ) )
+        {
+            m_tag = m_allTags.findTagId( toLower( m_name ) );
+            m_tagLookedUp = true;
+        }
 
         return m_allTags.isSentenceTagged( _sentence.getId(), m_tag );
     }
+
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "has-tag"; }
+
+    /**@brief Returns the estimated cost of a call to parse() */
+    double getCost() const TATO_OVERRIDE { return 380; }
+
 private:
     std::string m_name;  // the name of the tag
     tagset::tagId m_tag; // the id of the tag which name is m_name
-    tagset & m_allTags;  // this tells us the tags of a sentence
+    bool m_tagLookedUp;  // m_tag is INVALID_TAGID when no sentence has the tag
+    const tagset & m_allTags;  // this tells us the tags of a sentence
 };
 
 NAMESPACE_END
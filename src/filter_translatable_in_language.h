@@ -11,7 +11,7 @@ NAMESPACE_START
 
 /**@struct filterTranslatableInLanguage
  * @brief Keep sentences that are translatable in a given language */
-struct filterTranslatableInLanguage : public filter, public filterHelperTranslation
+struct filterTranslatableInLanguage : public blockFilter<filterTranslatableInLanguage>, public filterHelperTranslation
 {
     /**@brief Constructs a filterTranslatableInLanguage object
      * @param[in] _lang The language in which the sentence should be translatable */
@@ -33,6 +33,13 @@ struct filterTranslatableInLanguage : public filter, public filterHelperTranslat
         );
     }
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "is-translatable-in"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), which looks up
+     *        each translation of the sentence */
+    double getCost() const TATO_OVERRIDE { return 175; }
+
 private:
     std::string m_lang;    // The language to check for
 };
@@ -62,13 +62,20 @@ struct filterTranslationRegex : public filter, protected filterHelperTranslation
         // go through every regex and match the sentence against them
         for( auto regex = m_allRegex.begin(); match && regex != endRegexList; ++regex )
         {
-            match &= boost::u32regex_match( _sentence.str(), *regex );
+            match &= boost::u32regex_match( _sentence.begin(), _sentence.end(), *regex );
         }
 
         return match;
     }
 
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "translation-regex"; }
+
+    /**@brief Returns the estimated cost of a call to parse(), which matches
+     *        the translations of the sentence */
+    double getCost() const TATO_OVERRIDE { return 1000 + 500 * static_cast<double>( m_allRegex.size() ); }
+
 private:
     std::vector<boost::u32regex> m_allRegex; // a vector of compiled regex
 };
@@ -1,6 +1,7 @@
 #ifndef FILTER_USER_H
 #define FILTER_USER_H
 
+#include <tatoparser/dataset.h>
 #include "filter.h"
 
 NAMESPACE_START
@@ -8,7 +9,7 @@ NAMESPACE_START
 /**@struct filterUser
  * @brief Checks that a sentence belongs to an user
  */
-struct filterUser : public filter
+struct filterUser : public blockFilter<filterUser>
 {
     /**@brief Constructs a filterUser
      * @param[in] _user The name of the user to check
@@ -18,14 +19,35 @@ struct filterUser : public filter
     filterUser( const std::string & _user, bool _orphansOnly = false )
         :m_user( _user )
         ,m_orphansOnly( _orphansOnly )
+        ,m_prepared( false )
+        ,m_userId( sentence::NO_USER )
     {
     }
 
+    /**@brief Looks up the number the dataset gave to the user, so that no
+     *        name is compared afterwards */
+    void prepare( const dataset & _dataset ) TATO_OVERRIDE
+    {
+        m_userId = _dataset.findUserId( m_orphansOnly ? "\\N" : m_user );
+        m_prepared = true;
+    }
+
     /**@brief Checks that a sentence belongs to an user
      * @param[in] _sentence The sentence to check the author of
      * @return True if the passed sentence belongs to the user */
     bool parse( const sentence & _sentence ) throw() TATO_OVERRIDE
     {
+        if( m_prepared )
+        {
+            // the sentences without an author, which have no number, are
+            // orphans as well as those written by \N
+            const sentence::userId user = _sentence.getUserId();
+            if( user == sentence::NO_USER )
+                return m_orphansOnly;
+
+            return user == m_userId;
+        }
+
         bool ret = false;
         if ( m_orphansOnly )
         {
@@ -38,9 +60,19 @@ struct filterUser : public filter
     }
 
 
+    /**@brief Returns the name of the option which creates the filter */
+    const char * getName() const TATO_OVERRIDE { return "user"; }
+
+    /**@brief Returns the estimated cost of a call to parse() */
+    double getCost() const TATO_OVERRIDE { return 5; }
+
 private:
     std::string m_user;
     bool m_orphansOnly;
+
+    // the number of the user, or of \N for the orphans
+    bool m_prepared;
+    sentence::userId m_userId;
 };
 NAMESPACE_END
 
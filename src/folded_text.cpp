@@ -0,0 +1,332 @@
+#include "prec.h"
+#include "folded_text.h"
+#include "dataset_cache.h"
+#include <tatoparser/dataset.h>
+#include <unicode/normalizer2.h>
+#include <unicode/unistr.h>
+#include <unicode/bytestream.h>
+#include <unicode/utf8.h>
+#include <cctype>
+#include <cstring>
+#include <limits>
+
+NAMESPACE_START
+
+// the characters which have a meaning in a regular expression
+static const char METACHARACTERS[] = ".[]()|*+?{}^$\\";
+
+// -------------------------------------------------------------------------- //
+
+// Folds a text, and returns false if the folded text is the same
+static
+bool fold( const char * _begin, const char * _end, std::string & folded_ )
+{
+    // most texts are ASCII, which NFKC leaves as they are
+    bool isAscii = true, hasUpperCase = false;
+    for( const char * character = _begin; character != _end && isAscii; ++character )
+    {
+        isAscii = static_cast<unsigned char>( *character ) < 0x80;
+        hasUpperCase |= *character >= 'A' && *character <= 'Z';
+    }
+
+    if( isAscii )
+    {
+        if( !hasUpperCase )
+            return false;
+
+        folded_.assign( _begin, _end );
+        for( char & character : folded_ )
+            character = static_cast<char>( std::tolower( static_cast<unsigned char>( character ) ) );
+
+        return true;
+    }
+
+    UErrorCode status = U_ZERO_ERROR;
+    static const icu::Normalizer2 * const normalizer = icu::Normalizer2::getNFKCCasefoldInstance( status );
+
+#if U_ICU_VERSION_MAJOR_NUM >= 60
+    // the other texts are normalized without converting them to UTF-16
+    const icu::StringPiece utf8( _begin, static_cast<int32_t>( _end - _begin ) );
+    if( normalizer != nullptr && normalizer->isNormalizedUTF8( utf8, status ) && U_SUCCESS( status ) )
+        return false;
+
+    folded_.clear();
+    status = U_ZERO_ERROR;
+    icu::StringByteSink<std::string> sink( &folded_, static_cast<int32_t>( _end - _begin ) );
+
+    if( normalizer != nullptr )
+        normalizer->normalizeUTF8( 0, utf8, sink, nullptr, status );
+
+    if( normalizer == nullptr || U_FAILURE( status ) )
+        folded_.assign( _begin, _end );
+#else
+    const icu::UnicodeString text = icu::UnicodeString::fromUTF8( icu::StringPiece( _begin, static_cast<int32_t>( _end - _begin ) ) );
+    const icu::UnicodeString normalized = normalizer != nullptr ? normalizer->normalize( text, status ) : text;
+
+    folded_.clear();
+    if( U_FAILURE( status ) )
+        folded_.assign( _begin, _end );
+    else
+        normalized.toUTF8String( folded_ );
+#endif
+
+    return folded_.size() != static_cast<size_t>( _end - _begin ) || !std::equal( _begin, _end, folded_.begin() );
+}
+
+// -------------------------------------------------------------------------- //
+
+std::string foldText( const std::string & _text )
+{
+    std::string folded;
+    if( !fold( _text.data(), _text.data() + _text.size(), folded ) )
+        return _text;
+
+    return folded;
+}
+
+// -------------------------------------------------------------------------- //
+
+// Counts the code points of a UTF-8 text
+static
+size_t countCodePoints( const std::string & _text )
+{
+    return static_cast<size_t>( std::count_if( _text.begin(), _text.end(), []( char _byte )
+    {
+        return ( static_cast<unsigned char>( _byte ) & 0xC0 ) != 0x80;
+    } ) );
+}
+
+// Appends a folded text to an expression, escaping the characters which NFKC
+// turned into metacharacters, like '…' into '...'
+static
+void appendLiteral( const std::string & _text, std::string & regex_ )
+{
+    for( char character : _text )
+    {
+        if( character != '\0' && std::strchr( METACHARACTERS, character ) != nullptr )
+            regex_.push_back( '\\' );
+
+        regex_.push_back( character );
+    }
+}
+
+bool foldRegex( const std::string & _regex, std::string & folded_ )
+{
+    const char * const regex = _regex.data();
+    const int32_t length = static_cast<int32_t>( _regex.size() );
+
+    folded_.clear();
+
+    // the literal characters read last, folded together so that NFKC composes
+    // them as in the sentences
+    std::string literals;
+    auto flushLiterals = [&]( bool _repeated )
+    {
+        // a repetition only applies to the last character
+        std::string last;
+        if( _repeated && !literals.empty() )
+        {
+            size_t lastBegin = literals.size() - 1;
+            while( lastBegin > 0 && ( static_cast<unsigned char>( literals[lastBegin] ) & 0xC0 ) == 0x80 )
+                --lastBegin;
+
+            last = foldText( literals.substr( lastBegin ) );
+            literals.erase( lastBegin );
+        }
+
+        appendLiteral( foldText( literals ), folded_ );
+        literals.clear();
+
+        if( countCodePoints( last ) > 1 )
+        {
+            folded_ += "(?:";
+            appendLiteral( last, folded_ );
+            folded_ += ')';
+        }
+        else
+            appendLiteral( last, folded_ );
+    };
+
+    bool inBracket = false;
+    int32_t bracketBegin = 0;
+
+    for( int32_t i = 0; i < length; )
+    {
+        const int32_t begin = i;
+        UChar32 character;
+        U8_NEXT( regex, i, length, character );
+
+        if( character < 0 )
+            return false;
+
+        const std::string codePoint( regex + begin, regex + i );
+        const char next = i < length ? regex[i] : '\0';
+
+        if( character == '\\' )
+        {
+            // \. or \( stand for themselves, \d, \w, \s or \b mean the same
+            // in a folded text, \p{Lu}, \x41 or \Q...\E do not
+            const unsigned char escaped = static_cast<unsigned char>( next );
+            const bool isLiteral = escaped != '\0' && escaped < 0x80 && !std::isalnum( escaped ) && std::strchr( "<>`'", escaped ) == nullptr;
+
+            if( !isLiteral && ( escaped == '\0' || std::strchr( "dDsSwWbB<>`'123456789", escaped ) == nullptr ) )
+                return false;
+
+            if( isLiteral && !inBracket )
+                literals.push_back( static_cast<char>( escaped ) );
+            else
+            {
+                if( !inBracket )
+                    flushLiterals( false );
+
+                folded_.push_back( '\\' );
+                folded_.push_back( static_cast<char>( escaped ) );
+            }
+
+            ++i;
+        }
+        else if( inBracket )
+        {
+            if( character == '[' && next != '\0' && std::strchr( ":=.", next ) != nullptr )
+                return false;
+
+            if( character == ']' && begin > bracketBegin )
+            {
+                inBracket = false;
+                folded_.push_back( ']' );
+                continue;
+            }
+
+            // a range is kept if folding its bounds does not change what it holds
+            if( character == '-' && begin > bracketBegin && next != ']' && next != '\0' )
+            {
+                const unsigned char from = static_cast<unsigned char>( regex[begin - 1] );
+                const unsigned char to = static_cast<unsigned char>( next );
+
+                if( from >= 0x80 || to >= 0x80 || !std::isupper( from ) != !std::isupper( to ) || !std::islower( from ) != !std::islower( to ) )
+                    return false;
+
+                folded_.push_back( '-' );
+                folded_.push_back( static_cast<char>( std::tolower( to ) ) );
+                ++i;
+                continue;
+            }
+
+            // a character of a set must stay a single character
+            const std::string folded = foldText( codePoint );
+            if( countCodePoints( folded ) != 1 || ( folded != codePoint && folded.size() == 1 && !std::isalnum( static_cast<unsigned char>( folded[0] ) ) ) )
+                return false;
+
+            folded_ += folded;
+        }
+        else if( character == '[' )
+        {
+            flushLiterals( false );
+            folded_.push_back( '[' );
+            inBracket = true;
+
+            if( next == '^' )
+                folded_.push_back( regex[i++] );
+
+            // a ']' or a '-' which comes first belongs to the set
+            bracketBegin = i;
+        }
+        else if( character == '(' && next == '?' )
+        {
+            // only the groups which do not change the options
+            const std::string group = _regex.substr( static_cast<size_t>( begin ), 4 );
+            const size_t groupLength = group.compare( 0, 3, "(?:" ) == 0 || group.compare( 0, 3, "(?=" ) == 0 ||
+                                       group.compare( 0, 3, "(?!" ) == 0 || group.compare( 0, 3, "(?>" ) == 0 ? 3 :
+                                       group == "(?<=" || group == "(?<!" ? 4 : 0;
+            if( groupLength == 0 )
+                return false;
+
+            flushLiterals( false );
+            folded_ += group.substr( 0, groupLength );
+            i = begin + static_cast<int32_t>( groupLength );
+        }
+        else if( character == '{' )
+        {
+            // a repetition, whose bounds are copied as they are
+            flushLiterals( true );
+
+            const size_t end = _regex.find( '}', static_cast<size_t>( begin ) );
+            if( end == std::string::npos )
+                return false;
+
+            folded_.append( _regex, static_cast<size_t>( begin ), end + 1 - static_cast<size_t>( begin ) );
+            i = static_cast<int32_t>( end + 1 );
+        }
+        else if( character < 0x80 && std::strchr( METACHARACTERS, static_cast<char>( character ) ) != nullptr )
+        {
+            flushLiterals( std::strchr( "*+?", static_cast<char>( character ) ) != nullptr );
+            folded_.push_back( static_cast<char>( character ) );
+        }
+        else
+            literals += codePoint;
+    }
+
+    flushLiterals( false );
+    return !inBracket;
+}
+
+// -------------------------------------------------------------------------- //
+
+std::shared_ptr<const foldedText> foldedText::get( const dataset & _dataset )
+{
+    // the texts last folded, for the queries which come after
+    static datasetCache<foldedText> cache;
+
+    return cache.get( _dataset, [&_dataset]()
+    {
+        std::shared_ptr<foldedText> folded( new foldedText() );
+        if( !folded->build( _dataset ) )
+        {
+            qlog::warning << "The sentences are too long to be folded\n";
+            return std::shared_ptr<const foldedText>();
+        }
+
+        return std::shared_ptr<const foldedText>( folded );
+    } );
+}
+
+// -------------------------------------------------------------------------- //
+
+bool foldedText::build( const dataset & _dataset )
+{
+    std::string folded;
+
+    m_changed = sentenceBitmap( _dataset.size() );
+    m_begin.reserve( _dataset.size() + 1 );
+    m_begin.push_back( 0 );
+
+    size_t position = 0;
+    for( dataset::const_iterator current = _dataset.begin(); current != _dataset.end(); ++current, ++position )
+    {
+        if( fold( current->begin(), current->end(), folded ) )
+        {
+            if( m_text.size() + folded.size() > std::numeric_limits<uint32_t>::max() )
+                return false;
+
+            m_changed.set( position );
+            m_text.insert( m_text.end(), folded.begin(), folded.end() );
+        }
+
+        m_begin.push_back( static_cast<uint32_t>( m_text.size() ) );
+    }
+
+    qlog::info << "Folded " << m_changed.count() << " sentences in " << m_text.size() << " bytes\n";
+    return true;
+}
+
+// -------------------------------------------------------------------------- //
+
+foldedText::text foldedText::getText( size_t _position, const sentence & _sentence ) const
+{
+    if( !m_changed.test( _position ) )
+        return text( _sentence.begin(), _sentence.end() );
+
+    return text( m_text.data() + m_begin[_position], m_text.data() + m_begin[_position + 1] );
+}
+
+NAMESPACE_END
@@ -0,0 +1,74 @@
+#ifndef TATOPARSER_FOLDED_TEXT_H
+#define TATOPARSER_FOLDED_TEXT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bitmap.h"
+
+NAMESPACE_START
+
+struct dataset;
+struct sentence;
+
+/**@brief Normalizes a text with NFKC and folds its case, so that two texts
+ *        which differ only by the case or by the form of their characters,
+ *        like 'Ｔｏｍ' and 'tom', become the same.
+ * @param[in] _text A text, in UTF-8 */
+std::string foldText( const std::string & _text );
+
+/**@brief Rewrites a regular expression so that it matches the folded texts
+ *        as the original expression matches the texts regardless of the case.
+ *        The literal characters are folded, and the escapes and classes are
+ *        kept as they are.
+ * @param[out] folded_ The expression for the folded texts
+ * @return false if the expression holds something which cannot be folded,
+ *         like \p{Lu} or [[:upper:]] */
+bool foldRegex( const std::string & _regex, std::string & folded_ );
+
+// -------------------------------------------------------------------------- //
+
+/**@struct foldedText
+ * @brief The texts of the sentences, normalized with NFKC and case-folded,
+ *        which the case-insensitive filters compare byte to byte.
+ *
+ * The folded texts are concatenated. Only those which differ from the text
+ * of their sentence are stored, so a corpus mostly written in scripts
+ * without case costs little more than an offset per sentence. */
+struct foldedText
+{
+    typedef std::pair<const char *, const char *> text;
+
+    /**@brief Returns the folded texts of some sentences, built on first use
+     *        and kept for the next calls with the same sentences, like the
+     *        queries of a server.
+     * @return nullptr if the folded texts do not fit in 4 GB */
+    static std::shared_ptr<const foldedText> get( const dataset & _dataset );
+
+    /**@brief Returns the folded text of a sentence
+     * @param[in] _position The position of the sentence in the dataset */
+    text getText( size_t _position, const sentence & _sentence ) const;
+
+    /**@brief Returns how many sentences are folded */
+    size_t size() const { return m_changed.size(); }
+
+private:
+    foldedText(): m_text(), m_begin(), m_changed() { }
+
+    bool build( const dataset & _dataset );
+
+private:
+    // the folded texts which differ from their sentence, one after the other,
+    // and where the text of each sentence begins in it
+    std::vector<char>       m_text;
+    std::vector<uint32_t>   m_begin;
+
+    // the sentences whose folded text is in m_text
+    sentenceBitmap          m_changed;
+};
+
+NAMESPACE_END
+
+#endif // TATOPARSER_FOLDED_TEXT_H
@@ -0,0 +1,58 @@
+#ifndef LIBTATOPARSER_INPUT_STREAM_H
+#define LIBTATOPARSER_INPUT_STREAM_H
+
+#include "tatoparser/namespace.h"
+#include <cstddef>
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+/**@struct inputChunk
+ * @brief A contiguous piece of a file, made only of complete lines */
+struct inputChunk
+{
+    inputChunk()
+        :m_begin( nullptr )
+        ,m_end( nullptr )
+        ,m_buffer( static_cast<size_t>( -1 ) )
+    {
+    }
+
+    const char * begin() const { return m_begin; }
+    const char * end() const { return m_end; }
+    size_t size() const { return static_cast<size_t>( m_end - m_begin ); }
+
+    const char * m_begin;
+    const char * m_end;
+
+    // identifies the buffer the chunk lives in, for the stream that produced it
+    size_t m_buffer;
+};
+
+/**@struct inputStream
+ * @brief Hands over the content of a file chunk after chunk, so that a parser
+ *        can start working before the whole file is available.
+ *
+ * Chunks stay valid until they are released or the stream is destroyed. */
+struct inputStream
+{
+    virtual ~inputStream() { }
+
+    /**@brief Retrieves the next chunk of the file
+     * @param[out] chunk_ Filled with the next chunk
+     * @return false when the end of the file has been reached
+     * @throw invalid_file, corrupted_file if the file cannot be read */
+    virtual bool next( inputChunk & chunk_ ) = 0;
+
+    /**@brief Tells the stream that a chunk will not be read anymore, so that
+     *        its memory can be reused.
+     * @warning Never release a chunk that parsed sentences still point into. */
+    virtual void release( const inputChunk & _chunk ) = 0;
+};
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
+
+#endif // LIBTATOPARSER_INPUT_STREAM_H
@@ -4,6 +4,7 @@
 #include "tatoparser/tagset.h"
 #include "tatoparser/linkset.h"
 #include "tatoparser/listset.h"
+#include "tatoparser/statistics.h"
 #include "datainfo.h"
 #include "fast_sentence_adv_parser.h"
 #include "fast_sentence_parser.h"
@@ -11,35 +12,74 @@
 #include "fast_list_parser.h"
 #include "fast_tag_parser.h"
 #include "file_mapper.h"
+#include "compressed_file.h"
+#include "file_stream.h"
+#include "csv_diff.h"
+#include <atomic>
+#include <fstream>
+#include <unordered_set>
 
 NAMESPACE_START
 
-#pragma GCC visibility push(hidden)
-
 // -------------------------------------------------------------------------- //
 
-static ParserFlag                   g_parserFlags = 0;
-static std::unique_ptr<fileMapper>  g_sentenceMap = nullptr;
+// what a context holds, exported like the parserContext which points to it,
+// so it only holds exported types: see sentenceFiles for the others
+struct parserResources
+{
+    parserResources()
+        : m_diffText()
+        , m_progress()
+        , m_statistics( nullptr )
+        , m_quit( false )
+    {
+    }
+
+    virtual ~parserResources() { }
+
+    // the text of the sentences added by update(), which they point into
+    std::vector< std::unique_ptr<std::string> > m_diffText;
+
+    // receives the progress of the parsers
+    progressCallback m_progress;
+
+    // where the stages are recorded, if they are
+    statistics * m_statistics;
+
+    // set by cancel(), the parsers check it between two chunks
+    std::atomic<bool> m_quit;
+};
 
-static fastDetailedParser<char *>*   g_detailedParser = nullptr;
-static fastLinkParser<char *>*       g_fastLinkParser = nullptr;
-static fastSentenceParser<char *>*   g_sentenceParser = nullptr;
-static fastSentenceParser<char *>*   g_sentenceParserParallel = nullptr;
-static fastTagParser<char *>*        g_tagParser = nullptr;
-static fastListParser<char *>*       g_listParser = nullptr;
+#pragma GCC visibility push(hidden)
 
 // -------------------------------------------------------------------------- //
 
-static bool                         g_quit = false; // leave on abort
+// the resources of a context, with the files which the sentences point into
+struct sentenceFiles : public parserResources
+{
+    sentenceFiles()
+        : m_sentenceMap( nullptr )
+        , m_sentenceInput( nullptr )
+    {
+    }
+
+    std::unique_ptr<fileMapper>  m_sentenceMap;
+    std::unique_ptr<inputStream> m_sentenceInput; // when sentences.csv is not mapped
+};
 
 // -------------------------------------------------------------------------- //
 
 static
-bool isFlagSet( ParserFlag _flag )
+sentenceFiles & getSentenceFiles( parserContext & _context )
 {
-    return ( g_parserFlags & _flag ) != 0;
+    return static_cast<sentenceFiles &>( _context.getResources() );
 }
 
+// -------------------------------------------------------------------------- //
+
+// the context used by the functions which do not take one
+static std::unique_ptr<parserContext> g_defaultContext = nullptr;
+
 
 // -------------------------------------------------------------------------- //
 
@@ -58,14 +98,21 @@ std::unique_ptr<T> make_unique( Arg && arg )
 #endif
 // -------------------------------------------------------------------------- //
 
+// The files are parsed from the beginning to the end. The sentences file is
+// mapped for as long as the sentences live, the others are unmapped as soon
+// as they have been parsed.
 static
-std::unique_ptr<fileMapper> mapFileToMemory( const std::string & _file )
+std::unique_ptr<fileMapper> mapFileToMemory( parserContext & _context, const std::string & _file, mappingFlag _flags = 0 )
 {
+    scopedTimer timer( _context.getResources().m_statistics, getStageName( "map", _file ) );
     std::unique_ptr<fileMapper>  ret = nullptr;
 
+    if( _context.isFlagSet( PREFAULT ) )
+        _flags |= MAPPING_POPULATE;
+
     try
     {
-        ret = make_unique<fileMapper>( _file );
+        ret = make_unique<fileMapper>( _file, SEQUENTIAL_ACCESS, _flags );
     }
     catch( const invalid_file & exception )
     {
@@ -83,97 +130,267 @@ std::unique_ptr<fileMapper> mapFileToMemory( const std::string & _file )
     return ret;
 }
 
+// -------------------------------------------------------------------------- //
+
+// Tells whether a file should be read chunk after chunk rather than mapped
+static
+bool isStreamed( const parserContext & _context, compressionFormat _format )
+{
+    return _format != UNCOMPRESSED || _context.isFlagSet( NO_MMAP );
+}
+
+// -------------------------------------------------------------------------- //
+
+// Returns how many bytes of a file are going to be parsed, or 0 if it is not
+// known before the end, like for compressed files
+static
+size_t getSizeToParse( const std::string & _file, compressionFormat _format )
+{
+    if( _format != UNCOMPRESSED )
+        return 0;
+
+    std::ifstream file( _file.c_str(), std::ios::binary | std::ios::ate );
+    const std::streamoff size = file.is_open() ? static_cast<std::streamoff>( file.tellg() ) : 0;
+
+    return size > 0 ? static_cast<size_t>( size ) : 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+static
+std::unique_ptr<inputStream> openInputStream( const std::string & _file, compressionFormat _format )
+{
+    std::unique_ptr<inputStream> ret = nullptr;
+
+    try
+    {
+        if( _format == UNCOMPRESSED )
+            ret = make_unique<fileStream>( _file );
+        else
+            ret = make_unique<decompressedStream>( _file, _format );
+    }
+    catch( const invalid_file & exception )
+    {
+        llog::error << "Cannot open " << exception.m_filename << '\n';
+    }
+    catch( const unsupported_compression & exception )
+    {
+        llog::error << exception.m_filename << " is compressed with " << getCompressionName( _format )
+                    << ", which is not supported by this build\n";
+    }
+    catch( const std::bad_alloc & )
+    {
+        llog::error << "Out of memory\n";
+    }
+
+    return ret;
+}
+
+// -------------------------------------------------------------------------- //
+// Feeds a parser with the chunks of a stream as soon as they are available.
+// The container is only filled if the whole file could be parsed.
+template<typename PARSER, typename CONTAINER>
+static
+int parseStream( parserContext & _context, const std::string & _path, compressionFormat _format,
+                 inputStream & _input, CONTAINER & container_, bool _keepChunks, size_t & nbLines_ )
+{
+    int ret = EXIT_FAILURE;
+    CONTAINER temporaryContainer;
+    inputChunk chunk;
+    nbLines_ = 0;
+
+    // the warnings of the parser tell the lines from the start of the file
+    size_t line = 1;
+
+    parserResources & resources = _context.getResources();
+    fileProgress progress( resources.m_progress, _path, getSizeToParse( _path, _format ), resources.m_statistics );
+
+    try
+    {
+        // cancel() is noticed between two chunks
+        while( !resources.m_quit && _input.next( chunk ) )
+        {
+            const size_t nbChunkLines = static_cast<size_t>( PARSER( chunk.begin(), chunk.end() ).feed( temporaryContainer, line ) );
+            nbLines_ += nbChunkLines;
+            progress.advance( chunk.size(), nbChunkLines );
+
+            if( !_keepChunks )
+                _input.release( chunk );
+        }
+
+        if( !resources.m_quit )
+        {
+            container_ = std::move( temporaryContainer );
+            ret = EXIT_SUCCESS;
+        }
+    }
+    catch( const corrupted_file & exception )
+    {
+        llog::error << "Failed to decompress " << exception.m_filename << '\n';
+    }
+    catch( const invalid_file & exception )
+    {
+        llog::error << "Cannot read " << exception.m_filename << '\n';
+    }
+    catch( const std::bad_alloc & )
+    {
+        llog::error << "Out of memory\n";
+    }
+
+    return ret;
+}
+
+// -------------------------------------------------------------------------- //
+
+template<typename PARSER>
+static
+int parseStreamedSentences( parserContext & _context, const std::string & _sentencesPath, compressionFormat _format,
+                              datainfo & _info_, dataset & allSentences_ )
+{
+    // the sentences point into the chunks, so the stream is kept alive as
+    // long as the context
+    sentenceFiles & resources = getSentenceFiles( _context );
+    resources.m_sentenceMap = nullptr;
+    resources.m_sentenceInput = openInputStream( _sentencesPath, _format );
+
+    if( resources.m_sentenceInput == nullptr ||
+        parseStream<PARSER>( _context, _sentencesPath, _format, *resources.m_sentenceInput, allSentences_, true, _info_.m_nbSentences ) != EXIT_SUCCESS )
+        return EXIT_FAILURE;
+
+    if( _info_.m_nbSentences == 0 )
+    {
+        llog::error << _sentencesPath << " is empty\n";
+        return EXIT_FAILURE;
+    }
+
+    llog::info << "parsed " << _info_.m_nbSentences << "sentences.\n";
+
+    _info_.m_highestId = allSentences_.getHighestId();
+    llog::info << "highest id: " << _info_.m_highestId << '\n';
+
+    return EXIT_SUCCESS;
+}
+
+// -------------------------------------------------------------------------- //
+// Returns how many threads can share a task which can be split
+static
+unsigned getNbThreads( const parserContext & _context )
+{
+    return _context.isFlagSet( PARALLEL ) ? std::max( 1u, std::thread::hardware_concurrency() ) : 1;
+}
+
+// -------------------------------------------------------------------------- //
+// Returns how many lines a parser is going to find, to reserve memory before
+// it starts. The estimate is enough unless the exact count was requested.
+template<typename PARSER>
+static
+size_t countLines( parserContext & _context, const std::string & _path, const PARSER & _parser )
+{
+    scopedTimer timer( _context.getResources().m_statistics, getStageName( "count", _path ) );
+
+    const size_t nbLines = _context.isFlagSet( EXACT_COUNT ) ? _parser.countLines( getNbThreads( _context ) )
+                                                             : _parser.countLinesFast();
+    timer.setItems( nbLines );
+
+    return nbLines;
+}
+
 // -------------------------------------------------------------------------- //
 // This function treats half a deck, when the parser is run in multi-core mod
 // it returns the nb of lines which have been parsed and the id of the senten
 // which id was the highest
 static
 std::pair<size_t, sentence::id> treatHalf(
-     char * const begin, char * const end, dataset & allSentences_)
+     const parseMonitor & _monitor,
+     const char * const begin, const char * const end, dataset & allSentences_)
 {
-    fastSentenceParser<char *> parser( begin, end );
-
-    // this is ugly and buggy but that's okay: the race condition it can creat
-    // on extreme cases will just cause the program to take an extra 0.5 s to sto
-    if (g_sentenceParser)
-        g_sentenceParserParallel = &parser;
-    else
-        g_sentenceParser = &parser;
-
-    const size_t nbLinesParsed  = parser.start( allSentences_ );
-    const sentence & sentenceOfHighestId =
-        *std::max_element(
-                allSentences_.begin(), allSentences_.end(),
-                []( const sentence & _a, const sentence & _b ) { return _a.getId() < _b.getId(); }
-        );
+    fastSentenceParser<const char *> parser( begin, end );
 
-    if (g_sentenceParser == &parser)
-        g_sentenceParser = nullptr;
-    else if (g_sentenceParserParallel == &parser)
-        g_sentenceParserParallel = nullptr;
+    const size_t nbLinesParsed  = parser.start( allSentences_, _monitor );
+    const sentence::id highestId = allSentences_.getHighestId();
 
-    return std::pair<size_t, sentence::id>( nbLinesParsed, sentenceOfHighestId.getId() );
+    return std::pair<size_t, sentence::id>( nbLinesParsed, highestId );
 }
 
 static
-int parseSentencesParallel( const std::string & _sentencesPath, datainfo & _info_, dataset & allSentences_ )
+int parseSentencesParallel( parserContext & _context, const std::string & _sentencesPath, datainfo & _info_, dataset & allSentences_ )
 {
+    sentenceFiles & resources = getSentenceFiles( _context );
+
+    const compressionFormat format = detectCompression( _sentencesPath );
+    if( isStreamed( _context, format ) )
+        return parseStreamedSentences< fastSentenceParser<const char *> >( _context, _sentencesPath, format, _info_, allSentences_ );
+
     llog::info << "starting parallel parsing\n";
-    g_sentenceMap = mapFileToMemory( _sentencesPath );
-    if( g_sentenceMap == nullptr )
+    resources.m_sentenceInput = nullptr;
+    resources.m_sentenceMap = mapFileToMemory( _context, _sentencesPath, MAPPING_LONG_LIVED );
+    if( resources.m_sentenceMap == nullptr )
         return EXIT_FAILURE;
 
+    const fileMapper & sentenceMap = *resources.m_sentenceMap;
+
     // we want to know the number of lines the file contains
-    // to split the work load into different threads. We cannot
-    // just split the file in the middle as we might break a
-    // sentence in two parts.
-    size_t estimatedNbLines = 0;
+    // to reserve memory for the sentences
+    size_t expectedNbLines = 0;
     {
         fastSentenceParser<const char *> lineCounter(
-            g_sentenceMap->begin(),
-            g_sentenceMap->end()
+            sentenceMap.begin(),
+            sentenceMap.end()
         );
-        estimatedNbLines = lineCounter.countLinesFast();
-        llog::info << "estimated number of sentences: " << estimatedNbLines << '\n';
+        expectedNbLines = countLines( _context, _sentencesPath, lineCounter );
     }
 
     // if the file is empty, then we have nothing to do.
-    if (estimatedNbLines == 0)
+    if (expectedNbLines == 0)
     {
         llog::warning << _sentencesPath << " is empty.\n";
         return EXIT_SUCCESS;
     }
 
-    // we need to find the position just after the first
-    // half of the set of sentences.
-    char * splitPosition = reinterpret_cast<char*>( (reinterpret_cast<uint64_t>(g_sentenceMap->begin())/2) + (reinterpret_cast<uint64_t>(g_sentenceMap->end())/ 2) );
+    // we need to find the position just after the first half of the file. We
+    // cannot just split the file in the middle as we might break a sentence in
+    // two parts.
+    const char * splitPosition = sentenceMap.begin() + sentenceMap.getSize() / 2;
 
     // we adjust the position so that it falls after the end of a line
-    while( *splitPosition++ != '\n' )
+    while( splitPosition != sentenceMap.end() && *splitPosition++ != '\n' )
     {
-        assert( splitPosition != g_sentenceMap->end() );
     }
-    llog::info << "split pos: " << static_cast<void*>(splitPosition) << '\n';
-
-    // when we arrive here, we should be just after a '\n' character, otherwi
-    // we are in the middle of a senten
-    assert( *(splitPosition-1) == '\n' );
+    llog::info << "split pos: " << static_cast<const void *>(splitPosition) << '\n';
 
     // we need a dataset so that each thread writes in its own memory space.
+    // allSentences_ will contain all the lines in the end, once the second half
+    // has been merged into it, so it is reserved for the whole file.
     dataset secondHalfSentences;
-    secondHalfSentences.allocate( estimatedNbLines / 2 );
+    {
+        fastSentenceParser<const char *> lineCounter( splitPosition, sentenceMap.end() );
+        const size_t expectedNbLinesOfSecondHalf = countLines( _context, _sentencesPath, lineCounter );
+
+        if( expectedNbLinesOfSecondHalf != 0 )
+            secondHalfSentences.allocate( expectedNbLinesOfSecondHalf );
+    }
 
-    // allSentences_ will actually contain all the lines in the end
-    allSentences_.allocate( 2 * estimatedNbLines );
+    allSentences_.allocate( expectedNbLines );
+
+    // both halves are read at the same time: fault their pages in ahead of
+    // the two parsers
+    resources.m_sentenceMap->startReadahead( 2 );
+
+    // both halves count their progress together
+    fileProgress progress( resources.m_progress, _sentencesPath, sentenceMap.getSize(), resources.m_statistics );
+    const parseMonitor monitor( resources.m_quit, &progress );
 
     std::future< std::pair< size_t, sentence::id > > futureResultTop =
-        std::async( std::launch::async, treatHalf, g_sentenceMap->begin(), splitPosition, std::ref(allSentences_) );
+        std::async( std::launch::async, treatHalf, std::cref( monitor ),
+                    sentenceMap.begin(), splitPosition, std::ref(allSentences_) );
 
-    std::pair< size_t, sentence::id > resultBottom = treatHalf( splitPosition, g_sentenceMap->end(), std::ref(secondHalfSentences) );
+    std::pair< size_t, sentence::id > resultBottom =
+        treatHalf( monitor, splitPosition, sentenceMap.end(), std::ref(secondHalfSentences) );
 
     // in addition to computing the highest id, this will ensure that
     // the two threads are done executing
     std::pair<size_t, sentence::id> resultTop = futureResultTop.get();
+    resources.m_sentenceMap->stopReadahead();
 
     const sentence::id highestIdOfTop = resultTop.second;
     const sentence::id highestIdOfBottom = resultBottom.second;
@@ -190,27 +407,29 @@ int parseSentencesParallel( const std::string & _sentencesPath, datainfo & _info
 }
 
 static
-int parseSentences( const std::string & _sentencesPath, datainfo & _info_, dataset & allSentences_ )
+int parseSentences( parserContext & _context, const std::string & _sentencesPath, datainfo & _info_, dataset & allSentences_ )
 {
     int ret = EXIT_FAILURE;
+    sentenceFiles & resources = getSentenceFiles( _context );
+
+    const compressionFormat format = detectCompression( _sentencesPath );
+    if( isStreamed( _context, format ) )
+        return parseStreamedSentences< fastSentenceParser<const char *> >( _context, _sentencesPath, format, _info_, allSentences_ );
 
     // map "sentences.csv" to some address in our virtual space
-    g_sentenceMap = mapFileToMemory( _sentencesPath );
+    resources.m_sentenceInput = nullptr;
+    resources.m_sentenceMap = mapFileToMemory( _context, _sentencesPath, MAPPING_LONG_LIVED );
 
-    if( g_sentenceMap != nullptr )
+    if( resources.m_sentenceMap != nullptr )
     {
         // create the parser
-        fastSentenceParser<char *> sentenceParser(
-            g_sentenceMap->begin(),
-            g_sentenceMap->end()
+        fastSentenceParser<const char *> sentenceParser(
+            resources.m_sentenceMap->begin(),
+            resources.m_sentenceMap->end()
         );
 
-        // we need to set a global reference to the parser so that a signal can stop it
-        // this can happen if the user presses CTRL-C
-        g_sentenceParser = &sentenceParser;
-
         // allocate memory for the sentence structure
-        _info_.m_nbSentences = sentenceParser.countLinesFast();
+        _info_.m_nbSentences = countLines( _context, _sentencesPath, sentenceParser );
 
         if( _info_.m_nbSentences <= 0 )
         {
@@ -224,27 +443,21 @@ int parseSentences( const std::string & _sentencesPath, datainfo & _info_, datas
         }
         catch( const std::bad_alloc & )
         {
-            g_sentenceParser = nullptr;
             llog::error << "Not enough memory.\n";
             return ret;
         }
 
-        _info_.m_nbSentences = sentenceParser.start( allSentences_ );
+        // the parser stops between two chunks if the user presses CTRL-C
+        fileProgress progress( resources.m_progress, _sentencesPath, resources.m_sentenceMap->getSize(), resources.m_statistics );
+        _info_.m_nbSentences = sentenceParser.start( allSentences_, parseMonitor( resources.m_quit, &progress ) );
 
         llog::info << "parsed " << _info_.m_nbSentences << "sentences.\n";
 
-        // retrieve the sentence of highest id so as to be able to create containers
-        // of the right size to store links and tags
-        const sentence & sentenceOfHighestId =
-            *std::max_element(
-                allSentences_.begin(), allSentences_.end(),
-                []( const sentence & _a, const sentence & _b ) { return _a.getId() < _b.getId(); }
-            );
-
-        llog::info << "highest id: " << sentenceOfHighestId.getId() << '\n';
-        _info_.m_highestId = sentenceOfHighestId.getId();
+        // the parser kept track of the highest id, which is needed to create
+        // containers of the right size to store links and tags
+        _info_.m_highestId = allSentences_.getHighestId();
+        llog::info << "highest id: " << _info_.m_highestId << '\n';
 
-        g_sentenceParser = nullptr;
         ret = EXIT_SUCCESS;
     }
 
@@ -254,34 +467,53 @@ int parseSentences( const std::string & _sentencesPath, datainfo & _info_, datas
 // -------------------------------------------------------------------------- //
 
 static
-int parseLinks( const std::string & _linksPath, datainfo & _info_, linkset & allLinks_ )
+int parseLinks( parserContext & _context, const std::string & _linksPath, datainfo & _info_, linkset & allLinks_ )
 {
     int ret = EXIT_FAILURE;
+    parserResources & resources = _context.getResources();
+
+    const compressionFormat format = detectCompression( _linksPath );
+    if( isStreamed( _context, format ) )
+    {
+        std::unique_ptr<inputStream> linksInput = openInputStream( _linksPath, format );
+        size_t nbLinks = 0;
+
+        if( linksInput != nullptr )
+            ret = parseStream< fastLinkParser<const char *> >( _context, _linksPath, format, *linksInput, allLinks_, false, nbLinks );
+
+        _info_.m_nbLinks = static_cast<decltype( _info_.m_nbLinks )>( nbLinks );
+        return ret;
+    }
 
     // we map tags.csv to somewhere in our virtual space
-    std::unique_ptr<fileMapper> linksMap = mapFileToMemory( _linksPath );
+    std::unique_ptr<fileMapper> linksMap = mapFileToMemory( _context, _linksPath );
 
     if( linksMap != nullptr )
     {
         try
         {
             // we create the parser
-            fastLinkParser<char *> linkParser( linksMap->begin(), linksMap->end() );
-            g_fastLinkParser = &linkParser;
+            fastLinkParser<const char *> linkParser( linksMap->begin(), linksMap->end() );
+
+            // the links are indexed by their first id: knowing the highest one
+            // spares growing the index, even when the sentences have not been
+            // parsed yet
+            const sentence::id lastFirstId = linkParser.getLastFirstId();
+            if( lastFirstId > _info_.m_highestId )
+                _info_.m_highestId = lastFirstId;
 
             // we allocate memory for the structure that will store the links
-            _info_.m_nbLinks = linkParser.countLines();
+            _info_.m_nbLinks = static_cast<decltype( _info_.m_nbLinks )>( countLines( _context, _linksPath, linkParser ) );
             allLinks_.allocate( _info_ );
 
             // we parse the file and store the data
-            linkParser.start( allLinks_ );
+            fileProgress progress( resources.m_progress, _linksPath, linksMap->getSize(), resources.m_statistics );
+            linkParser.start( allLinks_, parseMonitor( resources.m_quit, &progress ) );
 
-            g_fastLinkParser = nullptr;
             ret = EXIT_SUCCESS;
         }
         catch( const std::bad_alloc & )
         {
-            g_fastLinkParser = nullptr;
             llog::error << "Out of memory\n";
         }
     }
@@ -292,25 +524,36 @@ int parseLinks( const std::string & _linksPath, datainfo & _info_, linkset & all
 // -------------------------------------------------------------------------- //
 
 static
-int parseTags( const std::string & _tagPath, datainfo &, tagset & allTags_ )
+int parseTags( parserContext & _context, const std::string & _tagPath, datainfo &, tagset & allTags_ )
 {
     int ret = EXIT_FAILURE;
+    parserResources & resources = _context.getResources();
+
+    const compressionFormat format = detectCompression( _tagPath );
+    if( isStreamed( _context, format ) )
+    {
+        std::unique_ptr<inputStream> tagInput = openInputStream( _tagPath, format );
+        size_t nbTags = 0;
 
-    std::unique_ptr<fileMapper> tagMap = mapFileToMemory( _tagPath );
+        if( tagInput != nullptr )
+            ret = parseStream< fastTagParser<const char *> >( _context, _tagPath, format, *tagInput, allTags_, false, nbTags );
+
+        return ret;
+    }
+
+    std::unique_ptr<fileMapper> tagMap = mapFileToMemory( _context, _tagPath );
 
     if( tagMap != nullptr )
     {
         try
         {
-            fastTagParser<char *> tagParser( tagMap->begin(), tagMap->end() );
-            g_tagParser = &tagParser;
-            tagParser.start( allTags_ );
-            g_tagParser = nullptr;
+            fastTagParser<const char *> tagParser( tagMap->begin(), tagMap->end() );
+            fileProgress progress( resources.m_progress, _tagPath, tagMap->getSize(), resources.m_statistics );
+            tagParser.start( allTags_, parseMonitor( resources.m_quit, &progress ), getNbThreads( _context ) );
             ret = EXIT_SUCCESS;
         }
         catch( const std::bad_alloc & )
         {
-            g_tagParser =nullptr;
             llog::error << "An error occurred while parsing file " << _tagPath << std::endl;
         }
     }
@@ -321,21 +564,26 @@ int parseTags( const std::string & _tagPath, datainfo &, tagset & allTags_ )
 // -------------------------------------------------------------------------- //
 
 static
-int parseDetailed( const std::string & _sentencesPath, datainfo & _info_, dataset & allSentences_ )
+int parseDetailed( parserContext & _context, const std::string & _sentencesPath, datainfo & _info_, dataset & allSentences_ )
 {
     int ret = EXIT_FAILURE;
+    sentenceFiles & resources = getSentenceFiles( _context );
+
+    const compressionFormat format = detectCompression( _sentencesPath );
+    if( isStreamed( _context, format ) )
+        return parseStreamedSentences< fastDetailedParser<const char *> >( _context, _sentencesPath, format, _info_, allSentences_ );
 
     // map "sentences_detailed.csv" to some address in our virtual space
-    g_sentenceMap = mapFileToMemory( _sentencesPath );
+    resources.m_sentenceInput = nullptr;
+    resources.m_sentenceMap = mapFileToMemory( _context, _sentencesPath, MAPPING_LONG_LIVED );
 
-    if( g_sentenceMap != nullptr )
+    if( resources.m_sentenceMap != nullptr )
     {
         // create the parser
-        fastDetailedParser<char *> detailedParser( g_sentenceMap->begin(), g_sentenceMap->end() );
-        g_detailedParser = &detailedParser;
+        fastDetailedParser<const char *> detailedParser( resources.m_sentenceMap->begin(), resources.m_sentenceMap->end() );
 
         // allocate memory for the sentence structure
-        _info_.m_nbSentences = detailedParser.countLinesFast();
+        _info_.m_nbSentences = countLines( _context, _sentencesPath, detailedParser );
 
         if( _info_.m_nbSentences <= 0 )
         {
@@ -349,24 +597,17 @@ int parseDetailed( const std::string & _sentencesPath, datainfo & _info_, datase
         }
         catch( const std::bad_alloc & )
         {
-            g_detailedParser = nullptr;
             llog::error << "Not enough memory.\n";
             return ret;
         }
 
-        _info_.m_nbSentences = detailedParser.start( allSentences_ );
-        g_detailedParser = nullptr;
-
-        // retrieve the sentence of highest id so as to be able to create containers
-        // of the right size to store links and tags
-        const sentence & sentenceOfHighestId =
-            *std::max_element(
-                allSentences_.begin(), allSentences_.end(),
-                []( const sentence & _a, const sentence & _b ) { return _a.getId() < _b.getId(); }
-            );
+        fileProgress progress( resources.m_progress, _sentencesPath, resources.m_sentenceMap->getSize(), resources.m_statistics );
+        _info_.m_nbSentences = detailedParser.start( allSentences_, parseMonitor( resources.m_quit, &progress ) );
 
-        llog::info << "highest id: " << sentenceOfHighestId.getId() << '\n';
-        _info_.m_highestId = sentenceOfHighestId.getId();
+        // the parser kept track of the highest id, which is needed to create
+        // containers of the right size to store links and tags
+        _info_.m_highestId = allSentences_.getHighestId();
+        llog::info << "highest id: " << _info_.m_highestId << '\n';
 
         ret = EXIT_SUCCESS;
     }
@@ -375,23 +616,67 @@ int parseDetailed( const std::string & _sentencesPath, datainfo & _info_, datase
 }
 // -------------------------------------------------------------------------- //
 static
-int parseLists( const std::string & _listPath, datainfo & _info, listset & allLists_ )
+int parseLists( parserContext & _context, const std::string & _listPath, datainfo & _info, listset & allLists_ )
 {
     int ret = EXIT_FAILURE;
-    std::unique_ptr<fileMapper> linksMap = mapFileToMemory( _listPath );
+    parserResources & resources = _context.getResources();
+
+    const compressionFormat format = detectCompression( _listPath );
+    if( isStreamed( _context, format ) )
+    {
+        std::unique_ptr<inputStream> listInput = openInputStream( _listPath, format );
+        size_t nbLines = 0;
+
+        if( listInput != nullptr )
+            ret = parseStream< fastListParser<const char *> >( _context, _listPath, format, *listInput, allLists_, false, nbLines );
+
+        return ret;
+    }
+
+    std::unique_ptr<fileMapper> linksMap = mapFileToMemory( _context, _listPath );
 
     if ( nullptr != linksMap )
     {
-        fastListParser<char*> parser( linksMap->begin(), linksMap->end() );
-        g_listParser = &parser;
-        parser.start( allLists_ );
-        g_listParser = nullptr;
+        fastListParser<const char *> parser( linksMap->begin(), linksMap->end() );
+        fileProgress progress( resources.m_progress, _listPath, linksMap->getSize(), resources.m_statistics );
+        parser.start( allLists_, parseMonitor( resources.m_quit, &progress ), getNbThreads( _context ) );
         ret = EXIT_SUCCESS;
     }
 
     return ret;
 }
 
+// -------------------------------------------------------------------------- //
+// parses sentences.csv with the parser the flags ask for
+static
+int parseAllSentences( parserContext & _context, const std::string & _sentencesPath, datainfo & _info_, dataset & allSentences_ )
+{
+    return _context.isFlagSet( DETAILED ) ?
+        parseDetailed( _context, _sentencesPath, _info_, allSentences_ ) :
+            _context.isFlagSet( PARALLEL ) ?
+                parseSentencesParallel( _context, _sentencesPath, _info_, allSentences_ ) :
+                parseSentences        ( _context, _sentencesPath, _info_, allSentences_ );
+}
+
+// -------------------------------------------------------------------------- //
+// returns a function which parses a file into a container the first time it
+// is queried. The context outlives the container, so it can be referred to.
+template<typename CONTAINER>
+static
+typename lazyLoader<CONTAINER>::loadFunction
+deferParsing( parserContext & _context, const std::string & _path,
+              int ( *_parse )( parserContext &, const std::string &, datainfo &, CONTAINER & ) )
+{
+    parserContext * const context = &_context;
+    return [context, _path, _parse]( CONTAINER & container_ )
+    {
+        llog::info << "loading " << _path << " on first use\n";
+
+        datainfo info = datainfo();
+        _parse( *context, _path, info, container_ );
+    };
+}
+
 // -------------------------------------------------------------------------- //
 static
 void startLogging( bool verbose )
@@ -417,16 +702,60 @@ void startLogging( bool verbose )
 
 // -------------------------------------------------------------------------- //
 
+parserContext::parserContext( ParserFlag _flags )
+    : m_flags( _flags )
+    , m_resources( new sentenceFiles() )
+{
+}
+
+// -------------------------------------------------------------------------- //
+
+parserContext::~parserContext()
+{
+    delete m_resources;
+}
+
+// -------------------------------------------------------------------------- //
+
+void parserContext::cancel()
+{
+    // only an atomic store, which is safe in a signal handler
+    m_resources->m_quit = true;
+}
+
+// -------------------------------------------------------------------------- //
+
+bool parserContext::isCancelled() const
+{
+    return m_resources->m_quit;
+}
+
+// -------------------------------------------------------------------------- //
+
+void parserContext::setProgressCallback( progressCallback _callback )
+{
+    m_resources->m_progress = std::move( _callback );
+}
+
+// -------------------------------------------------------------------------- //
+
+void parserContext::setStatistics( statistics * _statistics )
+{
+    m_resources->m_statistics = _statistics;
+}
+
+// -------------------------------------------------------------------------- //
+
 int init( ParserFlag _flags )
 {
-    assert( g_parserFlags == 0 );
+    assert( g_defaultContext == nullptr );
 
-    g_parserFlags = _flags;
+    g_defaultContext = make_unique<parserContext>( _flags );
 
     llog::init();
     llog::set_output( std::cerr );
 
-    startLogging( isFlagSet( VERBOSE ) );
+    startLogging( ( _flags & VERBOSE ) != 0 );
 
     return EXIT_SUCCESS;
 }
@@ -435,8 +764,7 @@ int init( ParserFlag _flags )
 
 int terminate()
 {
-    g_sentenceMap = nullptr;
-    g_parserFlags = 0;
+    g_defaultContext = nullptr;
 
     llog::destroy();
     return EXIT_SUCCESS;
@@ -468,6 +796,28 @@ int parse_( dataset & allSentences_,
 
 // -------------------------------------------------------------------------- //
 
+int parse_( parserContext & _context,
+            dataset & allSentences_,
+            linkset & allLinks_,
+            tagset  & allTags_,
+            listset & allLists_,
+            const char * _sentencePath,
+            const char * _linksPath,
+            const char * _tagPath,
+            const char * _listPath )
+{
+    assert( _sentencePath );
+    assert( _linksPath );
+    assert( _tagPath );
+    assert( _listPath );
+
+    return parse( _context, allSentences_, allLinks_, allTags_, allLists_,
+                  std::string( _sentencePath ), std::string( _linksPath ),
+                  std::string( _tagPath ), std::string( _listPath ) );
+}
+
+// -------------------------------------------------------------------------- //
+
 int parse( dataset & allSentences_,
            linkset & allLinks_,
            tagset  & allTags_,
@@ -477,39 +827,113 @@ int parse( dataset & allSentences_,
            const std::string & _tagPath,
            const std::string & _listPath )
 {
-    datainfo info; //holds information about the number of sentences, of links, etc.
-                   //then dataset and linkset can allocate memory in one shot.
+    assert( g_defaultContext != nullptr );
+
+    return parse( *g_defaultContext, allSentences_, allLinks_, allTags_, allLists_,
+                  _sentencePath, _linksPath, _tagPath, _listPath );
+}
+
+// -------------------------------------------------------------------------- //
+
+int parse( parserContext & _context,
+           dataset & allSentences_,
+           linkset & allLinks_,
+           tagset  & allTags_,
+           listset & allLists_,
+           const std::string & _sentencePath,
+           const std::string & _linksPath,
+           const std::string & _tagPath,
+           const std::string & _listPath )
+{
+    sentenceFiles & resources = getSentenceFiles( _context );
+    scopedTimer timer( resources.m_statistics, "parse (all files)" );
+
+    datainfo info = datainfo(); //holds information about the number of sentences, of links, etc.
+                                //then dataset and linkset can allocate memory in one shot.
+
+    const bool parseLinksFile = _linksPath.size() && !_context.isFlagSet( NO_LINKS ) && !_context.isFlagSet( LAZY );
+    const bool parseTagsFile = _tagPath.size() && !_context.isFlagSet( NO_TAGS ) && !_context.isFlagSet( LAZY );
+    const bool parseListsFile = _listPath.size() && !_context.isFlagSet( NO_LISTS ) && !_context.isFlagSet( LAZY );
+
+    if( _context.isFlagSet( LAZY ) )
+    {
+        // the files are parsed by the first query of the links, the tags or
+        // the lists, if there is one
+        if( _linksPath.size() && !_context.isFlagSet( NO_LINKS ) )
+            allLinks_.loadLazily( deferParsing( _context, _linksPath, parseLinks ) );
+
+        if( _tagPath.size() && !_context.isFlagSet( NO_TAGS ) )
+            allTags_.loadLazily( deferParsing( _context, _tagPath, parseTags ) );
+
+        if( _listPath.size() && !_context.isFlagSet( NO_LISTS ) )
+            allLists_.loadLazily( deferParsing( _context, _listPath, parseLists ) );
+    }
 
     int parsingSuccess = EXIT_SUCCESS;
 
-    if( _sentencePath.size() )
+    if( _context.isFlagSet( PARALLEL ) )
     {
-        parsingSuccess = isFlagSet( DETAILED ) ?
-                         parseDetailed( _sentencePath, info, allSentences_ ) :
-                            isFlagSet( PARALLEL ) ?
-                                parseSentencesParallel( _sentencePath, info, allSentences_ ) :
-                                parseSentences        ( _sentencePath, info, allSentences_);
+        // the links, the tags and the lists do not depend on the sentences:
+        // each file is parsed on its own thread while the sentences are
+        // parsed on this one, and they are only joined to build the index
+        datainfo linksInfo = datainfo(), tagsInfo = datainfo(), listsInfo = datainfo();
+        std::future<int> links, tags, lists;
+
+        if( parseLinksFile )
+            links = std::async( std::launch::async, parseLinks, std::ref( _context ), std::cref( _linksPath ), std::ref( linksInfo ), std::ref( allLinks_ ) );
+
+        if( parseTagsFile )
+            tags = std::async( std::launch::async, parseTags, std::ref( _context ), std::cref( _tagPath ), std::ref( tagsInfo ), std::ref( allTags_ ) );
+
+        if( parseListsFile )
+            lists = std::async( std::launch::async, parseLists, std::ref( _context ), std::cref( _listPath ), std::ref( listsInfo ), std::ref( allLists_ ) );
+
+        if( _sentencePath.size() )
+            parsingSuccess = parseAllSentences( _context, _sentencePath, info, allSentences_ );
+
+        for( std::future<int> * task : { &links, &tags, &lists } )
+        {
+            if( task->valid() && task->get() == EXIT_FAILURE )
+                parsingSuccess = EXIT_FAILURE;
+        }
+
+        info.m_nbLinks = linksInfo.m_nbLinks;
     }
+    else
+    {
+        if( _sentencePath.size() )
+            parsingSuccess = parseAllSentences( _context, _sentencePath, info, allSentences_ );
 
-    if( parsingSuccess != EXIT_FAILURE && _linksPath.size() && !isFlagSet( NO_LINKS ) && !g_quit )
-        parsingSuccess = parseLinks( _linksPath, info, allLinks_ );
+        if( parsingSuccess != EXIT_FAILURE && parseLinksFile && !resources.m_quit )
+            parsingSuccess = parseLinks( _context, _linksPath, info, allLinks_ );
 
-    if( parsingSuccess != EXIT_FAILURE && _tagPath.size() && !isFlagSet( NO_TAGS ) && !g_quit)
-        parsingSuccess = parseTags( _tagPath, info, allTags_ );
+        if( parsingSuccess != EXIT_FAILURE && parseTagsFile && !resources.m_quit)
+            parsingSuccess = parseTags( _context, _tagPath, info, allTags_ );
 
-    if( parsingSuccess != EXIT_FAILURE && _listPath.size() && !isFlagSet( NO_LISTS ) && !g_quit)
-        parsingSuccess = parseLists( _listPath, info, allLists_ );
+        if( parsingSuccess != EXIT_FAILURE && parseListsFile && !resources.m_quit)
+            parsingSuccess = parseLists( _context, _listPath, info, allLists_ );
+    }
 
-    if( parsingSuccess == EXIT_SUCCESS && !g_quit)
+    if( parsingSuccess == EXIT_SUCCESS && !resources.m_quit)
     {
-        const sentence::id highestLinkId = allLinks_.getHighestSentenceId();
+        // links which are not loaded yet cannot be accounted for, and
+        // asking for their highest id would load them
+        const sentence::id highestLinkId = _context.isFlagSet( LAZY ) ? sentence::INVALID_ID : allLinks_.getHighestSentenceId();
         if( highestLinkId > info.m_highestId )
             info.m_highestId = highestLinkId;
 
+        // the sentences file is not parsed anymore, but the sentences still
+        // point into it: its pages should not be dropped as soon as they
+        // have been read, as MADV_SEQUENTIAL allows
+        if( resources.m_sentenceMap != nullptr )
+            resources.m_sentenceMap->advise( NORMAL_ACCESS );
+
         // create an container to retrieve sentences from id in a very fast manner
         try
         {
-            allSentences_.prepare( info );
+            scopedTimer timer( resources.m_statistics, "index sentences" );
+            timer.setItems( info.m_nbSentences );
+            allSentences_.prepare( info, getNbThreads( _context ) );
         }
         catch( const std::bad_alloc & )
         {
@@ -518,23 +942,194 @@ int parse( dataset & allSentences_,
         }
     }
 
-    g_quit = false;
+    // a cancelled parse leaves the containers incomplete
+    if( resources.m_quit )
+    {
+        llog::info << "parsing cancelled\n";
+        parsingSuccess = EXIT_FAILURE;
+    }
+
+    resources.m_quit = false;
 
     return parsingSuccess;
 }
 
+// -------------------------------------------------------------------------- //
+// reads a diff and passes it to a function which applies it
+template<typename APPLY>
+static
+int applyDiff( const std::string & _path, APPLY _apply )
+{
+    if( _path.empty() )
+        return EXIT_SUCCESS;
+
+    try
+    {
+        csvDiff diff = readDiff( _path );
+        _apply( diff );
+        return EXIT_SUCCESS;
+    }
+    catch( const invalid_file & exception )
+    {
+        llog::error << "Cannot read " << exception.m_filename << '\n';
+    }
+    catch( const std::logic_error & )
+    {
+        // thrown by std::stoul
+        llog::error << _path << " is not a diff of a csv file\n";
+    }
+    catch( const std::bad_alloc & )
+    {
+        llog::error << "Out of memory\n";
+    }
+
+    return EXIT_FAILURE;
+}
+
+// -------------------------------------------------------------------------- //
+
+template<typename PARSER>
+static
+void updateSentences( parserContext & _context, csvDiff & diff_, dataset & allSentences_ )
+{
+    dataset removedSentences, addedSentences;
+    size_t removedLine = 1, addedLine = 1;
+    PARSER( diff_.m_removed.data(), diff_.m_removed.data() + diff_.m_removed.size() ).feed( removedSentences, removedLine );
+
+    // the sentences point into the text of the diff, which is kept as long
+    // as the context
+    std::vector< std::unique_ptr<std::string> > & diffText = _context.getResources().m_diffText;
+    diffText.push_back( make_unique<std::string>( std::move( diff_.m_added ) ) );
+    const std::string & addedText = *diffText.back();
+    PARSER( addedText.data(), addedText.data() + addedText.size() ).feed( addedSentences, addedLine );
+
+    // a modified sentence is both removed and added: it is replaced, so that
+    // the dates of modification can be compared
+    std::unordered_set<sentence::id> addedIds;
+    for( const sentence & added : addedSentences )
+        addedIds.insert( added.getId() );
+
+    size_t nbRemoved = 0, nbUpdated = 0;
+    for( const sentence & removed : removedSentences )
+    {
+        if( addedIds.count( removed.getId() ) == 0 && allSentences_.removeSentence( removed.getId() ) )
+            ++nbRemoved;
+    }
+
+    for( const sentence & added : addedSentences )
+    {
+        if( allSentences_.updateSentence( added ) )
+            ++nbUpdated;
+    }
+
+    llog::info << "removed " << nbRemoved << " sentences, added or modified " << nbUpdated << '\n';
+}
+
+// -------------------------------------------------------------------------- //
+
+int update( dataset & allSentences_,
+            linkset & allLinks_,
+            tagset  & allTags_,
+            listset & allLists_,
+            const std::string & _sentenceDiff,
+            const std::string & _linksDiff,
+            const std::string & _tagDiff,
+            const std::string & _listDiff )
+{
+    assert( g_defaultContext != nullptr );
+
+    return update( *g_defaultContext, allSentences_, allLinks_, allTags_, allLists_,
+                   _sentenceDiff, _linksDiff, _tagDiff, _listDiff );
+}
+
+// -------------------------------------------------------------------------- //
+
+int update( parserContext & _context,
+            dataset & allSentences_,
+            linkset & allLinks_,
+            tagset  & allTags_,
+            listset & allLists_,
+            const std::string & _sentenceDiff,
+            const std::string & _linksDiff,
+            const std::string & _tagDiff,
+            const std::string & _listDiff )
+{
+    scopedTimer timer( _context.getResources().m_statistics, "update (all diffs)" );
+
+    // the lines which are removed are applied first, so that a line which
+    // is replaced by a slightly different one is not lost
+    int ret = applyDiff( _sentenceDiff, [&]( csvDiff & diff_ )
+    {
+        if( _context.isFlagSet( DETAILED ) )
+            updateSentences< fastDetailedParser<const char *> >( _context, diff_, allSentences_ );
+        else
+            updateSentences< fastSentenceParser<const char *> >( _context, diff_, allSentences_ );
+    } );
+
+    // the files which were not parsed have no data to update
+    ret |= applyDiff( _context.isFlagSet( NO_LINKS ) ? std::string() : _linksDiff, [&]( const csvDiff & _diff )
+    {
+        forEachDiffLine( _diff.m_removed, [&]( unsigned long _a, const std::string & _b )
+        {
+            allLinks_.removeLink( static_cast<sentence::id>( _a ), static_cast<sentence::id>( std::stoul( _b ) ) );
+        } );
+        forEachDiffLine( _diff.m_added, [&]( unsigned long _a, const std::string & _b )
+        {
+            allLinks_.insertLink( static_cast<sentence::id>( _a ), static_cast<sentence::id>( std::stoul( _b ) ) );
+        } );
+    } );
+
+    ret |= applyDiff( _context.isFlagSet( NO_TAGS ) ? std::string() : _tagDiff, [&]( const csvDiff & _diff )
+    {
+        forEachDiffLine( _diff.m_removed, [&]( unsigned long _id, const std::string & _tagName )
+        {
+            allTags_.removeTag( static_cast<sentence::id>( _id ), _tagName );
+        } );
+        forEachDiffLine( _diff.m_added, [&]( unsigned long _id, const std::string & _tagName )
+        {
+            allTags_.addTag( static_cast<sentence::id>( _id ), _tagName );
+        } );
+    } );
+
+    ret |= applyDiff( _context.isFlagSet( NO_LISTS ) ? std::string() : _listDiff, [&]( const csvDiff & _diff )
+    {
+        forEachDiffLine( _diff.m_removed, [&]( unsigned long _id, const std::string & _listName )
+        {
+            allLists_.removeFromList( static_cast<sentence::id>( _id ), _listName );
+        } );
+        forEachDiffLine( _diff.m_added, [&]( unsigned long _id, const std::string & _listName )
+        {
+            allLists_.insertIntoList( static_cast<sentence::id>( _id ), _listName );
+        } );
+    } );
+
+    return ret == EXIT_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 // -------------------------------------------------------------------------- //
 
 void cancel()
 {
-    if (g_detailedParser != nullptr) g_detailedParser->abort();
-    if (g_fastLinkParser != nullptr) g_fastLinkParser->abort();
-    if (g_sentenceParser != nullptr) g_sentenceParser->abort();
-    if (g_sentenceParserParallel != nullptr) g_sentenceParserParallel->abort();
-    if (g_tagParser      != nullptr) g_tagParser->abort();
-    if (g_listParser     != nullptr) g_listParser->abort();
+    if( g_defaultContext != nullptr )
+        g_defaultContext->cancel();
+}
+
+// -------------------------------------------------------------------------- //
+
+void setProgressCallback( progressCallback _callback )
+{
+    assert( g_defaultContext != nullptr );
+
+    g_defaultContext->setProgressCallback( std::move( _callback ) );
+}
+
+// -------------------------------------------------------------------------- //
+
+void setStatistics( statistics * _statistics )
+{
+    assert( g_defaultContext != nullptr );
 
-    g_quit = true;
+    g_defaultContext->setStatistics( _statistics );
 }
 
 
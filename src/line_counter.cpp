@@ -0,0 +1,134 @@
+#include "prec_library.h"
+#include "line_counter.h"
+#include <cmath>
+
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+// how many windows are counted to estimate the number of lines
+static const size_t NB_SAMPLES = 32;
+
+// the size of a window
+static const size_t SAMPLE_SIZE = 64 * 1024;
+
+// -------------------------------------------------------------------------- //
+
+size_t countNewLines( const char * _begin, const char * _end )
+{
+    size_t count = 0;
+
+#ifdef __SSE2__
+    const __m128i newLine = _mm_set1_epi8( '\n' );
+    const __m128i zero = _mm_setzero_si128();
+
+    // the matches are summed up in 16 bytes counters, which are added to the
+    // total before they can overflow, every 255 iterations
+    while( _end - _begin >= 16 )
+    {
+        const size_t nbBlocks = std::min<size_t>( 255, static_cast<size_t>( _end - _begin ) / 16 );
+        __m128i counters = zero;
+
+        for( size_t block = 0; block < nbBlocks; ++block, _begin += 16 )
+        {
+            const __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i *>( _begin ) );
+
+            // a match is 0xff, that is -1
+            counters = _mm_sub_epi8( counters, _mm_cmpeq_epi8( bytes, newLine ) );
+        }
+
+        const __m128i sums = _mm_sad_epu8( counters, zero );
+        count += static_cast<size_t>( _mm_cvtsi128_si32( sums ) )
+               + static_cast<size_t>( _mm_cvtsi128_si32( _mm_srli_si128( sums, 8 ) ) );
+    }
+#endif
+
+    return count + static_cast<size_t>( std::count( _begin, _end, '\n' ) );
+}
+
+// -------------------------------------------------------------------------- //
+
+// a file often does not end with a '\n', in which case its last line is not
+// counted by countNewLines
+static
+size_t countLastLine( const char * _begin, const char * _end )
+{
+    return _begin != _end && *( _end - 1 ) != '\n' ? 1 : 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+size_t countLinesParallel( const char * _begin, const char * _end, unsigned _nbThreads )
+{
+    const size_t size = static_cast<size_t>( _end - _begin );
+
+    if( _nbThreads <= 1 || size < _nbThreads * SAMPLE_SIZE )
+        return countNewLines( _begin, _end ) + countLastLine( _begin, _end );
+
+    const size_t partSize = size / _nbThreads;
+    std::vector< std::future<size_t> > counts;
+
+    for( unsigned part = 1; part < _nbThreads; ++part )
+    {
+        const char * const partBegin = _begin + part * partSize;
+        const char * const partEnd = part + 1 == _nbThreads ? _end : partBegin + partSize;
+        counts.push_back( std::async( std::launch::async, countNewLines, partBegin, partEnd ) );
+    }
+
+    size_t count = countNewLines( _begin, _begin + partSize );
+    for( std::future<size_t> & partCount : counts )
+        count += partCount.get();
+
+    return count + countLastLine( _begin, _end );
+}
+
+// -------------------------------------------------------------------------- //
+
+size_t estimateLines( const char * _begin, const char * _end )
+{
+    const size_t size = static_cast<size_t>( _end - _begin );
+
+    // counting everything is not much longer than sampling
+    if( size <= 2 * NB_SAMPLES * SAMPLE_SIZE )
+        return countNewLines( _begin, _end ) + countLastLine( _begin, _end );
+
+    // the buffer is cut into as many strata as there are windows, and a
+    // window is picked at random in each of them, so that a file which is
+    // sorted by language is sampled evenly
+    const size_t stratumSize = size / NB_SAMPLES;
+    uint32_t random = 2463534242u;
+
+    double sum = 0., sumOfSquares = 0.;
+    for( size_t sample = 0; sample < NB_SAMPLES; ++sample )
+    {
+        // xorshift: the samples only need to be spread, not unpredictable
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+
+        const size_t offset = sample * stratumSize + random % ( stratumSize - SAMPLE_SIZE );
+        const double count = static_cast<double>( countNewLines( _begin + offset, _begin + offset + SAMPLE_SIZE ) );
+
+        sum += count;
+        sumOfSquares += count * count;
+    }
+
+    // the upper bound of the confidence interval is taken, so that the
+    // container rarely has to grow
+    const double mean = sum / NB_SAMPLES;
+    const double variance = std::max( 0., ( sumOfSquares - sum * mean ) / ( NB_SAMPLES - 1 ) );
+    const double upperBound = mean + 3. * std::sqrt( variance / NB_SAMPLES );
+    const size_t estimate = static_cast<size_t>( std::ceil( upperBound * static_cast<double>( size ) / SAMPLE_SIZE ) ) + 1;
+
+    llog::info << "estimated " << estimate << " lines from " << NB_SAMPLES << " samples\n";
+
+    return estimate;
+}
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
@@ -0,0 +1,33 @@
+#ifndef LIBTATOPARSER_LINE_COUNTER_H
+#define LIBTATOPARSER_LINE_COUNTER_H
+
+#include "tatoparser/namespace.h"
+#include <cstddef>
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+/**@brief Counts the '\n' characters of a buffer, 16 bytes at a time
+ * @param[in] _begin The first character of the buffer
+ * @param[in] _end The end of the buffer */
+size_t countNewLines( const char * _begin, const char * _end );
+
+/**@brief Counts the lines of a buffer exactly, splitting the work between threads
+ * @param[in] _nbThreads How many threads count at the same time
+ * @return The number of lines, counting a last line with no '\n' */
+size_t countLinesParallel( const char * _begin, const char * _end, unsigned _nbThreads );
+
+/**@brief Estimates the number of lines of a buffer by counting the lines of a
+ *        few windows picked at random.
+ *
+ * The estimate is an upper bound of the real count in all but rare cases,
+ * so that it can be used to reserve memory without reallocating later. Small
+ * buffers are counted exactly. */
+size_t estimateLines( const char * _begin, const char * _end );
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
+
+#endif // LIBTATOPARSER_LINE_COUNTER_H
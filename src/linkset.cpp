@@ -10,6 +10,9 @@ NAMESPACE_START
 linkset::linkset()
     :m_links()
     ,m_offsets()
+    ,m_highestId( sentence::INVALID_ID )
+    ,m_lastId( sentence::INVALID_ID )
+    ,m_loader()
 {
 }
 
@@ -17,11 +20,11 @@ linkset::linkset()
 
 void linkset::allocate( const datainfo & _datainfo )
 {
-    // prepare link array
-    m_links.resize( static_cast<size_t>( _datainfo.m_nbLinks + _datainfo.m_nbLinks/100, 0 ) );
+    // prepare link array. m_nbLinks is an upper bound already
+    m_links.reserve( static_cast<size_t>( _datainfo.m_nbLinks ) );
 
     // prepare ptrs array
-    m_offsets.resize( _datainfo.m_highestId + 1 );
+    m_offsets.resize( std::max<size_t>( _datainfo.m_highestId + 1, m_offsets.size() ) );
 
     llog::info << "Allocated "
                << ( m_links.capacity()*sizeof( sentence::id ) +
@@ -32,6 +35,71 @@ void linkset::allocate( const datainfo & _datainfo )
 
 // -------------------------------------------------------------------------- //
 
+void linkset::insertLink( sentence::id _a, sentence::id _b )
+{
+    assert( sentence::INVALID_ID != _a );
+    assert( sentence::INVALID_ID != _b );
+
+    if( areLinked( _a, _b ) )
+        return;
+
+    if( _a >= static_cast<sentence::id>( m_offsets.size() ) )
+        m_offsets.resize( std::max<size_t>( _a + 1, 2 * m_offsets.size() ) );
+
+    std::pair<size_t, size_t> & offsets = m_offsets[_a];
+
+    if( offsets.first == offsets.second )
+    {
+        offsets.first = offsets.second = m_links.size();
+    }
+    else if( offsets.second != m_links.size() )
+    {
+        // other links follow those of _a: they are copied to the end, where
+        // there is room for one more, and their old place is left unused
+        const size_t nbLinks = offsets.second - offsets.first;
+        m_links.reserve( m_links.size() + nbLinks + 1 );
+        for( size_t link = offsets.first; link != offsets.second; ++link )
+            m_links.push_back( m_links[link] );
+
+        offsets.second = m_links.size();
+        offsets.first = offsets.second - nbLinks;
+    }
+
+    m_links.push_back( _b );
+    offsets.second = m_links.size();
+
+    const sentence::id highest = _a > _b ? _a : _b;
+    if( highest > m_highestId )
+        m_highestId = highest;
+
+    // addLink must not append to the links of the last sentence it saw
+    m_lastId = sentence::INVALID_ID;
+}
+
+// -------------------------------------------------------------------------- //
+
+bool linkset::removeLink( sentence::id _a, sentence::id _b )
+{
+    loadIfNeeded();
+
+    if( _a >= static_cast<sentence::id>( m_offsets.size() ) )
+        return false;
+
+    std::pair<size_t, size_t> & offsets = m_offsets[_a];
+    const linksArray::iterator first = m_links.begin() + offsets.first, last = m_links.begin() + offsets.second;
+    const linksArray::iterator link = std::find( first, last, _b );
+
+    if( link == last )
+        return false;
+
+    // the order of the links of a sentence does not matter
+    *link = *( last - 1 );
+    --offsets.second;
+    return true;
+}
+
+// -------------------------------------------------------------------------- //
+
 sentence::id getFirstSentenceTranslation(
     const dataset & _dataset,
     const linkset & _linkset,
@@ -53,12 +121,4 @@ sentence::id getFirstSentenceTranslation(
     return sentence::INVALID_ID;
 }
 
-//---------------------------------------------------------------------------- //
-
-sentence::id linkset::getHighestSentenceId() const
-{
-    const auto highestIdIterator = std::max_element( m_links.begin(), m_links.end() );
-    return highestIdIterator == m_links.end() ? /* sentence::INVALID_ID */ 0 : *highestIdIterator;
-}
-
 NAMESPACE_END
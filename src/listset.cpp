@@ -16,90 +16,85 @@ std::string toLower( const std::string & _name )
 // -------------------------------------------------------------------------- //
 void listset::addSentenceToList( sentence::id _id, const std::string & _name )
 {
-    using namespace llog;
-
-    const std::string & lowerCaseName = toLower( _name );
-
-    const list_hash & hash = computeHash( lowerCaseName );
-    llog::debug << "adding sentence " << color( green ) << _id << color() << " to list " << color( yellow ) << lowerCaseName << color() << " (hash: " << color( cyan ) << hash << color() << ")\n";
-    offset off = findOffset( hash );
-
-    // the offset has not been found, so we create an entry
-    if( static_cast<offset>( -1 ) == off )
-        addNewList( hash );
-
-    assert( static_cast<offset>( -1 ) != findOffset( hash ) );
-
-    off = findOffset( hash );
-    list & l = getList( off );
-    l.push_back( _id );
+    addSentenceToList( _id, _name.data(), _name.data() + _name.size() );
 }
 
 // -------------------------------------------------------------------------- //
-bool listset::isSentenceInList( sentence::id _id, const std::string & _name ) const
+void listset::insertIntoList( sentence::id _id, const std::string & _name )
 {
-    return isSentenceInList( _id, computeHash( toLower( _name ) ) );
+    if( !isSentenceInList( _id, _name ) )
+        addSentenceToList( _id, _name );
 }
 
 // -------------------------------------------------------------------------- //
-bool listset::isSentenceInList( sentence::id _id, list_hash _hash ) const
+bool listset::removeFromList( sentence::id _id, const std::string & _name )
 {
-    bool found = false;
-    const offset off = findOffset( _hash );
+    loadIfNeeded();
 
-    if( static_cast<offset>( -1 ) != off )
-    {
-        const list & l = getList( off );
-        found = std::find( l.begin(), l.end(), _id ) != l.end();
-    }
+    const listId found = m_names.find( _name.data(), _name.data() + _name.size(), true );
+    if( found == INVALID_LISTID || found > m_lists.size() )
+        return false;
+
+    list & l = m_lists[ found - 1 ];
+    const list::iterator position = std::find( l.begin(), l.end(), _id );
+    if( position == l.end() )
+        return false;
 
-    return found;
+    *position = l.back();
+    l.pop_back();
+    return true;
 }
 
 // -------------------------------------------------------------------------- //
-void listset::addNewList( list_hash _hash )
+bool listset::isSentenceInList( sentence::id _id, const std::string & _name ) const
 {
-    assert( m_offsets.find( _hash ) == m_offsets.end() );
-    m_lists.push_back( list() );
-    try
-    {
-        m_offsets.insert( std::make_pair( _hash, m_lists.size() - 1 ) );
-    }
-    catch( ... )
-    {
-        m_lists.pop_back();
-        throw;
-    }
+    return isSentenceInList( _id, findListId( _name ) );
 }
 
 // -------------------------------------------------------------------------- //
-listset::list_hash listset::computeHash( const std::string & _name )
+bool listset::isSentenceInList( sentence::id _id, listId _list ) const
 {
-    assert( toLower( _name ) == _name ); // prerequisite
-
-    static std::hash<std::string> hasher;
-    return hasher( _name );
+    const list * const l = findList( _list );
+    return l != nullptr && std::find( l->begin(), l->end(), _id ) != l->end();
 }
 
 // -------------------------------------------------------------------------- //
-listset::offset listset::findOffset( list_hash _hash ) const
+listset::listId listset::findListId( const std::string & _name ) const
 {
-    const auto ret = m_offsets.find( _hash );
-    return ( m_offsets.end() == ret ) ? static_cast<offset>( -1 ) : ret->second;
+    loadIfNeeded();
+
+    return m_names.find( _name.data(), _name.data() + _name.size(), true );
 }
 
 // -------------------------------------------------------------------------- //
-const listset::list & listset::getList( const offset & _offset ) const
+const listset::list * listset::findList( listId _list ) const
 {
-    assert( _offset < m_lists.size() );
-    return m_lists[ _offset ];
+    loadIfNeeded();
+
+    return _list == INVALID_LISTID || _list > m_lists.size() ? nullptr : &m_lists[ _list - 1 ];
 }
 
 // -------------------------------------------------------------------------- //
-listset::list & listset::getList( const offset & _offset )
+void listset::merge( listset && _other )
 {
-    assert( _offset < m_lists.size() );
-    return m_lists[ _offset ];
+    for( listId otherList = 1; otherList <= _other.m_names.size(); ++otherList )
+    {
+        const std::string name = _other.m_names.getName( otherList );
+        const listId newList = m_names.intern( name.data(), name.data() + name.size(), false );
+
+        if( otherList > _other.m_lists.size() )
+            continue;
+
+        list & otherSentences = _other.m_lists[ otherList - 1 ];
+        if( newList > m_lists.size() )
+            m_lists.resize( newList );
+
+        list & sentences = m_lists[ newList - 1 ];
+        if( sentences.empty() )
+            sentences.swap( otherSentences );
+        else
+            sentences.insert( sentences.end(), otherSentences.begin(), otherSentences.end() );
+    }
 }
 
 // -------------------------------------------------------------------------- //
@@ -107,9 +102,7 @@ bool listset::doesListExist( const std::string & _listName ) const
 {
     assert( toLower( _listName ) == _listName ); // prerequisite
 
-    const list_hash hash = computeHash( _listName );
-    const offset off = findOffset( hash );
-    return off != static_cast< offset >( -1 );
+    return findListId( _listName ) != INVALID_LISTID;
 }
 
 NAMESPACE_END
@@ -4,14 +4,19 @@
 #include <tatoparser/tagset.h>
 #include <tatoparser/listset.h>
 #include <tatoparser/interface_lib.h>
+#include <tatoparser/statistics.h>
 #include "options.h"
 #include "filter_id.h"
 #include "filter_tag.h"
 #include "filter_regex.h"
 #include "filter_fuzzy.h"
 #include "display.h"
+#include "query.h"
+#include "server.h"
+#include "report.h"
 #include <iostream>
 #include <fstream>
+#include <mutex>
 
 #ifdef HAVE_CURL_CURL_H
 #   include "hdownload.hpp"
@@ -32,13 +37,18 @@ static const char TAG_URL[] = "http://tatoeba.org/files/downloads/tags.csv";
 static const char LIST_URL[] = "http://tatoeba.org/files/downloads/lists.csv";
 
 void startLog( bool _verbose );
-void displaySentence( userOptions & _options, dataset & _allSentences, linkset & _allLinks, const sentence & _sentence, unsigned _lineNumber, display & _out );
+std::string findCsvFile( const std::string & _csvPath, const std::string & _filename );
+std::string findDiffFile( const std::string & _diffPath, const std::string & _filename );
+bool csvFileExists( const std::string & _csvPath, const std::string & _filename );
+std::vector<std::string> getForwardedArguments( int argc, char * argv[] );
+void drawProgress( const parseProgress & _progress );
 
 #ifdef HAVE_CURL_CURL_H
 bool downloadIf( bool _condition, std::string _url, std::string _destinationFile );
 #endif
 
-static volatile bool quit = false;
+// set by the signal handler, and read by the threads of the server
+static std::atomic<bool> quit( false );
 
 // -------------------------------------------------------------------------- //
 #ifdef HAVE_SIGNAL_H
@@ -116,6 +126,11 @@ int main( int argc, char * argv[] )
         qlog::error << "Invalid parameter value\n";
         return EXIT_FAILURE;
     }
+    catch( const invalid_query & err )
+    {
+        qlog::error << err.what() << '\n';
+        return EXIT_FAILURE;
+    }
 
     startLog( options.isVerbose() );
 
@@ -140,7 +155,7 @@ int main( int argc, char * argv[] )
 
     try
     {
-        options.getFilters( allSentences, allLinks, allTags, allLists, allFilters );
+        options.getFilters( allSentences, allLinks, allTags, allLists, csvPath, allFilters );
     }
     catch( const boost::regex_error & err )
     {
@@ -148,6 +163,11 @@ int main( int argc, char * argv[] )
                     << qlog::color() << err.what() << '\n';
         return EXIT_FAILURE;
     }
+    catch( const boost::program_options::error & err )
+    {
+        qlog::error << err.what() << '\n';
+        return EXIT_FAILURE;
+    }
 
     if( options.isVersionRequested() )
     {
@@ -163,18 +183,47 @@ int main( int argc, char * argv[] )
         return EXIT_FAILURE;
     }
 
+    // a client lets the server parse the files and answer the query
+    const std::string connectPath = options.getConnectPath();
+    if( connectPath.size() )
+        return forwardQuery( connectPath, getForwardedArguments( argc, argv ) );
+
+    // the stages of the run are only timed with --stats
+    const std::string statisticsFormat = options.getStatisticsFormat();
+    if( statisticsFormat.size() && statisticsFormat != "text" && statisticsFormat != "json" )
+    {
+        qlog::error << "--stats expects text or json, not " << statisticsFormat << '\n';
+        return EXIT_FAILURE;
+    }
+
+    statistics runStatistics;
+    statistics * const recordedStatistics = statisticsFormat.size() ? &runStatistics : nullptr;
+
     bool skipFiltering = options.justParse();
 
+    // a server cannot know which files the queries will need, so it parses
+    // all those there are, when they are first needed
+    const std::string servePath = options.getServePath();
+    const bool serving = servePath.size() > 0;
+
+    const bool parseLinksFile = serving ? csvFileExists( csvPath, LINKS_FILENAME ) : options.isItNecessaryToParseLinksFile();
+    const bool parseTagFile = serving ? csvFileExists( csvPath, TAG_FILENAME ) : options.isItNecessaryToParseTagFile();
+    const bool parseDetailedFile = serving ? csvFileExists( csvPath, DETAILED_FILENAME ) : options.isItNecessaryToParseDetailedFile();
+    const bool parseListFile = serving ? csvFileExists( csvPath, LIST_FILENAME ) : options.isItNecessaryToParseListFile();
 
     // call the parsing library
     const int libraryInit =
         init(
-            ( options.isItNecessaryToParseLinksFile() ? 0 : NO_LINKS ) |
-            ( options.isItNecessaryToParseTagFile() ? 0 : NO_TAGS ) |
+            ( parseLinksFile ? 0 : NO_LINKS ) |
+            ( parseTagFile ? 0 : NO_TAGS ) |
             ( options.isVerbose() ? VERBOSE : 0 ) |
-            ( options.isItNecessaryToParseDetailedFile() ? DETAILED : 0 ) |
-            ( options.isItNecessaryToParseListFile() ? 0 : NO_LISTS ) |
-            ( options.disableParallel() ? 0 : PARALLEL )
+            ( parseDetailedFile ? DETAILED : 0 ) |
+            ( parseListFile ? 0 : NO_LISTS ) |
+            ( options.disableParallel() ? 0 : PARALLEL ) |
+            ( options.prefault() ? PREFAULT : 0 ) |
+            ( options.disableMmap() ? NO_MMAP : 0 ) |
+            ( options.exactCount() ? EXACT_COUNT : 0 ) |
+            ( options.lazy() || serving ? LAZY : 0 )
         );
 
     if( libraryInit == EXIT_SUCCESS )
@@ -183,109 +232,83 @@ int main( int argc, char * argv[] )
         if( options.downloadRequested() )
         {
             // download files if they don't exist
-            downloadIf( !options.isItNecessaryToParseDetailedFile(), SENTENCES_URL, SENTENCES_FILENAME );
-            downloadIf( options.isItNecessaryToParseDetailedFile(), DETAILED_URL, DETAILED_FILENAME );
-            downloadIf( options.isItNecessaryToParseLinksFile(), LINKS_URL, LINKS_FILENAME );
-            downloadIf( options.isItNecessaryToParseTagFile(), TAG_URL, TAG_FILENAME );
-            downloadIf( options.isItNecessaryToParseListFile(), LIST_URL, LIST_FILENAME );
+            downloadIf( !parseDetailedFile, SENTENCES_URL, SENTENCES_FILENAME );
+            downloadIf( parseDetailedFile, DETAILED_URL, DETAILED_FILENAME );
+            downloadIf( parseLinksFile, LINKS_URL, LINKS_FILENAME );
+            downloadIf( parseTagFile, TAG_URL, TAG_FILENAME );
+            downloadIf( parseListFile, LIST_URL, LIST_FILENAME );
         }
 #       endif
 
+        if( options.showProgress() )
+            setProgressCallback( drawProgress );
+
+        setStatistics( recordedStatistics );
+
         const int libraryParsing =
             parse( allSentences, allLinks, allTags, allLists,
-                   options.isItNecessaryToParseDetailedFile() ?
-                   csvPath + '/' + DETAILED_FILENAME     :
-                   csvPath + '/' + SENTENCES_FILENAME,
-                   csvPath + '/' + LINKS_FILENAME,
-                   csvPath + '/' + TAG_FILENAME,
-                   csvPath + '/' + LIST_FILENAME );
+                   parseDetailedFile ?
+                   findCsvFile( csvPath, DETAILED_FILENAME )  :
+                   findCsvFile( csvPath, SENTENCES_FILENAME ),
+                   findCsvFile( csvPath, LINKS_FILENAME ),
+                   findCsvFile( csvPath, TAG_FILENAME ),
+                   findCsvFile( csvPath, LIST_FILENAME ) );
+
+        // the files parsed lazily by the filters would draw over the output
+        if( options.showProgress() )
+        {
+            setProgressCallback( progressCallback() );
+            std::cerr << std::endl;
+        }
 
         skipFiltering |= ( libraryParsing != EXIT_SUCCESS );
+
+        const std::string & diffPath = options.getDiffPath();
+        if( !skipFiltering && diffPath.size() )
+        {
+            const int libraryUpdate =
+                update( allSentences, allLinks, allTags, allLists,
+                        findDiffFile( diffPath, parseDetailedFile ? DETAILED_FILENAME : SENTENCES_FILENAME ),
+                        findDiffFile( diffPath, LINKS_FILENAME ),
+                        findDiffFile( diffPath, TAG_FILENAME ),
+                        findDiffFile( diffPath, LIST_FILENAME ) );
+
+            skipFiltering |= ( libraryUpdate != EXIT_SUCCESS );
+        }
     }
     else
         skipFiltering = true;
 
-    if( !skipFiltering )
-    {
-        options.treatTranslations( allLinks, allFilters );
+    int status = EXIT_SUCCESS;
 
-        // if a list has beeg given, check if the list exists
-        const std::string & lowerCaseListName = toLower( options.getListName() );
-
-        if( lowerCaseListName.size() && allLists.doesListExist( lowerCaseListName ) == false )
-        {
-            qlog::error << "list \"" << lowerCaseListName << "\" does not exist in lists.csv" << qlog::color() << '\n';
-            skipFiltering = true;
-        }
+    if( !skipFiltering && serving )
+    {
+        status = serve( servePath, csvPath, allSentences, allLinks, allTags, allLists, quit );
     }
-
-    ///////////////////////////
-    //  filtering sentences  //
-    ///////////////////////////
-    if( !skipFiltering )
+    else if( !skipFiltering )
     {
-        std::vector<const sentence *> filteredSentences;
-
-        // go through every sentence and see if it matches the filter
-        auto endFilter = allFilters.end();
-        unsigned printedLineNumber = 0;
-
-        bool shouldDisplay = true, keepSentence = true;
-
-        for( const sentence & sentence : allSentences )
+        try
         {
-            if (quit)
-                break;
-
-            if( sentence.getId() == sentence::INVALID_ID )
-                continue;
-
-            keepSentence = true;
-
-            for( auto filter = allFilters.begin(); keepSentence && filter != endFilter; ++filter )
-            {
-                keepSentence &= ( *filter )->parse( sentence );
-            }
-
-            // display the sentence if it is seleted by all the filters
-            if( keepSentence )
-            {
-                filteredSentences.push_back( &sentence );
-            }
+            runQuery( options, allFilters, allSentences, allLinks, allLists, *out, quit, recordedStatistics );
         }
-
-        /////////////////////////////////////
-        //  processing filtered sentences  //
-        /////////////////////////////////////
-        for( const sentence * sentence : filteredSentences )
+        catch( const unknown_list & )
         {
-            if (quit)
-                break;
-
-            assert(nullptr != sentence);
-
-            if( sentence->getId() == sentence::INVALID_ID )
-                continue;
-            shouldDisplay = true;
-
-            for( auto filter = allFilters.begin(); shouldDisplay && filter != endFilter; ++filter )
-            {
-                shouldDisplay &= ( *filter )->postProcess( *sentence );
-            }
-
-            if( shouldDisplay )
-            {
-                displaySentence( options, allSentences, allLinks, *sentence, ++printedLineNumber, *out );
-            }
+            qlog::error << "list \"" << toLower( options.getListName() ) << "\" does not exist in lists.csv" << qlog::color() << '\n';
         }
     }
 
+    if( recordedStatistics != nullptr )
+    {
+        std::cout.flush();
+        writeStatistics( std::cerr, runStatistics, statisticsFormat == "json" );
+    }
+
     #ifdef NAMESPACE
     NAMESPACE ::
     #endif
     terminate();
 
-    return EXIT_SUCCESS;
+    return status;
 }
 
 // -------------------------------------------------------------------------- //
@@ -314,6 +337,81 @@ void startLog( bool verbose )
 
 // -------------------------------------------------------------------------- //
 
+/**@brief Finds a csv file, or a compressed version of it
+ * @param[in] _csvPath The directory the file should be in
+ * @param[in] _filename The name of the file, like "sentences.csv"
+ * @return The path to the first file that exists among _filename, _filename.gz,
+ *         _filename.bz2, _filename.xz, and the archives published by Tatoeba
+ *         (like sentences.tar.bz2). The path to _filename if none does. */
+std::string findCsvFile( const std::string & _csvPath, const std::string & _filename )
+{
+    static const char * const COMPRESSED_SUFFIXES[] = { ".gz", ".bz2", ".xz" };
+
+    const std::string path = _csvPath + '/' + _filename;
+    const std::string archiveStem = _csvPath + '/' + _filename.substr( 0, _filename.rfind( ".csv" ) ) + ".tar";
+
+    std::vector<std::string> candidates( 1, path );
+    for( const char * suffix : COMPRESSED_SUFFIXES )
+        candidates.push_back( path + suffix );
+    for( const char * suffix : COMPRESSED_SUFFIXES )
+        candidates.push_back( archiveStem + suffix );
+
+    for( const std::string & candidate : candidates )
+    {
+        if( std::ifstream( candidate.c_str() ).is_open() )
+        {
+            qlog::info( candidate != path ) << "Using " << candidate << '\n';
+            return candidate;
+        }
+    }
+
+    return path;
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Finds the diff of a csv file
+ * @param[in] _diffPath The directory the diff should be in
+ * @param[in] _filename The name of the csv file, like "sentences.csv"
+ * @return The path to _filename.diff, or an empty string if it does not exist */
+std::string findDiffFile( const std::string & _diffPath, const std::string & _filename )
+{
+    const std::string path = _diffPath + '/' + _filename + ".diff";
+    return std::ifstream( path.c_str() ).is_open() ? path : std::string();
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Checks if a csv file, or a compressed version of it, exists */
+bool csvFileExists( const std::string & _csvPath, const std::string & _filename )
+{
+    return std::ifstream( findCsvFile( _csvPath, _filename ).c_str() ).is_open();
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Gets the arguments of the command line which make up the query sent
+ *        to a server, that is all of them but --connect and the program name */
+std::vector<std::string> getForwardedArguments( int argc, char * argv[] )
+{
+    static const char CONNECT_OPTION[] = "--connect";
+    std::vector<std::string> arguments;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string argument = argv[i];
+
+        if( argument == CONNECT_OPTION )
+            ++i;
+        else if( argument.compare( 0, sizeof( CONNECT_OPTION ), std::string( CONNECT_OPTION ) + '=' ) != 0 )
+            arguments.push_back( argument );
+    }
+
+    return arguments;
+}
+
+// -------------------------------------------------------------------------- //
+
 #ifdef HAVE_CURL_CURL_H
 /**@brief Download an url to a file if a condition is met
  * @param[in] _condition If this parameter evals to tru, then the download is started.
@@ -367,48 +465,36 @@ bool downloadIf( bool _condition, std::string _url, std::string _filename )
 }
 #endif
 
-
 // -------------------------------------------------------------------------- //
 
-void displaySentence( userOptions & _options, dataset & _allSentences, linkset & _allLinks, const sentence & _sentence, unsigned _lineNumber, display & _out )
+/**@brief Draws a progress bar on the error output, so that it does not mix
+ *        with the sentences. The files parsed in parallel share the same line. */
+void drawProgress( const parseProgress & _progress )
 {
-    using namespace qlog;
-    std::string translationLanguage = _options.getFirstTranslationLanguage();
+    static const size_t BAR_WIDTH = 30;
+    static std::mutex drawing;
 
-    display::flag options { display::DISPLAY_NONE };
+    std::string path( _progress.m_path );
+    const size_t lastSlash = path.find_last_of( '/' );
+    if( lastSlash != std::string::npos )
+        path.erase( 0, lastSlash + 1 );
 
-    // option -n
-    if( _options.displayLineNumbers() )
-        options |= display::DISPLAY_LINE_NUMBER;
+    std::ostringstream line;
+    line << '\r' << path << ' ';
 
-    // option -i
-    if( _options.displayIds() )
-        options |= display::DISPLAY_IDS;
-
-    // option --display-lang
-    if( _options.displayLanguages() )
-        options |= display::DISPLAY_LANGUAGES;
-
-    // find the first-translation sentence, if necessary
-    sentence * firstTranslation = nullptr;
-    if( _options.displayFirstTranslation() )
+    if( _progress.m_bytesTotal > 0 )
     {
-        options |= display::DISPLAY_FIRST_TRANSL;
-
-        // find a suitable translation
-        const sentence::id firstTranslationId =
-            getFirstSentenceTranslation(
-                _allSentences,
-                _allLinks,
-                _sentence.getId(),
-                translationLanguage
-            );
-
-        if( firstTranslationId != sentence::INVALID_ID
-                && _allSentences[firstTranslationId] )
-            firstTranslation = _allSentences[firstTranslationId];
+        const size_t parsed = std::min( _progress.m_bytesParsed, _progress.m_bytesTotal );
+        const size_t filled = parsed * BAR_WIDTH / _progress.m_bytesTotal;
+
+        line << '[' << std::string( filled, '#' ) << std::string( BAR_WIDTH - filled, ' ' ) << "] "
+             << parsed * 100 / _progress.m_bytesTotal << "% ";
     }
+    else
+        line << _progress.m_bytesParsed / ( 1024 * 1024 ) << " MiB ";
+
+    line << _progress.m_linesParsed << " lines   ";
 
-    // display the sentence
-    _out.writeSentence( _sentence, options, _lineNumber, firstTranslation );
+    std::lock_guard<std::mutex> lock( drawing );
+    std::cerr << line.str() << std::flush;
 }
@@ -11,6 +11,8 @@
 #include "filter_fuzzy.h"
 #include "filter_translatable_in_language.h"
 #include "filter_user.h"
+#include "filter_query.h"
+#include "filter_known_chars.h"
 #include <tatoparser/dataset.h>
 #include <tatoparser/tagset.h>
 #include <tatoparser/linkset.h>
@@ -48,6 +50,7 @@ userOptions::userOptions()
     ,m_visibleOptions()
     ,m_vm()
     ,m_separator( "\t" )
+    ,m_query()
     ,m_configFileDescriptions()
     ,m_configFileCsvPath()
     ,m_configFileAcceptedLanguages()
@@ -60,6 +63,18 @@ userOptions::userOptions()
         ( "csv-path", po::value<std::string>(), "Sets the path where sentences.csv, links.csv and tags.csv will be found." )
         ( "config-path", po::value<std::string>(), "Sets the path of the config file. ~/.tatoparser will be used by default." )
         ( "disable-parallel", "Use only one core to process the file." )
+        ( "prefault", "Read the csv files into memory before parsing them. Faster on slow disks if there is enough memory." )
+        ( "no-mmap", "Read the csv files in large blocks instead of mapping them. Faster on network volumes." )
+        ( "exact-count", "Count the lines of the csv files before parsing them, instead of estimating their number." )
+        ( "lazy", "Parse links.csv, tags.csv and lists.csv only when the filters first need them." )
+        ( "regex-index", "Check --regex only on the sentences which hold its literal strings, found in a trigram index of the sentences. The index is kept in sentences.trigrams next to the csv files, and built again when the sentences change." )
+        ( "substring-index", "Find the sentences of a --regex which only looks for a string, like '.*XYZ.*', in a suffix array of the sentences. The array is kept in sentences.suffixes next to the csv files, and built again when the sentences change." )
+        ( "folded-text", "Match --regex-nocs and --fuzzy against the sentences normalized with NFKC and case-folded, copied once the csv files have been parsed. --fuzzy then ignores the case and the width of the characters." )
+        ( "apply-diff", po::value<std::string>(), "After parsing, apply the diffs sentences.csv.diff, links.csv.diff, tags.csv.diff and lists.csv.diff found in this directory, made with diff -u." )
+        ( "serve", po::value<std::string>(), "Parse the csv files once, then answer the queries sent to this UNIX socket with --connect." )
+        ( "connect", po::value<std::string>(), "Send the query to a tatoparser started with --serve on this UNIX socket, instead of parsing the csv files." )
+        ( "progress", "Draw the progress of the parsing on the error output." )
+        ( "stats", po::value<std::string>()->implicit_value( "text" ), "Write how long each stage took and what each filter kept on the error output, as text, or as json with --stats=json." )
 #ifdef HAVE_CURL_CURL_H
         ( "download", "Download necessary csv files if not found." )
 #endif
@@ -85,8 +100,14 @@ userOptions::userOptions()
         ( "user,u", po::value<std::string>(), "Keep the sentences which belong to this user only." )
         ( "in-list", po::value<std::string>(), "Keep the sentences which belong to a given list." )
         ( "orphan", "Keep sentences that belong to no-one." )
+        ( "only-chars", po::value<std::string>(), "Keep the sentences written only with these characters. Spaces and punctuation marks are always accepted." )
+        ( "known-chars-file", po::value<std::string>(), "Keep the sentences written only with the characters of this file, like the characters one has learnt." )
+        ( "max-unknown-chars", po::value<unsigned>(), "With --only-chars or --known-chars-file, also keep the sentences which hold at most this many other characters." )
         ( "translates,t", po::value<sentence::id>(), "Keep the indirect and direct translations of a given sentence." )
         ( "fuzzy,f", po::value<fuzzyFilterOption>()->multitoken(), "Looks for the N sentences that look like the given expression." )
+        ( "query", po::value<std::string>(), "Keep the sentences which match a boolean expression of filters, like "
+          "'has-tag:ok and (language:fra or language:deu) and not user:\"some one\"'. The predicates are the "
+          "filtering options above which take a single value, written NAME:VALUE." )
     ;
     m_desc.add( filteringOptions );
     m_visibleOptions.add( filteringOptions );
@@ -128,6 +149,9 @@ void userOptions::treatCommandLine( int argc, char * argv[] )
 {
     po::store( po::command_line_parser( argc, argv ).options(m_desc).run(), m_vm );
     po::notify( m_vm );
+
+    if( m_vm.count( "query" ) )
+        m_query = parseQuery( m_vm["query"].as<std::string>() );
 }
 
 // -------------------------------------------------------------------------- //
@@ -163,7 +187,8 @@ bool addNewFilterToList( boost::program_options::variables_map & _vm, const std:
 // -------------------------------------------------------------------------- //
 
 /**@brief Populate the passed list of filters with certain filters */
-void userOptions::getFilters( dataset & _dataset, linkset & _linkset, tagset & _tagset, listset & _listset, FilterVector & allFilters_ )
+void userOptions::getFilters( dataset & _dataset, linkset & _linkset, tagset & _tagset, listset & _listset,
+                              const std::string & _indexDirectory, FilterVector & allFilters_ )
 {
     using std::shared_ptr;
     using std::vector;
@@ -175,8 +200,9 @@ void userOptions::getFilters( dataset & _dataset, linkset & _linkset, tagset & _
     addNewFilterToList<std::string, filterUser>( m_vm, "user", allFilters_ );
     addNewFilterToListGeneric< filterUser >( m_vm, "orphan", allFilters_, m_vm.count( "orphan" ) > 0, "", true );
 
-    // The various filters will be applied in order. The language filter is
-    // very light so we want it first to discard as many sentences as possible
+    // The filters are reordered by runQuery(), from the number of sentences
+    // each of them keeps and their cost, so the order here does not matter,
+    // except for the fuzzy filter, which must be last.
 
     if( addNewFilterToList<vector<string>, filterLang>( m_vm, "language", allFilters_ ) == false )
     {
@@ -186,8 +212,6 @@ void userOptions::getFilters( dataset & _dataset, linkset & _linkset, tagset & _
     addNewFilterToList<sentence::id, filterLink>( m_vm, "is-linked-to", allFilters_, _linkset );
     addNewFilterToList<std::string, filterTranslatableInLanguage>( m_vm, "is-translatable-in", allFilters_, _dataset, _linkset );
 
-    // regular expression filters are added last as each of those filters is
-    // relatively heavy.
     if( m_vm.count( "regex" ) )
     {
         // for each regex, we create a filter
@@ -195,8 +219,15 @@ void userOptions::getFilters( dataset & _dataset, linkset & _linkset, tagset & _
         qlog::info << "Adding filter for options: " << qlog::color( qlog::blue ) << "--regex" << qlog::color() << '\n';
         for( auto regex : allRegex )
         {
-            shared_ptr<filter> newFilter =
-                shared_ptr<filter>( new filterRegex( regex ) );
+            shared_ptr<filterRegex> newFilter =
+                shared_ptr<filterRegex>( new filterRegex( regex ) );
+
+            if( m_vm.count( "regex-index" ) )
+                newFilter->useIndex( _indexDirectory + '/' + TRIGRAM_INDEX_FILENAME );
+
+            if( m_vm.count( "substring-index" ) )
+                newFilter->useSubstringIndex( _indexDirectory + '/' + SUFFIX_INDEX_FILENAME );
+
             allFilters_.push_back( newFilter );
         }
     }
@@ -209,8 +240,12 @@ void userOptions::getFilters( dataset & _dataset, linkset & _linkset, tagset & _
 
         for( auto regex : allRegex )
         {
-            shared_ptr<filter> newFilter =
-                shared_ptr<filter>( new filterRegex( regex, false ) );
+            shared_ptr<filterRegex> newFilter =
+                shared_ptr<filterRegex>( new filterRegex( regex, false ) );
+
+            if( m_vm.count( "folded-text" ) )
+                newFilter->useFoldedText();
+
             allFilters_.push_back( newFilter );
         }
     }
@@ -219,8 +254,43 @@ void userOptions::getFilters( dataset & _dataset, linkset & _linkset, tagset & _
     addNewFilterToList<std::string, filterList>( m_vm, "in-list", allFilters_, _listset );
     addNewFilterToList<std::string, filterTag>( m_vm, "has-tag", allFilters_, _tagset );
 
+    if( m_vm.count( "only-chars" ) || m_vm.count( "known-chars-file" ) )
+    {
+        string knownCharacters = m_vm.count( "only-chars" ) ? m_vm["only-chars"].as<string>() : string();
+
+        if( m_vm.count( "known-chars-file" ) )
+        {
+            const string & path = m_vm["known-chars-file"].as<string>();
+            std::ifstream file( path.c_str(), std::ios::binary );
+
+            if( !file.is_open() )
+                throw po::error( "cannot read the known characters in " + path );
+
+            knownCharacters.append( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+        }
+
+        const unsigned maxUnknown = m_vm.count( "max-unknown-chars" ) ? m_vm["max-unknown-chars"].as<unsigned>() : 0;
+
+        qlog::info << "Adding filter for options: " << qlog::color( qlog::blue ) << "--only-chars" << qlog::color() << '\n';
+        allFilters_.push_back( std::make_shared<filterKnownCharacters>( knownCharacters, maxUnknown ) );
+    }
+
+    if( m_query )
+    {
+        qlog::info << "Adding filter for options: " << qlog::color( qlog::blue ) << "--query" << qlog::color() << '\n';
+        allFilters_.push_back( std::make_shared<filterQuery>( *m_query, _dataset, _linkset, _tagset, _listset ) );
+    }
+
     if( m_vm.count( "fuzzy" ) > 0 )
-        addNewFilterToListGeneric<filterFuzzy>( m_vm, "fuzzy", allFilters_, true, m_vm["fuzzy"].as<fuzzyFilterOption>() );
+    {
+        qlog::info << "Adding filter for options: " << qlog::color( qlog::blue ) << "--fuzzy" << qlog::color() << '\n';
+        shared_ptr<filterFuzzy> newFilter = std::make_shared<filterFuzzy>( m_vm["fuzzy"].as<fuzzyFilterOption>() );
+
+        if( m_vm.count( "folded-text" ) )
+            newFilter->useFoldedText();
+
+        allFilters_.push_back( newFilter );
+    }
 
 #ifdef HAVE_SYS_RESOURCE_H
 
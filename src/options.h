@@ -6,6 +6,7 @@
 #include <boost/program_options/variables_map.hpp>
 #include <tatoparser/sentence.h>
 #include "filter.h"
+#include "query_expression.h"
 
 NAMESPACE_START
 
@@ -15,6 +16,8 @@ struct tagset;
 struct listset;
 
 static const char DEFAULT_CONFIG_FILE_PATH[] = "~/.tatoparser";
+static const char TRIGRAM_INDEX_FILENAME[] = "sentences.trigrams";
+static const char SUFFIX_INDEX_FILENAME[] = "sentences.suffixes";
 
 /**@struct userOptions
  * @brief Treats the user-passed parameters (--help and such)
@@ -24,16 +27,19 @@ struct userOptions
     /**@brief Constructs an userOptions object */
     userOptions();
 
-    /**@brief Treat the command line arguments argc and argv, populate objects. */
+    /**@brief Treat the command line arguments argc and argv, populate objects.
+     * @throw invalid_query if the expression of --query cannot be parsed */
     void treatCommandLine( int argc, char * argv[] );
 
     /**@brief Populate a list of filters according to the user-specified parameters
      * @param[in] _dataset The list of sentences
      * @param[in] _linkset The list of links
      * @param[in] _tagset The list of tags
+     * @param[in] _indexDirectory Where the indexes of the sentences are kept:
+     *            the directory of the csv files they are built from
      * @param[out] allFilters_ The filter list that will be filled in by the call */
     void getFilters( dataset & _dataset, linkset & _linkset, tagset & _tagset, listset & _listset,
-                     FilterVector & allFilters_ );
+                     const std::string & _indexDirectory, FilterVector & allFilters_ );
 
     /**@brief Checks if any argument the user specified needs the links.csv to be parsed */
     bool isItNecessaryToParseLinksFile() const;
@@ -83,6 +89,38 @@ struct userOptions
     /**@brief Tells if the user wants to disable parallel processing */
     bool disableParallel() const;
 
+    /**@brief Tells if the csv files should be read before being parsed */
+    bool prefault() const;
+
+    /**@brief Tells if the csv files should be read instead of mapped */
+    bool disableMmap() const;
+
+    /**@brief Tells if the lines should be counted rather than estimated */
+    bool exactCount() const;
+
+    /**@brief Tells if the files other than sentences.csv should be parsed on first use */
+    bool lazy() const;
+
+    /**@brief Gets the directory of the diffs to apply after parsing, or an empty string */
+    std::string getDiffPath() const;
+
+    /**@brief Gets the socket to answer queries on, or an empty string */
+    std::string getServePath() const;
+
+    /**@brief Tells if the csv files were given on the command line, which a
+     *        query sent to a server cannot do */
+    bool isCsvPathGiven() const;
+
+    /**@brief Gets the socket of the server to send the query to, or an empty string */
+    std::string getConnectPath() const;
+
+    /**@brief Tells if the progress of the parsing should be drawn */
+    bool showProgress() const;
+
+    /**@brief Gets how the statistics of the run should be written, "text" or
+     *        "json", or an empty string if they should not */
+    std::string getStatisticsFormat() const;
+
     /**@brief Gets the separator character */
     std::string getSeparator() const;
 
@@ -109,6 +147,7 @@ private:
     boost::program_options::options_description m_desc, m_visibleOptions;
     boost::program_options::variables_map       m_vm;
     std::string                                 m_separator;
+    std::shared_ptr<queryNode>                  m_query;
 
 // ------- CONFIG FILE -------------
 public:
@@ -130,7 +169,7 @@ private:
 inline
 bool userOptions::isItNecessaryToParseTagFile() const
 {
-    return m_vm.count( "has-tag" ) > 0;
+    return m_vm.count( "has-tag" ) > 0 || ( m_query && usesPredicate( *m_query, "has-tag" ) );
 }
 
 // -------------------------------------------------------------------------- //
@@ -142,7 +181,10 @@ bool userOptions::isItNecessaryToParseLinksFile() const
            ( m_vm.count( "translation-regex" ) > 0 )	||
            ( m_vm.count( "display-first-translation" ) > 0 ) ||
            ( m_vm.count( "is-translatable-in" ) > 0 ) ||
-           ( m_vm.count( "translates" ) > 0 );
+           ( m_vm.count( "translates" ) > 0 ) ||
+           ( m_query && ( usesPredicate( *m_query, "is-linked-to" )       ||
+                          usesPredicate( *m_query, "is-translatable-in" ) ||
+                          usesPredicate( *m_query, "translation-regex" ) ) );
 }
 
 // -------------------------------------------------------------------------- //
@@ -150,7 +192,8 @@ bool userOptions::isItNecessaryToParseLinksFile() const
 inline
 bool userOptions::isItNecessaryToParseDetailedFile() const
 {
-    return m_vm.count( "user" ) > 0 || m_vm.count( "orphan" ) > 0;
+    return m_vm.count( "user" ) > 0 || m_vm.count( "orphan" ) > 0 ||
+           ( m_query && usesPredicate( *m_query, "user" ) );
 }
 
 // -------------------------------------------------------------------------- //
@@ -158,7 +201,7 @@ bool userOptions::isItNecessaryToParseDetailedFile() const
 inline
 bool userOptions::isItNecessaryToParseListFile() const
 {
-    return m_vm.count( "in-list" ) > 0;
+    return m_vm.count( "in-list" ) > 0 || ( m_query && usesPredicate( *m_query, "in-list" ) );
 }
 
 // -------------------------------------------------------------------------- //
@@ -307,6 +350,86 @@ bool userOptions::disableParallel() const
 
 // -------------------------------------------------------------------------- //
 
+inline
+bool userOptions::prefault() const
+{
+    return m_vm.count( "prefault" ) > 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+bool userOptions::disableMmap() const
+{
+    return m_vm.count( "no-mmap" ) > 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+bool userOptions::exactCount() const
+{
+    return m_vm.count( "exact-count" ) > 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+bool userOptions::lazy() const
+{
+    return m_vm.count( "lazy" ) > 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+std::string userOptions::getDiffPath() const
+{
+    return m_vm.count( "apply-diff" ) ? m_vm[ "apply-diff" ].as<std::string>() : std::string();
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+std::string userOptions::getServePath() const
+{
+    return m_vm.count( "serve" ) ? m_vm[ "serve" ].as<std::string>() : std::string();
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+bool userOptions::isCsvPathGiven() const
+{
+    return m_vm.count( "csv-path" ) > 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+std::string userOptions::getConnectPath() const
+{
+    return m_vm.count( "connect" ) ? m_vm[ "connect" ].as<std::string>() : std::string();
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+bool userOptions::showProgress() const
+{
+    return m_vm.count( "progress" ) > 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+inline
+std::string userOptions::getStatisticsFormat() const
+{
+    return m_vm.count( "stats" ) ? m_vm[ "stats" ].as<std::string>() : std::string();
+}
+
+// -------------------------------------------------------------------------- //
+
 inline
 bool userOptions::useNcurses() const
 {
@@ -0,0 +1,222 @@
+#ifndef LIBTATOPARSER_PARSE_MONITOR_H
+#define LIBTATOPARSER_PARSE_MONITOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <string>
+#include <vector>
+#include "tatoparser/namespace.h"
+#include "tatoparser/interface_lib.h"
+#include "tatoparser/statistics.h"
+
+#pragma GCC visibility push(hidden)
+
+NAMESPACE_START
+
+/**@brief Names a stage of the parsing of a file, like "parse links.csv" */
+inline std::string getStageName( const char * _stage, const std::string & _path )
+{
+    return std::string( _stage ) + ' ' + _path.substr( _path.find_last_of( '/' ) + 1 );
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@struct fileProgress
+ * @brief Counts the bytes and the lines of a file which have been parsed, by
+ *        one or several threads, and reports them to a progressCallback. The
+ *        parsing lasts as long as this object, which records it as a stage. */
+struct fileProgress
+{
+    /**@param[in] _callback Called each time a chunk has been parsed. It must
+     *            outlive this object, and can be empty.
+     * @param[in] _bytesTotal The size of the file, or 0 if it is not known
+     * @param[in] _statistics Where the parsing is recorded, or nullptr */
+    fileProgress( const progressCallback & _callback, const std::string & _path, size_t _bytesTotal,
+                  statistics * _statistics )
+        : m_callback( _callback )
+        , m_path( _path )
+        , m_bytesTotal( _bytesTotal )
+        , m_bytesParsed( 0 )
+        , m_linesParsed( 0 )
+        , m_timer( _statistics, getStageName( "parse", _path ) )
+    {
+    }
+
+    ~fileProgress()
+    {
+        m_timer.setItems( m_linesParsed );
+    }
+
+    /**@brief Adds a parsed chunk to the counts, and reports them */
+    void advance( size_t _bytes, size_t _lines )
+    {
+        const size_t bytesParsed = m_bytesParsed += _bytes;
+        const size_t linesParsed = m_linesParsed += _lines;
+
+        if( m_callback )
+            m_callback( parseProgress { m_path.c_str(), bytesParsed, m_bytesTotal, linesParsed } );
+    }
+
+private:
+    fileProgress( const fileProgress & ) TATO_DELETE;
+    fileProgress & operator=( const fileProgress & ) TATO_DELETE;
+
+private:
+    const progressCallback &    m_callback;
+    const std::string           m_path;
+    const size_t                m_bytesTotal;
+    std::atomic<size_t>         m_bytesParsed;
+    std::atomic<size_t>         m_linesParsed;
+    scopedTimer                 m_timer;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@struct parseMonitor
+ * @brief What a parser looks at between two chunks of its buffer: whether it
+ *        should stop, and where its progress should be reported.
+ *
+ * A default-constructed monitor never stops the parser and reports nothing. */
+struct parseMonitor
+{
+    parseMonitor()
+        : m_cancelled( nullptr )
+        , m_progress( nullptr )
+    {
+    }
+
+    /**@param[in] _cancelled Set to true to stop the parser, it must outlive the monitor
+     * @param[in] _progress Where the progress is reported, or nullptr */
+    parseMonitor( const std::atomic<bool> & _cancelled, fileProgress * _progress )
+        : m_cancelled( &_cancelled )
+        , m_progress( _progress )
+    {
+    }
+
+    /**@brief Tells whether the parsing operation was cancelled */
+    bool isCancelled() const
+    {
+        return m_cancelled != nullptr && m_cancelled->load( std::memory_order_relaxed );
+    }
+
+    /**@brief Reports that a chunk has been parsed */
+    void advance( size_t _bytes, size_t _lines ) const
+    {
+        if( m_progress != nullptr )
+            m_progress->advance( _bytes, _lines );
+    }
+
+private:
+    const std::atomic<bool> *   m_cancelled;
+    fileProgress *              m_progress;
+};
+
+// -------------------------------------------------------------------------- //
+
+// how many bytes a parser goes through before it checks whether it should stop
+static const size_t PARSE_CHUNK_SIZE = 4 * 1024 * 1024;
+
+/**@brief Feeds a buffer to a parser chunk after chunk, each chunk ending with a
+ *        complete line, until the end of the buffer or a cancellation.
+ * @tparam PARSER A parser, constructed with the bounds of a chunk, whose feed()
+ *         appends the lines of the chunk to a container
+ * @param[in] _firstLine The number of the first line of the buffer in its file,
+ *            which the warnings of the parser refer to
+ * @return The number of lines parsed
+ * @throw std::bad_alloc */
+template<typename PARSER, typename CONTAINER, typename iterator>
+size_t feedByChunks( iterator _begin, iterator _end, CONTAINER & container_, const parseMonitor & _monitor, size_t _firstLine = 1 )
+{
+    size_t nbLines = 0;
+    size_t line = _firstLine;
+
+    while( _begin != _end && !_monitor.isCancelled() )
+    {
+        iterator chunkEnd = _end;
+
+        if( static_cast<size_t>( _end - _begin ) > PARSE_CHUNK_SIZE )
+        {
+            chunkEnd = std::find( _begin + PARSE_CHUNK_SIZE, _end, '\n' );
+            if( chunkEnd != _end )
+                ++chunkEnd;
+        }
+
+        const size_t nbChunkLines = static_cast<size_t>( PARSER( _begin, chunkEnd ).feed( container_, line ) );
+        nbLines += nbChunkLines;
+
+        _monitor.advance( static_cast<size_t>( chunkEnd - _begin ), nbChunkLines );
+        _begin = chunkEnd;
+    }
+
+    return nbLines;
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Splits a buffer in parts which end with a complete line, feeds each
+ *        part to a parser on its own thread, and then merges what the parts
+ *        hold into a container, in the order of the buffer.
+ * @tparam PARSER A parser, like for feedByChunks()
+ * @tparam CONTAINER A container with a merge() which appends another one
+ * @param[in] _nbThreads How many threads can parse at the same time
+ * @return The number of lines parsed
+ * @throw std::bad_alloc */
+template<typename PARSER, typename CONTAINER, typename iterator>
+size_t feedInParallel( iterator _begin, iterator _end, CONTAINER & container_, const parseMonitor & _monitor, unsigned _nbThreads )
+{
+    // below that, starting the threads costs more than it saves
+    static const size_t MIN_BYTES_PER_THREAD = 1024 * 1024;
+
+    const size_t size = static_cast<size_t>( _end - _begin );
+    const size_t nbParts = std::max<size_t>( 1, std::min<size_t>( _nbThreads, size / MIN_BYTES_PER_THREAD ) );
+
+    std::vector<iterator> bounds( 1, _begin );
+    for( size_t part = 1; part < nbParts; ++part )
+    {
+        iterator bound = std::find( _begin + static_cast<std::ptrdiff_t>( part * ( size / nbParts ) ), _end, '\n' );
+        if( bound != _end )
+            ++bound;
+
+        bounds.push_back( std::max( bound, bounds.back() ) );
+    }
+    bounds.push_back( _end );
+
+    // the number of the first line of each part, for the warnings of the
+    // parsers, from the lines of the parts before it, counted in parallel
+    std::vector< std::future<size_t> > counts;
+    for( size_t part = 0; part + 1 < nbParts; ++part )
+    {
+        counts.push_back( std::async( std::launch::async, [&bounds, part]()
+        {
+            return static_cast<size_t>( std::count( bounds[part], bounds[part + 1], '\n' ) );
+        } ) );
+    }
+
+    std::vector<size_t> firstLines( 1, 1 );
+    for( std::future<size_t> & count : counts )
+        firstLines.push_back( firstLines.back() + count.get() );
+
+    std::vector<CONTAINER> parts( nbParts - 1 );
+    std::vector< std::future<size_t> > threads;
+    for( size_t part = 1; part < nbParts; ++part )
+    {
+        threads.push_back( std::async( std::launch::async, feedByChunks<PARSER, CONTAINER, iterator>,
+                                       bounds[part], bounds[part + 1], std::ref( parts[part - 1] ), std::cref( _monitor ), firstLines[part] ) );
+    }
+
+    size_t nbLines = feedByChunks<PARSER>( bounds[0], bounds[1], container_, _monitor );
+    for( std::future<size_t> & thread : threads )
+        nbLines += thread.get();
+
+    for( CONTAINER & part : parts )
+        container_.merge( std::move( part ) );
+
+    return nbLines;
+}
+
+NAMESPACE_END
+
+#pragma GCC visibility pop
+
+#endif // LIBTATOPARSER_PARSE_MONITOR_H
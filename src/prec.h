@@ -88,6 +88,7 @@
 #endif
 
 #define QLOG_USE_ASSERTS
+#define QLOG_MULTITHREAD_CPP11 // queries are answered on several threads with --serve
 #define QLOG_NAME_LOGGER_TRACE info
 #define QLOG_NAME_LOGGER_INFO warning
 #define QLOG_NAME_LOGGER_WARNING error
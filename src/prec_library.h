@@ -67,6 +67,7 @@
 
 #define QLOG_USE_ASSERTS
 #define QLOG_NAMESPACE llog
+#define QLOG_MULTITHREAD_CPP11 // the files are parsed on several threads
 #ifdef TATO_ANDROID
 #   define QLOG_USE_ANDROID
 #endif
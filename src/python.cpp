@@ -13,6 +13,79 @@ using namespace boost::python;
 #ifndef NAMESPACE
 #   define NAMESPACE
 #endif
+
+// __ PROGRESS ____________________________________________________________________________________________________________
+// passes the progress to a python function, called as function(path, bytesParsed, bytesTotal, linesParsed)
+// from the threads of the parsers, which do not hold the interpreter lock
+struct pythonProgress
+{
+    explicit pythonProgress( object _function ): m_function( _function ) { }
+
+    void operator()( const NAMESPACE ::parseProgress & _progress ) const
+    {
+        const PyGILState_STATE state = PyGILState_Ensure();
+
+        try
+        {
+            m_function( std::string( _progress.m_path ), _progress.m_bytesParsed, _progress.m_bytesTotal, _progress.m_linesParsed );
+        }
+        catch( const error_already_set & )
+        {
+            // the callback must not throw
+            PyErr_Print();
+        }
+
+        PyGILState_Release( state );
+    }
+
+    object m_function;
+};
+
+static NAMESPACE ::progressCallback makeProgressCallback( object _function )
+{
+    return _function.is_none() ? NAMESPACE ::progressCallback() : NAMESPACE ::progressCallback( pythonProgress( _function ) );
+}
+
+static void setContextProgressCallback( NAMESPACE ::parserContext & _context, object _function )
+{
+    _context.setProgressCallback( makeProgressCallback( _function ) );
+}
+
+static void setDefaultProgressCallback( object _function )
+{
+    NAMESPACE ::setProgressCallback( makeProgressCallback( _function ) );
+}
+
+// __ PARSING _____________________________________________________________________________________________________________
+// lets the other python threads run while parsing, so that they can cancel it
+// and that the parsers can report their progress
+struct releaseInterpreter
+{
+    releaseInterpreter(): m_state( PyEval_SaveThread() ) { }
+    ~releaseInterpreter() { PyEval_RestoreThread( m_state ); }
+
+    PyThreadState * m_state;
+};
+
+static int parseWithoutInterpreter( NAMESPACE ::dataset & _sentences, NAMESPACE ::linkset & _links,
+                                    NAMESPACE ::tagset & _tags, NAMESPACE ::listset & _lists,
+                                    const char * _sentencePath, const char * _linksPath,
+                                    const char * _tagPath, const char * _listPath )
+{
+    releaseInterpreter unlocked;
+    return NAMESPACE ::parse_( _sentences, _links, _tags, _lists, _sentencePath, _linksPath, _tagPath, _listPath );
+}
+
+static int parseContextWithoutInterpreter( NAMESPACE ::parserContext & _context,
+                                           NAMESPACE ::dataset & _sentences, NAMESPACE ::linkset & _links,
+                                           NAMESPACE ::tagset & _tags, NAMESPACE ::listset & _lists,
+                                           const char * _sentencePath, const char * _linksPath,
+                                           const char * _tagPath, const char * _listPath )
+{
+    releaseInterpreter unlocked;
+    return NAMESPACE ::parse_( _context, _sentences, _links, _tags, _lists, _sentencePath, _linksPath, _tagPath, _listPath );
+}
+
 BOOST_PYTHON_MODULE( libtatoparser )
 {
     // __ DATASET _________________________________________________________________________________________________________
@@ -45,10 +118,20 @@ BOOST_PYTHON_MODULE( libtatoparser )
         .def( "id", & NAMESPACE ::sentence::getId )
     ;
 
+    // __ CONTEXT _________________________________________________________________________________________________________
+    class_<NAMESPACE :: parserContext, boost::noncopyable>( "parserContext", init<NAMESPACE ::ParserFlag>() )
+        .def( "cancel", & NAMESPACE ::parserContext::cancel )
+        .def( "isCancelled", & NAMESPACE ::parserContext::isCancelled )
+        .def( "setProgressCallback", setContextProgressCallback )
+    ;
+
     // __ INTERFACE _______________________________________________________________________________________________________
     def( "init", NAMESPACE ::init );
     def( "terminate", NAMESPACE ::terminate );
-    def( "parse", NAMESPACE :: parse_ );
+    def( "cancel", NAMESPACE ::cancel );
+    def( "setProgressCallback", setDefaultProgressCallback );
+    def( "parse", parseWithoutInterpreter );
+    def( "parse", parseContextWithoutInterpreter );
 }
 
 #endif // USE_PYTHON_WRAPPER
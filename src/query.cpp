@@ -0,0 +1,371 @@
+#include "prec.h"
+#include <tatoparser/dataset.h>
+#include <tatoparser/linkset.h>
+#include <tatoparser/tagset.h>
+#include <tatoparser/listset.h>
+#include <tatoparser/statistics.h>
+#include "options.h"
+#include "display.h"
+#include "query.h"
+#include "filter_chain.h"
+
+NAMESPACE_START
+
+static
+void displaySentence( userOptions & _options, dataset & _allSentences, linkset & _allLinks, const sentence & _sentence, unsigned _lineNumber, display & _out );
+
+// -------------------------------------------------------------------------- //
+
+// how many sentences are given to every filter before the filters are
+// ordered, a multiple of FILTER_BLOCK_SIZE
+static const size_t FILTER_SAMPLE_SIZE = 4 * FILTER_BLOCK_SIZE;
+
+// how many sampled sentences the estimated cost of a filter is worth
+static const double FILTER_COST_WEIGHT = 64;
+
+// how many sentences a filter was given, how many it kept, and how long it took
+struct filterCounts
+{
+    filterCounts(): m_calls( 0 ), m_kept( 0 ), m_nanoseconds( 0 ) { }
+
+    uint64_t m_calls;
+    uint64_t m_kept;
+    uint64_t m_nanoseconds;
+};
+
+// -------------------------------------------------------------------------- //
+
+// Narrows the selection of a block with the filters, from the _first one,
+// and returns how many sentences are left. With MEASURED set, each filter is
+// also counted and timed, which reads the clock twice per block.
+template<bool MEASURED>
+static inline
+size_t filterBlock( const FilterVector & _filters, size_t _first, const sentence * _block,
+                    blockIndex * selection_, size_t _nbSelected, std::vector<filterCounts> & counts_ )
+{
+    for( size_t i = _first; _nbSelected > 0 && i < _filters.size(); ++i )
+    {
+        const scopedTimer::clock::time_point start = MEASURED ? scopedTimer::clock::now() : scopedTimer::clock::time_point();
+        const size_t nbKept = _filters[i]->parseBlock( _block, selection_, _nbSelected );
+
+        if( MEASURED )
+        {
+            counts_[i].m_nanoseconds += scopedTimer::elapsed( start );
+            counts_[i].m_calls += _nbSelected;
+            counts_[i].m_kept += nbKept;
+        }
+
+        _nbSelected = nbKept;
+    }
+
+    return _nbSelected;
+}
+
+// -------------------------------------------------------------------------- //
+
+// Selects the sentences of a block which have an id, and returns how many
+static inline
+size_t selectValidSentences( const sentence * _block, size_t _blockSize, blockIndex * selection_ )
+{
+    size_t nbSelected = 0;
+
+    for( size_t i = 0; i < _blockSize; ++i )
+    {
+        selection_[nbSelected] = static_cast<blockIndex>( i );
+        nbSelected += _block[i].getId() != sentence::INVALID_ID ? 1 : 0;
+    }
+
+    return nbSelected;
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Orders the filters so that the sentences are rejected as cheaply as
+ *        possible: a filter comes before another if it costs less per sentence
+ *        it rejects. The filters which cannot be reordered stay at the end.
+ * @param[in] _sampled How many sentences were given to each filter which can
+ *            be reordered, how many it kept, and how long it took
+ * @param[in,out] filters_ The filters, and counts_ their counts, which are
+ *                moved along with them */
+static
+void orderFilters( const std::vector<filterCounts> & _sampled, FilterVector & filters_, std::vector<filterCounts> & counts_ )
+{
+    std::vector<size_t> order;
+    std::vector<double> costs( filters_.size() ), costPerRejection( filters_.size() );
+
+    for( size_t i = 0; i < filters_.size(); ++i )
+    {
+        order.push_back( i );
+
+        const double nbSampled = static_cast<double>( _sampled[i].m_calls );
+        const double nbKept = static_cast<double>( _sampled[i].m_kept );
+
+        // the estimated cost counts as much as FILTER_COST_WEIGHT sampled
+        // sentences, so that it is trusted when only a few could be sampled
+        costs[i] = ( filters_[i]->getCost() * FILTER_COST_WEIGHT + static_cast<double>( _sampled[i].m_nanoseconds ) )
+                 / ( FILTER_COST_WEIGHT + nbSampled );
+
+        // a filter which rejected none of the sampled sentences might still
+        // reject some of the others
+        const double rejected = ( nbSampled - nbKept + 1 ) / ( nbSampled + 2 );
+        costPerRejection[i] = costs[i] / rejected;
+    }
+
+    const std::vector<size_t>::iterator endReorderable =
+        std::find_if( order.begin(), order.end(), [&filters_]( size_t _index )
+        {
+            return !filters_[_index]->canBeReordered();
+        } );
+
+    std::stable_sort( order.begin(), endReorderable, [&costPerRejection]( size_t _a, size_t _b )
+    {
+        return costPerRejection[_a] < costPerRejection[_b];
+    } );
+
+    FilterVector orderedFilters;
+    std::vector<filterCounts> orderedCounts;
+
+    for( size_t index : order )
+    {
+        orderedFilters.push_back( filters_[index] );
+        orderedCounts.push_back( counts_[index] );
+
+        qlog::info << "filter " << qlog::color( qlog::blue ) << filters_[index]->getName() << qlog::color()
+                   << ": " << costs[index] << " ns per sentence, kept " << _sampled[index].m_kept << '/'
+                   << _sampled[index].m_calls << " sampled sentences\n";
+    }
+
+    filters_.swap( orderedFilters );
+    counts_.swap( orderedCounts );
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Keeps the sentences which match all the filters.
+ *
+ * The sentences are given to the filters by blocks, see filter::parseBlock().
+ * The first blocks are given to every filter, to know how many sentences
+ * each of them keeps and how long it takes, and the filters are then ordered
+ * by orderFilters().
+ * @tparam MEASURED Whether each filter is timed, which is only done with
+ *         statistics, and recorded in statistics_
+ * @param[in,out] filters_ The filters, which are reordered */
+template<bool MEASURED>
+static
+void filterSentences( FilterVector & filters_, dataset & _allSentences, const std::atomic<bool> & _quit,
+                      std::vector<const sentence *> & filteredSentences_, statistics * statistics_ )
+{
+    std::vector<filterCounts> counts( filters_.size() );
+    scopedTimer timer( statistics_, "filter" );
+
+    // the filters which cannot be reordered must be last while sampling too
+    std::stable_partition( filters_.begin(), filters_.end(), []( const FilterVector::value_type & _filter )
+    {
+        return _filter->canBeReordered();
+    } );
+
+    const size_t nbReorderable = static_cast<size_t>( std::count_if( filters_.begin(), filters_.end(),
+        []( const FilterVector::value_type & _filter ) { return _filter->canBeReordered(); } ) );
+
+    // the sentences are given to the filters by blocks of consecutive
+    // sentences, which the filters narrow down one after the other
+    const size_t nbSentences = _allSentences.size();
+    const sentence * const allSentences = nbSentences > 0 ? &*_allSentences.begin() : nullptr;
+    blockIndex selection[FILTER_BLOCK_SIZE];
+    size_t first = 0;
+
+    if( nbReorderable > 1 )
+    {
+        const size_t endSample = std::min( nbSentences, FILTER_SAMPLE_SIZE );
+
+        // each filter which can be reordered is given all the sampled
+        // sentences, and timed once for all of them
+        std::vector<filterCounts> sampled( filters_.size() );
+        std::vector<size_t> nbFiltersKeeping( endSample, 0 );
+
+        for( size_t i = 0; i < nbReorderable && !_quit; ++i )
+        {
+            const scopedTimer::clock::time_point start = scopedTimer::clock::now();
+
+            for( size_t block = 0; block < endSample; block += FILTER_BLOCK_SIZE )
+            {
+                const size_t blockSize = std::min( FILTER_BLOCK_SIZE, endSample - block );
+                const size_t nbSelected = selectValidSentences( allSentences + block, blockSize, selection );
+                const size_t nbKept = filters_[i]->parseBlock( allSentences + block, selection, nbSelected );
+
+                sampled[i].m_calls += nbSelected;
+                sampled[i].m_kept += nbKept;
+
+                for( size_t j = 0; j < nbKept; ++j )
+                    ++nbFiltersKeeping[ block + selection[j] ];
+            }
+
+            sampled[i].m_nanoseconds = scopedTimer::elapsed( start );
+            counts[i] = sampled[i];
+        }
+
+        // the sentences they all kept are given to the other filters
+        for( size_t block = 0; block < endSample && !_quit; block += FILTER_BLOCK_SIZE )
+        {
+            const size_t blockSize = std::min( FILTER_BLOCK_SIZE, endSample - block );
+            size_t nbSelected = 0;
+
+            for( size_t j = 0; j < blockSize; ++j )
+            {
+                selection[nbSelected] = static_cast<blockIndex>( j );
+                nbSelected += nbFiltersKeeping[ block + j ] == nbReorderable ? 1 : 0;
+            }
+
+            nbSelected = filterBlock<MEASURED>( filters_, nbReorderable, allSentences + block, selection, nbSelected, counts );
+
+            for( size_t j = 0; j < nbSelected; ++j )
+                filteredSentences_.push_back( allSentences + block + selection[j] );
+        }
+
+        orderFilters( sampled, filters_, counts );
+        first = endSample;
+
+        // the filters are kept apart when they are measured, to know what
+        // each of them costs
+        if( !MEASURED )
+        {
+            fuseFilters( filters_, nbReorderable );
+            counts.resize( filters_.size() );
+        }
+    }
+
+    for( size_t block = first; block < nbSentences && !_quit; block += FILTER_BLOCK_SIZE )
+    {
+        const size_t blockSize = std::min( FILTER_BLOCK_SIZE, nbSentences - block );
+        size_t nbSelected = selectValidSentences( allSentences + block, blockSize, selection );
+
+        nbSelected = filterBlock<MEASURED>( filters_, 0, allSentences + block, selection, nbSelected, counts );
+
+        // display the sentences which are seleted by all the filters
+        for( size_t j = 0; j < nbSelected; ++j )
+            filteredSentences_.push_back( allSentences + block + selection[j] );
+    }
+
+    timer.setItems( filteredSentences_.size() );
+
+    // once the filters are ordered, the sentences each filter is given are
+    // those kept by the filters before it
+    for( size_t i = 0; MEASURED && i < filters_.size(); ++i )
+    {
+        statistics_->recordSelection( std::string( "filter " ) + filters_[i]->getName(),
+                                      counts[i].m_nanoseconds, counts[i].m_calls, counts[i].m_kept );
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+void runQuery( userOptions & _options, FilterVector & allFilters_,
+             dataset & _allSentences, linkset & _allLinks, listset & _allLists,
+             display & _out, const std::atomic<bool> & _quit, statistics * statistics_ )
+{
+    _options.treatTranslations( _allLinks, allFilters_ );
+
+    // if a list has beeg given, check if the list exists
+    const std::string & lowerCaseListName = toLower( _options.getListName() );
+
+    if( lowerCaseListName.size() && _allLists.doesListExist( lowerCaseListName ) == false )
+        throw unknown_list();
+
+    ///////////////////////////
+    //  filtering sentences  //
+    ///////////////////////////
+    std::vector<const sentence *> filteredSentences;
+
+    {
+        scopedTimer prepareTimer( statistics_, "prepare filters" );
+        for( const FilterVector::value_type & filter : allFilters_ )
+            filter->prepare( _allSentences );
+    }
+
+    // go through every sentence and see if it matches the filters
+    if( statistics_ != nullptr )
+        filterSentences<true>( allFilters_, _allSentences, _quit, filteredSentences, statistics_ );
+    else
+        filterSentences<false>( allFilters_, _allSentences, _quit, filteredSentences, nullptr );
+
+    auto endFilter = allFilters_.end();
+    unsigned printedLineNumber = 0;
+    bool shouldDisplay = true;
+
+    /////////////////////////////////////
+    //  processing filtered sentences  //
+    /////////////////////////////////////
+    scopedTimer displayTimer( statistics_, "display" );
+
+    for( const sentence * sentence : filteredSentences )
+    {
+        if (_quit)
+            break;
+
+        assert(nullptr != sentence);
+
+        if( sentence->getId() == sentence::INVALID_ID )
+            continue;
+        shouldDisplay = true;
+
+        for( auto filter = allFilters_.begin(); shouldDisplay && filter != endFilter; ++filter )
+        {
+            shouldDisplay &= ( *filter )->postProcess( *sentence );
+        }
+
+        if( shouldDisplay )
+        {
+            displaySentence( _options, _allSentences, _allLinks, *sentence, ++printedLineNumber, _out );
+        }
+    }
+
+    displayTimer.setItems( printedLineNumber );
+}
+
+// -------------------------------------------------------------------------- //
+
+static
+void displaySentence( userOptions & _options, dataset & _allSentences, linkset & _allLinks, const sentence & _sentence, unsigned _lineNumber, display & _out )
+{
+    using namespace qlog;
+    std::string translationLanguage = _options.getFirstTranslationLanguage();
+
+    display::flag options { display::DISPLAY_NONE };
+
+    // option -n
+    if( _options.displayLineNumbers() )
+        options |= display::DISPLAY_LINE_NUMBER;
+
+    // option -i
+    if( _options.displayIds() )
+        options |= display::DISPLAY_IDS;
+
+    // option --display-lang
+    if( _options.displayLanguages() )
+        options |= display::DISPLAY_LANGUAGES;
+
+    // find the first-translation sentence, if necessary
+    sentence * firstTranslation = nullptr;
+    if( _options.displayFirstTranslation() )
+    {
+        options |= display::DISPLAY_FIRST_TRANSL;
+
+        // find a suitable translation
+        const sentence::id firstTranslationId =
+            getFirstSentenceTranslation(
+                _allSentences,
+                _allLinks,
+                _sentence.getId(),
+                translationLanguage
+            );
+
+        if( firstTranslationId != sentence::INVALID_ID
+                && _allSentences[firstTranslationId] )
+            firstTranslation = _allSentences[firstTranslationId];
+    }
+
+    // display the sentence
+    _out.writeSentence( _sentence, options, _lineNumber, firstTranslation );
+}
+
+NAMESPACE_END
@@ -0,0 +1,39 @@
+#ifndef TATOPARSER_QUERY_H
+#define TATOPARSER_QUERY_H
+
+#include <atomic>
+#include "filter.h"
+
+NAMESPACE_START
+
+struct userOptions;
+struct dataset;
+struct linkset;
+struct listset;
+struct display;
+struct statistics;
+
+/**
+ * @struct unknown_list
+ * @desc An exception thrown when the sentences are looked for in a list which
+ *       does not exist */
+struct unknown_list
+{
+};
+
+/**@brief Selects the sentences that match all the filters and displays them
+ * @param[in] _options The options which created the filters, and which tell
+ *            what should be displayed
+ * @param[in,out] allFilters_ The filters, to which the translation filters are added
+ * @param[in] _quit Stops the query when it becomes true
+ * @param[out] statistics_ Where the time spent filtering and displaying, and
+ *             the sentences kept by each filter, are recorded, or nullptr
+ * @throw unknown_list if the list given with --in-list does not exist
+ * @throw cannot_write if the display fails */
+void runQuery( userOptions & _options, FilterVector & allFilters_,
+             dataset & _allSentences, linkset & _allLinks, listset & _allLists,
+             display & _out, const std::atomic<bool> & _quit, statistics * statistics_ = nullptr );
+
+NAMESPACE_END
+
+#endif // TATOPARSER_QUERY_H
@@ -0,0 +1,221 @@
+#include "prec.h"
+#include "query_expression.h"
+#include <cctype>
+
+NAMESPACE_START
+
+// the names a predicate can have
+static const char * const PREDICATE_NAMES[] =
+{
+    "language", "has-id", "user", "has-tag", "in-list", "is-linked-to",
+    "is-translatable-in", "regex", "regex-nocs", "translation-regex"
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@struct queryParser
+ * @brief Reads a query expression from left to right, by recursive descent */
+struct queryParser
+{
+    explicit queryParser( const std::string & _expression )
+        : m_expression( _expression )
+        , m_position( 0 )
+    {
+    }
+
+    std::shared_ptr<queryNode> parse()
+    {
+        std::shared_ptr<queryNode> query = parseOr();
+
+        skipSpaces();
+        if( m_position != m_expression.size() )
+            fail( "unexpected \"" + m_expression.substr( m_position ) + '"' );
+
+        return query;
+    }
+
+private:
+    // or := and ( "or" and )*
+    std::shared_ptr<queryNode> parseOr()
+    {
+        return parseOperands( queryNode::OR, "or", &queryParser::parseAnd );
+    }
+
+    // and := unary ( "and" unary )*
+    std::shared_ptr<queryNode> parseAnd()
+    {
+        return parseOperands( queryNode::AND, "and", &queryParser::parseUnary );
+    }
+
+    std::shared_ptr<queryNode> parseOperands( queryNode::kind _kind, const char * _keyword,
+                                              std::shared_ptr<queryNode> ( queryParser::*_parseOperand )() )
+    {
+        std::shared_ptr<queryNode> first = ( this->*_parseOperand )();
+
+        if( !acceptKeyword( _keyword ) )
+            return first;
+
+        std::shared_ptr<queryNode> node = std::make_shared<queryNode>( _kind );
+        node->m_children.push_back( first );
+
+        do
+            node->m_children.push_back( ( this->*_parseOperand )() );
+        while( acceptKeyword( _keyword ) );
+
+        return node;
+    }
+
+    // unary := "not" unary | "(" or ")" | predicate
+    std::shared_ptr<queryNode> parseUnary()
+    {
+        if( acceptKeyword( "not" ) )
+        {
+            std::shared_ptr<queryNode> node = std::make_shared<queryNode>( queryNode::NOT );
+            node->m_children.push_back( parseUnary() );
+            return node;
+        }
+
+        skipSpaces();
+        if( m_position < m_expression.size() && m_expression[m_position] == '(' )
+        {
+            ++m_position;
+            std::shared_ptr<queryNode> node = parseOr();
+
+            skipSpaces();
+            if( m_position == m_expression.size() || m_expression[m_position] != ')' )
+                fail( "missing )" );
+
+            ++m_position;
+            return node;
+        }
+
+        return parsePredicate();
+    }
+
+    // predicate := name ":" ( value | '"' quoted value '"' )
+    std::shared_ptr<queryNode> parsePredicate()
+    {
+        const std::string name = readName();
+
+        if( name.empty() )
+            fail( m_position == m_expression.size() ? "a predicate is missing at the end" : "a predicate is expected at \"" + m_expression.substr( m_position ) + '"' );
+
+        if( m_position == m_expression.size() || m_expression[m_position] != ':' )
+            fail( "\"" + name + "\" should be followed by :VALUE" );
+
+        if( std::find( std::begin( PREDICATE_NAMES ), std::end( PREDICATE_NAMES ), name ) == std::end( PREDICATE_NAMES ) )
+            fail( "unknown predicate \"" + name + '"' );
+
+        ++m_position;
+
+        std::shared_ptr<queryNode> node = std::make_shared<queryNode>( queryNode::PREDICATE );
+        node->m_name = name;
+        node->m_value = readValue();
+
+        return node;
+    }
+
+    std::string readName()
+    {
+        skipSpaces();
+
+        const size_t begin = m_position;
+        while( m_position < m_expression.size() &&
+               ( std::isalpha( static_cast<unsigned char>( m_expression[m_position] ) ) || m_expression[m_position] == '-' ) )
+        {
+            ++m_position;
+        }
+
+        return m_expression.substr( begin, m_position - begin );
+    }
+
+    std::string readValue()
+    {
+        std::string value;
+
+        if( m_position < m_expression.size() && m_expression[m_position] == '"' )
+        {
+            for( ++m_position; m_position < m_expression.size() && m_expression[m_position] != '"'; ++m_position )
+            {
+                if( m_expression[m_position] == '\\' && m_position + 1 < m_expression.size() )
+                    ++m_position;
+
+                value.push_back( m_expression[m_position] );
+            }
+
+            if( m_position == m_expression.size() )
+                fail( "a \" is missing" );
+
+            ++m_position;
+        }
+        else
+        {
+            while( m_position < m_expression.size() &&
+                   !std::isspace( static_cast<unsigned char>( m_expression[m_position] ) ) && m_expression[m_position] != ')' )
+            {
+                value.push_back( m_expression[m_position++] );
+            }
+        }
+
+        return value;
+    }
+
+    // reads a keyword if it comes next, as a whole word
+    bool acceptKeyword( const char * _keyword )
+    {
+        skipSpaces();
+
+        const size_t length = std::char_traits<char>::length( _keyword );
+        const size_t end = m_position + length;
+
+        if( m_expression.compare( m_position, length, _keyword ) != 0 ||
+            ( end < m_expression.size() && ( std::isalpha( static_cast<unsigned char>( m_expression[end] ) ) ||
+                                             m_expression[end] == '-' || m_expression[end] == ':' ) ) )
+        {
+            return false;
+        }
+
+        m_position = end;
+        return true;
+    }
+
+    void skipSpaces()
+    {
+        while( m_position < m_expression.size() && std::isspace( static_cast<unsigned char>( m_expression[m_position] ) ) )
+            ++m_position;
+    }
+
+    void fail( const std::string & _why ) const
+    {
+        throw invalid_query( _why );
+    }
+
+private:
+    const std::string & m_expression;
+    size_t              m_position;
+};
+
+// -------------------------------------------------------------------------- //
+
+std::shared_ptr<queryNode> parseQuery( const std::string & _expression )
+{
+    return queryParser( _expression ).parse();
+}
+
+// -------------------------------------------------------------------------- //
+
+bool usesPredicate( const queryNode & _query, const std::string & _name )
+{
+    if( _query.m_kind == queryNode::PREDICATE )
+        return _query.m_name == _name;
+
+    for( const std::shared_ptr<queryNode> & child : _query.m_children )
+    {
+        if( usesPredicate( *child, _name ) )
+            return true;
+    }
+
+    return false;
+}
+
+NAMESPACE_END
@@ -0,0 +1,62 @@
+#ifndef TATOPARSER_QUERY_EXPRESSION_H
+#define TATOPARSER_QUERY_EXPRESSION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/program_options/errors.hpp>
+
+NAMESPACE_START
+
+/**
+ * @struct invalid_query
+ * @desc An exception thrown when the expression given with --query cannot be
+ *       understood, which is reported like the other invalid options */
+struct invalid_query : public boost::program_options::error
+{
+    explicit invalid_query( const std::string & _why )
+        : boost::program_options::error( "invalid query: " + _why )
+    {
+    }
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@struct queryNode
+ * @brief A node of a query expression, like
+ *        ( has-tag:ok or in-list:2 ) and not user:"some one" */
+struct queryNode
+{
+    enum kind { AND, OR, NOT, PREDICATE };
+
+    explicit queryNode( kind _kind ): m_kind( _kind ), m_name(), m_value(), m_children() { }
+
+    kind                                        m_kind;
+
+    // the option a predicate stands for, like "has-tag", and its value
+    std::string                                 m_name;
+    std::string                                 m_value;
+
+    // the operands of AND, OR and NOT
+    std::vector< std::shared_ptr<queryNode> >   m_children;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Parses a query expression.
+ *
+ * A predicate is written NAME:VALUE, where NAME is one of the filtering
+ * options: language, has-id, user, has-tag, in-list, is-linked-to,
+ * is-translatable-in, regex, regex-nocs and translation-regex. A value which
+ * holds spaces or parentheses is written between double quotes, in which \"
+ * and \\ stand for " and \. The predicates are combined with not, and, or,
+ * from the highest precedence to the lowest, and parentheses.
+ * @throw invalid_query */
+std::shared_ptr<queryNode> parseQuery( const std::string & _expression );
+
+/**@brief Tells whether a query has any predicate with a given name */
+bool usesPredicate( const queryNode & _query, const std::string & _name );
+
+NAMESPACE_END
+
+#endif // TATOPARSER_QUERY_EXPRESSION_H
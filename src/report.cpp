@@ -0,0 +1,79 @@
+#include "prec.h"
+#include <tatoparser/statistics.h>
+#include "report.h"
+#include <iomanip>
+
+NAMESPACE_START
+
+// -------------------------------------------------------------------------- //
+
+static
+std::string escapeJson( const std::string & _text )
+{
+    std::string escaped;
+
+    for( char character : _text )
+    {
+        if( character == '"' || character == '\\' )
+            escaped.push_back( '\\' );
+
+        escaped.push_back( character );
+    }
+
+    return escaped;
+}
+
+// -------------------------------------------------------------------------- //
+
+void writeStatistics( std::ostream & _output, const statistics & _statistics, bool _json )
+{
+    const std::vector<statistics::stage> stages = _statistics.getStages();
+
+    _output << std::fixed << std::setprecision( 3 );
+
+    if( _json )
+    {
+        _output << "{\n  \"stages\": [";
+
+        for( size_t i = 0; i < stages.size(); ++i )
+        {
+            const statistics::stage & stage = stages[i];
+
+            _output << ( i == 0 ? "\n" : ",\n" )
+                    << "    { \"name\": \"" << escapeJson( stage.m_name ) << '"'
+                    << ", \"calls\": " << stage.m_calls
+                    << ", \"milliseconds\": " << stage.m_nanoseconds / 1e6
+                    << ", \"items\": " << stage.m_items;
+
+            if( stage.m_isSelection && stage.m_calls > 0 )
+                _output << ", \"selectivity\": " << std::setprecision( 6 )
+                        << static_cast<double>( stage.m_items ) / stage.m_calls << std::setprecision( 3 );
+
+            _output << " }";
+        }
+
+        _output << "\n  ]\n}\n";
+        return;
+    }
+
+    _output << std::left << std::setw( 32 ) << "stage" << std::right
+            << std::setw( 12 ) << "calls"
+            << std::setw( 14 ) << "time (ms)"
+            << std::setw( 12 ) << "items"
+            << std::setw( 12 ) << "selectivity" << '\n';
+
+    for( const statistics::stage & stage : stages )
+    {
+        _output << std::left << std::setw( 32 ) << stage.m_name << std::right
+                << std::setw( 12 ) << stage.m_calls
+                << std::setw( 14 ) << stage.m_nanoseconds / 1e6
+                << std::setw( 12 ) << stage.m_items;
+
+        if( stage.m_isSelection && stage.m_calls > 0 )
+            _output << std::setw( 11 ) << 100.0 * stage.m_items / stage.m_calls << '%';
+
+        _output << '\n';
+    }
+}
+
+NAMESPACE_END
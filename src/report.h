@@ -0,0 +1,19 @@
+#ifndef TATOPARSER_REPORT_H
+#define TATOPARSER_REPORT_H
+
+#include <ostream>
+#include <tatoparser/namespace.h>
+
+NAMESPACE_START
+
+struct statistics;
+
+/**@brief Writes how long each stage of a run took, how many times it ran and
+ *        how many items it produced. For the filters, the share of the
+ *        sentences they kept, that is their selectivity, is written too.
+ * @param[in] _json Writes a JSON object instead of a table */
+void writeStatistics( std::ostream & _output, const statistics & _statistics, bool _json );
+
+NAMESPACE_END
+
+#endif // TATOPARSER_REPORT_H
@@ -3,28 +3,58 @@
 NAMESPACE_START
 // -------------------------------------------------------------------------- //
 
-sentence::sentence( sentence::id _id, const char * _lang, const char * _data,
-                    const char * _author, const char * _creationDate,
-                    const char * _lastModifiedDate )
+const size_t sentence::MAX_LANG_SIZE;
+const sentence::userId sentence::NO_USER;
+
+// -------------------------------------------------------------------------- //
+
+// the sizes are stored on fewer bits than a size_t: clamp them rather than
+// letting them wrap around
+template<typename SIZE> static inline
+SIZE clampSize( const textSlice & _slice )
+{
+    const size_t maxSize = static_cast<SIZE>( -1 );
+    return static_cast<SIZE>( _slice.size() < maxSize ? _slice.size() : maxSize );
+}
+
+// -------------------------------------------------------------------------- //
+
+sentence::sentence( sentence::id _id, textSlice _lang, textSlice _data,
+                    textSlice _author, textSlice _creationDate,
+                    textSlice _lastModifiedDate )
     :m_id( _id )
-    ,m_lang( _lang )
-    ,m_data( _data )
-    ,m_author( _author )
-    ,m_creationDate( _creationDate )
-    ,m_lastModifiedDate( _lastModifiedDate )
+    ,m_size( clampSize<uint32_t>( _data ) )
+    ,m_data( _data.begin() )
+    ,m_author( _author.begin() )
+    ,m_creationDate( _creationDate.begin() )
+    ,m_lastModifiedDate( _lastModifiedDate.begin() )
+    ,m_authorSize( clampSize<uint16_t>( _author ) )
+    ,m_creationDateSize( clampSize<uint16_t>( _creationDate ) )
+    ,m_lastModifiedDateSize( clampSize<uint16_t>( _lastModifiedDate ) )
+    ,m_user( NO_USER )
 {
+    // the language is short enough to be copied, which gives back a C string
+    // without writing into the buffer it comes from
+    const size_t langSize = std::min( _lang.size(), MAX_LANG_SIZE );
+    std::copy( _lang.begin(), _lang.begin() + langSize, m_lang );
+    std::fill( m_lang + langSize, m_lang + MAX_LANG_SIZE + 1, '\0' );
 }
 
 // -------------------------------------------------------------------------- //
 
 sentence::sentence( const sentence & _copy )
     :m_id( _copy.m_id )
-    ,m_lang( _copy.m_lang )
+    ,m_size( _copy.m_size )
     ,m_data( _copy.m_data )
     ,m_author( _copy.m_author )
     ,m_creationDate( _copy.m_creationDate )
     ,m_lastModifiedDate( _copy.m_lastModifiedDate )
+    ,m_authorSize( _copy.m_authorSize )
+    ,m_creationDateSize( _copy.m_creationDateSize )
+    ,m_lastModifiedDateSize( _copy.m_lastModifiedDateSize )
+    ,m_user( _copy.m_user )
 {
+    std::copy( _copy.m_lang, _copy.m_lang + MAX_LANG_SIZE + 1, m_lang );
 }
 
 // -------------------------------------------------------------------------- //
@@ -32,11 +62,16 @@ sentence::sentence( const sentence & _copy )
 sentence & sentence::operator=( const sentence & _sentence )
 {
     m_id = _sentence.m_id;
-    m_lang = _sentence.m_lang;
+    m_size = _sentence.m_size;
     m_data = _sentence.m_data;
     m_author = _sentence.m_author;
     m_creationDate = _sentence.m_creationDate;
     m_lastModifiedDate = _sentence.m_lastModifiedDate;
+    m_authorSize = _sentence.m_authorSize;
+    m_creationDateSize = _sentence.m_creationDateSize;
+    m_lastModifiedDateSize = _sentence.m_lastModifiedDateSize;
+    m_user = _sentence.m_user;
+    std::copy( _sentence.m_lang, _sentence.m_lang + MAX_LANG_SIZE + 1, m_lang );
 
     return *this;
 }
@@ -0,0 +1,450 @@
+#include "prec.h"
+#include <tatoparser/dataset.h>
+#include <tatoparser/linkset.h>
+#include <tatoparser/tagset.h>
+#include <tatoparser/listset.h>
+#include "options.h"
+#include "display.h"
+#include "query.h"
+#include "server.h"
+
+#if HAVE_SYS_SOCKET_H == 1 && HAVE_SYS_UN_H == 1
+#   include <sys/socket.h>
+#   include <sys/un.h>
+#   include <sys/time.h>
+#   include <poll.h>
+#   include <unistd.h>
+#   include <cerrno>
+#   include <condition_variable>
+#   include <deque>
+#   include <mutex>
+#   include <thread>
+#   define TATO_HAVE_SOCKETS
+#endif
+
+NAMESPACE_START
+
+#ifdef TATO_HAVE_SOCKETS
+
+// the longest query a client can send, in bytes
+static const size_t MAX_QUERY_SIZE = 64 * 1024;
+
+// how often the server checks if it should stop, in milliseconds
+static const int QUIT_POLL_PERIOD = 200;
+
+// how long a client can leave the server waiting, while sending its query or
+// receiving the answer, in milliseconds
+static const int CLIENT_TIMEOUT = 10 * 1000;
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Writes to a socket, like std::cout writes to the standard output */
+struct socketBuffer : std::streambuf
+{
+    explicit socketBuffer( int _socket )
+        : m_socket( _socket )
+        , m_buffer( 64 * 1024 )
+    {
+        setp( m_buffer.data(), m_buffer.data() + m_buffer.size() );
+    }
+
+    /**@brief Sends bytes, waiting until they are all sent
+     * @return false if the connection has been closed */
+    static bool send( int _socket, const char * _data, size_t _size )
+    {
+        while( _size > 0 )
+        {
+            const ssize_t sent = ::send( _socket, _data, _size, MSG_NOSIGNAL );
+
+            if( sent < 0 && errno == EINTR )
+                continue;
+
+            if( sent <= 0 )
+                return false;
+
+            _data += sent;
+            _size -= static_cast<size_t>( sent );
+        }
+
+        return true;
+    }
+
+protected:
+    int overflow( int _character ) TATO_OVERRIDE
+    {
+        if( sync() != 0 )
+            return traits_type::eof();
+
+        if( !traits_type::eq_int_type( _character, traits_type::eof() ) )
+        {
+            *pptr() = traits_type::to_char_type( _character );
+            pbump( 1 );
+        }
+
+        return traits_type::not_eof( _character );
+    }
+
+    int sync() TATO_OVERRIDE
+    {
+        const bool sent = send( m_socket, pbase(), static_cast<size_t>( pptr() - pbase() ) );
+        setp( m_buffer.data(), m_buffer.data() + m_buffer.size() );
+        return sent ? 0 : -1;
+    }
+
+private:
+    int                 m_socket;
+    std::vector<char>   m_buffer;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Runs a query, as if tatoparser had been launched with its arguments
+ * @param[in] _csvPath The directory of the parsed csv files
+ * @param[out] output_ Where the sentences are written
+ * @param[out] error_ Why the query failed, if it did
+ * @return EXIT_SUCCESS or EXIT_FAILURE */
+static
+int answerQuery( std::vector<std::string> _arguments, const std::string & _csvPath,
+                 dataset & _allSentences, linkset & _allLinks, tagset & _allTags, listset & _allLists,
+                 const std::atomic<bool> & _quit, std::ostream & output_, std::string & error_ )
+{
+    std::string programName = "tatoparser";
+    std::vector<char *> argv { &programName[0] };
+
+    for( std::string & argument : _arguments )
+        argv.push_back( &argument[0] );
+
+    userOptions options;
+    FilterVector allFilters;
+
+    try
+    {
+        options.treatCommandLine( static_cast<int>( argv.size() ), argv.data() );
+
+        // the query is answered from the files the server parsed, next to
+        // which the indexes are kept
+        if( options.isCsvPathGiven() )
+        {
+            error_ = "--csv-path is given to the server, not to its queries";
+            return EXIT_FAILURE;
+        }
+
+        options.treatConfigFile();
+        options.getFilters( _allSentences, _allLinks, _allTags, _allLists, _csvPath, allFilters );
+    }
+    catch( const boost::program_options::error & err )
+    {
+        error_ = err.what();
+        return EXIT_FAILURE;
+    }
+    catch( const boost::regex_error & err )
+    {
+        error_ = std::string( "Invalid regular expression: " ) + err.what();
+        return EXIT_FAILURE;
+    }
+
+    if( options.isHelpRequested() || options.isVersionRequested() )
+    {
+        error_ = "--help and --version are not answered by the server";
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        stream_display out { output_, options.getSeparator() };
+        runQuery( options, allFilters, _allSentences, _allLinks, _allLists, out, _quit );
+        output_.flush();
+    }
+    catch( const unknown_list & )
+    {
+        error_ = "list \"" + toLower( options.getListName() ) + "\" does not exist in lists.csv";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Reads the query of a client, answers it and closes the connection */
+static
+void serveClient( int _client, const std::string & _csvPath,
+                  dataset & _allSentences, linkset & _allLinks, tagset & _allTags, listset & _allLists,
+                  const std::atomic<bool> & _quit )
+{
+    // a client which does not read its answer does not hold the thread
+    const timeval sendTimeout { CLIENT_TIMEOUT / 1000, 0 };
+    setsockopt( _client, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof( sendTimeout ) );
+
+    // the client closes its side of the connection once the query is sent.
+    // The socket is polled, so that neither a stop nor a silent client keeps
+    // the thread waiting
+    std::string query;
+    char buffer[4096];
+    ssize_t received = 0;
+    int idleTime = 0;
+    pollfd client { _client, POLLIN, 0 };
+
+    while( query.size() <= MAX_QUERY_SIZE && !_quit )
+    {
+        const int ready = poll( &client, 1, QUIT_POLL_PERIOD );
+        if( ready == 0 )
+        {
+            idleTime += QUIT_POLL_PERIOD;
+            if( idleTime < CLIENT_TIMEOUT )
+                continue;
+
+            received = -1;
+            break;
+        }
+
+        received = ready < 0 ? -1 : recv( _client, buffer, sizeof( buffer ), 0 );
+        if( received < 0 && errno == EINTR )
+            continue;
+
+        if( received <= 0 )
+            break;
+
+        query.append( buffer, static_cast<size_t>( received ) );
+        idleTime = 0;
+    }
+
+    if( _quit )
+    {
+        close( _client );
+        return;
+    }
+
+    std::vector<std::string> arguments;
+    std::string error;
+    int status = EXIT_FAILURE;
+
+    if( idleTime >= CLIENT_TIMEOUT )
+        error = "the query was not received in time";
+    else if( received < 0 )
+        error = "the query could not be read";
+    else if( query.size() > MAX_QUERY_SIZE )
+        error = "the query is too long";
+    else
+    {
+        for( size_t begin = 0, end = 0; ( end = query.find( '\0', begin ) ) != std::string::npos; begin = end + 1 )
+            arguments.push_back( query.substr( begin, end - begin ) );
+    }
+
+    socketBuffer output( _client );
+    std::ostream outputStream( &output );
+
+    try
+    {
+        if( error.empty() )
+            status = answerQuery( arguments, _csvPath, _allSentences, _allLinks, _allTags, _allLists, _quit, outputStream, error );
+    }
+    catch( const cannot_write & )
+    {
+        // the client went away
+        qlog::info << "a client closed the connection before the end of its answer\n";
+        close( _client );
+        return;
+    }
+
+    const std::string trailer = std::string( 1, '\0' ) + ( status == EXIT_SUCCESS ? '0' : '1' ) + error;
+    socketBuffer::send( _client, trailer.data(), trailer.size() );
+    close( _client );
+}
+
+// -------------------------------------------------------------------------- //
+
+int serve( const std::string & _socketPath, const std::string & _csvPath,
+           dataset & _allSentences, linkset & _allLinks, tagset & _allTags, listset & _allLists,
+           const std::atomic<bool> & _quit )
+{
+    sockaddr_un address;
+    memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+
+    if( _socketPath.size() >= sizeof( address.sun_path ) )
+    {
+        qlog::error << "The socket path " << _socketPath << " is too long\n";
+        return EXIT_FAILURE;
+    }
+
+    memcpy( address.sun_path, _socketPath.c_str(), _socketPath.size() );
+
+    const int listener = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( listener == -1 )
+    {
+        qlog::error << "Cannot create a socket: " << strerror( errno ) << '\n';
+        return EXIT_FAILURE;
+    }
+
+    unlink( _socketPath.c_str() );
+
+    if( bind( listener, reinterpret_cast<const sockaddr *>( &address ), sizeof( address ) ) == -1
+            || listen( listener, SOMAXCONN ) == -1 )
+    {
+        qlog::error << "Cannot listen on " << _socketPath << ": " << strerror( errno ) << '\n';
+        close( listener );
+        return EXIT_FAILURE;
+    }
+
+    // the connections are answered by a pool of threads, while this thread
+    // accepts them
+    std::mutex pendingMutex;
+    std::condition_variable pendingCondition;
+    std::deque<int> pendingClients;
+    bool stopping = false;
+
+    std::vector<std::thread> workers;
+    const unsigned nbWorkers = std::max( 1u, std::thread::hardware_concurrency() );
+
+    for( unsigned i = 0; i < nbWorkers; ++i )
+    {
+        workers.emplace_back( [&]()
+        {
+            for( ;; )
+            {
+                std::unique_lock<std::mutex> lock( pendingMutex );
+                pendingCondition.wait( lock, [&]() { return stopping || !pendingClients.empty(); } );
+
+                if( pendingClients.empty() )
+                    return;
+
+                const int client = pendingClients.front();
+                pendingClients.pop_front();
+                lock.unlock();
+
+                serveClient( client, _csvPath, _allSentences, _allLinks, _allTags, _allLists, _quit );
+            }
+        } );
+    }
+
+    qlog::info << "Answering queries on " << _socketPath << " with " << nbWorkers << " threads\n";
+
+    pollfd listening { listener, POLLIN, 0 };
+    while( !_quit )
+    {
+        if( poll( &listening, 1, QUIT_POLL_PERIOD ) <= 0 )
+            continue;
+
+        const int client = accept( listener, nullptr, nullptr );
+        if( client == -1 )
+        {
+            qlog::error( errno != EINTR ) << "Cannot accept a connection: " << strerror( errno ) << '\n';
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock( pendingMutex );
+        pendingClients.push_back( client );
+        pendingCondition.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( pendingMutex );
+        stopping = true;
+        pendingCondition.notify_all();
+    }
+
+    for( std::thread & worker : workers )
+        worker.join();
+
+    close( listener );
+    unlink( _socketPath.c_str() );
+
+    return EXIT_SUCCESS;
+}
+
+// -------------------------------------------------------------------------- //
+
+int forwardQuery( const std::string & _socketPath, const std::vector<std::string> & _arguments )
+{
+    sockaddr_un address;
+    memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+
+    if( _socketPath.size() >= sizeof( address.sun_path ) )
+    {
+        qlog::error << "The socket path " << _socketPath << " is too long\n";
+        return EXIT_FAILURE;
+    }
+
+    memcpy( address.sun_path, _socketPath.c_str(), _socketPath.size() );
+
+    const int server = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( server == -1 || connect( server, reinterpret_cast<const sockaddr *>( &address ), sizeof( address ) ) == -1 )
+    {
+        qlog::error << "Cannot connect to " << _socketPath << ": " << strerror( errno ) << '\n';
+        if( server != -1 )
+            close( server );
+        return EXIT_FAILURE;
+    }
+
+    std::string query;
+    for( const std::string & argument : _arguments )
+        query.append( argument ).push_back( '\0' );
+
+    if( !socketBuffer::send( server, query.data(), query.size() ) || shutdown( server, SHUT_WR ) == -1 )
+    {
+        qlog::error << "Cannot send the query to " << _socketPath << '\n';
+        close( server );
+        return EXIT_FAILURE;
+    }
+
+    // the sentences are written as they arrive, the status and the error
+    // message come after a null character
+    std::string trailer;
+    bool sentencesReceived = false;
+    char buffer[64 * 1024];
+    ssize_t received = 0;
+
+    while( ( received = recv( server, buffer, sizeof( buffer ), 0 ) ) > 0 || ( received < 0 && errno == EINTR ) )
+    {
+        const char * const begin = buffer;
+        const char * const end = buffer + std::max<ssize_t>( received, 0 );
+
+        if( sentencesReceived )
+        {
+            trailer.append( begin, end );
+            continue;
+        }
+
+        const char * const separator = std::find( begin, end, '\0' );
+        std::cout.write( begin, separator - begin );
+
+        if( separator != end )
+        {
+            sentencesReceived = true;
+            trailer.append( separator + 1, end );
+        }
+    }
+
+    close( server );
+    std::cout.flush();
+
+    if( !sentencesReceived || trailer.empty() )
+    {
+        qlog::error << "The server closed the connection before answering\n";
+        return EXIT_FAILURE;
+    }
+
+    qlog::error( trailer.size() > 1 ) << trailer.substr( 1 ) << '\n';
+
+    return trailer[0] == '0' ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#else
+
+int serve( const std::string &, const std::string &, dataset &, linkset &, tagset &, listset &, const std::atomic<bool> & )
+{
+    qlog::error << "This version of tatoparser cannot create sockets\n";
+    return EXIT_FAILURE;
+}
+
+int forwardQuery( const std::string &, const std::vector<std::string> & )
+{
+    qlog::error << "This version of tatoparser cannot create sockets\n";
+    return EXIT_FAILURE;
+}
+
+#endif
+
+NAMESPACE_END
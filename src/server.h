@@ -0,0 +1,43 @@
+#ifndef TATOPARSER_SERVER_H
+#define TATOPARSER_SERVER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <tatoparser/namespace.h>
+
+NAMESPACE_START
+
+struct dataset;
+struct linkset;
+struct tagset;
+struct listset;
+
+/**@brief Answers the queries sent to a UNIX socket, until _quit becomes true.
+ *
+ * A query is made of command line arguments, each followed by a null
+ * character, and ends with an empty argument. The answer is the text which
+ * tatoparser would have written, followed by a null character, by '0' or '1'
+ * depending on whether the query succeeded, and by an error message. The
+ * queries are answered by a pool of threads, which share the parsed files.
+ *
+ * @param[in] _socketPath Where the socket is created. An existing file is replaced.
+ * @param[in] _csvPath The directory of the parsed csv files, where the indexes
+ *            of the sentences are kept. The queries cannot give another one.
+ * @param[in] _quit Stops the server when it becomes true, even while clients
+ *            are connected
+ * @return EXIT_SUCCESS if the server stopped because of _quit, EXIT_FAILURE
+ *         if the socket could not be created */
+int serve( const std::string & _socketPath, const std::string & _csvPath,
+           dataset & _allSentences, linkset & _allLinks, tagset & _allTags, listset & _allLists,
+           const std::atomic<bool> & _quit );
+
+/**@brief Sends a query to a server started with serve(), writes the answer
+ *        to the standard output and the error message to the log.
+ * @param[in] _arguments The command line arguments of the query
+ * @return The status of the query, or EXIT_FAILURE if the server cannot be reached */
+int forwardQuery( const std::string & _socketPath, const std::vector<std::string> & _arguments );
+
+NAMESPACE_END
+
+#endif // TATOPARSER_SERVER_H
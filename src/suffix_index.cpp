@@ -0,0 +1,411 @@
+#include "prec.h"
+#include "suffix_index.h"
+#include "dataset_cache.h"
+#include <tatoparser/dataset.h>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+NAMESPACE_START
+
+// written at the start of the file, followed by the version of the format
+static const char INDEX_MAGIC[8] = { 'T', 'A', 'T', 'O', 'S', 'U', 'F', 'X' };
+static const uint64_t INDEX_VERSION = 1;
+
+// ends the text of each sentence
+static const uint8_t SENTENCE_END = '\n';
+
+// -------------------------------------------------------------------------- //
+
+bool findSearchedString( const std::string & _regex, std::string & string_ )
+{
+    static const char METACHARACTERS[] = ".[]()|*+?{}^$\\";
+
+    size_t position = 0;
+    auto accept = [&]( const char * _token ) -> bool
+    {
+        const size_t length = std::strlen( _token );
+        if( _regex.compare( position, length, _token ) != 0 )
+            return false;
+
+        position += length;
+        return true;
+    };
+
+    string_.clear();
+
+    accept( "^" );
+    accept( ".*" );
+
+    while( position < _regex.size() )
+    {
+        const char character = _regex[position];
+
+        if( character == '\\' && position + 1 < _regex.size() )
+        {
+            // \. or \( stand for themselves, \d or \< do not
+            const unsigned char escaped = static_cast<unsigned char>( _regex[position + 1] );
+            if( escaped < 0x80 && ( std::isalnum( escaped ) || std::strchr( "<>`'", escaped ) != nullptr ) )
+                break;
+
+            string_.push_back( static_cast<char>( escaped ) );
+            position += 2;
+        }
+        else if( std::strchr( METACHARACTERS, character ) == nullptr )
+        {
+            string_.push_back( character );
+            ++position;
+        }
+        else
+            break;
+    }
+
+    // a character followed by a repetition does not belong to the string
+    if( position < _regex.size() && std::strchr( "*+?{", _regex[position] ) != nullptr )
+        return false;
+
+    accept( ".*" );
+    accept( "$" );
+
+    return position == _regex.size() && !string_.empty() && string_.find( static_cast<char>( SENTENCE_END ) ) == std::string::npos;
+}
+
+// -------------------------------------------------------------------------- //
+// SA-IS, from "Linear Suffix Array Construction by Almost Pure Induced-Sorting",
+// Nong, Zhang and Chan, 2009. The last symbol of the text must be the
+// smallest, and appear nowhere else.
+
+static const uint32_t NO_SUFFIX = std::numeric_limits<uint32_t>::max();
+
+// where the suffixes starting with each symbol begin, or end, in the array
+template<typename SYMBOL> static
+void getBuckets( const SYMBOL * _text, size_t _size, size_t _nbSymbols, std::vector<uint32_t> & buckets_, bool _end )
+{
+    buckets_.assign( _nbSymbols, 0 );
+    for( size_t i = 0; i < _size; ++i )
+        ++buckets_[ _text[i] ];
+
+    uint32_t sum = 0;
+    for( size_t symbol = 0; symbol < _nbSymbols; ++symbol )
+    {
+        sum += buckets_[symbol];
+        buckets_[symbol] = _end ? sum : sum - buckets_[symbol];
+    }
+}
+
+// a suffix smaller than the next one, which follows a greater one
+static inline
+bool isLeftmostSmaller( const std::vector<bool> & _smaller, uint32_t _position )
+{
+    return _position > 0 && _position != NO_SUFFIX && _smaller[_position] && !_smaller[_position - 1];
+}
+
+// sorts the other suffixes from the sorted leftmost smaller ones
+template<typename SYMBOL> static
+void induceSort( const SYMBOL * _text, uint32_t * suffixes_, size_t _size, size_t _nbSymbols,
+                 const std::vector<bool> & _smaller, std::vector<uint32_t> & buckets_ )
+{
+    getBuckets( _text, _size, _nbSymbols, buckets_, false );
+    for( size_t i = 0; i < _size; ++i )
+    {
+        if( suffixes_[i] != NO_SUFFIX && suffixes_[i] > 0 && !_smaller[ suffixes_[i] - 1 ] )
+            suffixes_[ buckets_[ _text[ suffixes_[i] - 1 ] ]++ ] = suffixes_[i] - 1;
+    }
+
+    getBuckets( _text, _size, _nbSymbols, buckets_, true );
+    for( size_t i = _size; i-- > 0; )
+    {
+        if( suffixes_[i] != NO_SUFFIX && suffixes_[i] > 0 && _smaller[ suffixes_[i] - 1 ] )
+            suffixes_[ --buckets_[ _text[ suffixes_[i] - 1 ] ] ] = suffixes_[i] - 1;
+    }
+}
+
+template<typename SYMBOL> static
+void sortSuffixes( const SYMBOL * _text, uint32_t * suffixes_, size_t _size, size_t _nbSymbols )
+{
+    if( _size == 1 )
+    {
+        suffixes_[0] = 0;
+        return;
+    }
+
+    // whether each suffix is smaller than the next one
+    std::vector<bool> smaller( _size, false );
+    smaller[_size - 1] = true;
+    for( size_t i = _size - 1; i-- > 0; )
+        smaller[i] = _text[i] < _text[i + 1] || ( _text[i] == _text[i + 1] && smaller[i + 1] );
+
+    // first, the leftmost smaller suffixes are sorted on their first substring
+    std::vector<uint32_t> buckets;
+    getBuckets( _text, _size, _nbSymbols, buckets, true );
+    std::fill( suffixes_, suffixes_ + _size, NO_SUFFIX );
+
+    for( uint32_t i = 1; i < _size; ++i )
+    {
+        if( isLeftmostSmaller( smaller, i ) )
+            suffixes_[ --buckets[ _text[i] ] ] = i;
+    }
+
+    induceSort( _text, suffixes_, _size, _nbSymbols, smaller, buckets );
+
+    size_t nbLeftmost = 0;
+    for( size_t i = 0; i < _size; ++i )
+    {
+        if( isLeftmostSmaller( smaller, suffixes_[i] ) )
+            suffixes_[nbLeftmost++] = suffixes_[i];
+    }
+
+    // then those substrings are named after their rank, the same substrings
+    // having the same name
+    std::fill( suffixes_ + nbLeftmost, suffixes_ + _size, NO_SUFFIX );
+
+    uint32_t nbNames = 0;
+    uint32_t previous = NO_SUFFIX;
+    for( size_t i = 0; i < nbLeftmost; ++i )
+    {
+        const uint32_t position = suffixes_[i];
+        bool different = false;
+
+        for( uint32_t d = 0; ; ++d )
+        {
+            if( previous == NO_SUFFIX || _text[position + d] != _text[previous + d] || smaller[position + d] != smaller[previous + d] )
+            {
+                different = true;
+                break;
+            }
+
+            if( d > 0 && ( isLeftmostSmaller( smaller, position + d ) || isLeftmostSmaller( smaller, previous + d ) ) )
+                break;
+        }
+
+        if( different )
+        {
+            ++nbNames;
+            previous = position;
+        }
+
+        suffixes_[ nbLeftmost + position / 2 ] = nbNames - 1;
+    }
+
+    for( size_t i = _size, j = _size; i-- > nbLeftmost; )
+    {
+        if( suffixes_[i] != NO_SUFFIX )
+            suffixes_[--j] = suffixes_[i];
+    }
+
+    // the names, in the order of the text, form a shorter text whose suffixes
+    // are sorted like the leftmost smaller suffixes
+    uint32_t * const reduced = suffixes_ + _size - nbLeftmost;
+
+    if( nbNames < nbLeftmost )
+        sortSuffixes<uint32_t>( reduced, suffixes_, nbLeftmost, nbNames );
+    else
+    {
+        for( uint32_t i = 0; i < nbLeftmost; ++i )
+            suffixes_[ reduced[i] ] = i;
+    }
+
+    // and lastly, all the suffixes are sorted from them
+    getBuckets( _text, _size, _nbSymbols, buckets, true );
+
+    for( uint32_t i = 1, j = 0; i < _size; ++i )
+    {
+        if( isLeftmostSmaller( smaller, i ) )
+            reduced[j++] = i;
+    }
+
+    for( size_t i = 0; i < nbLeftmost; ++i )
+        suffixes_[i] = reduced[ suffixes_[i] ];
+
+    std::fill( suffixes_ + nbLeftmost, suffixes_ + _size, NO_SUFFIX );
+
+    for( size_t i = nbLeftmost; i-- > 0; )
+    {
+        const uint32_t position = suffixes_[i];
+        suffixes_[i] = NO_SUFFIX;
+        suffixes_[ --buckets[ _text[position] ] ] = position;
+    }
+
+    induceSort( _text, suffixes_, _size, _nbSymbols, smaller, buckets );
+}
+
+// -------------------------------------------------------------------------- //
+
+// tells whether an index was built from a text
+static
+uint64_t computeFingerprint( const std::vector<uint8_t> & _text )
+{
+    uint64_t hash = 0xcbf29ce484222325ull ^ _text.size();
+
+    size_t i = 0;
+    for( ; i + sizeof( uint64_t ) <= _text.size(); i += sizeof( uint64_t ) )
+    {
+        uint64_t word;
+        std::memcpy( &word, &_text[i], sizeof( word ) );
+        hash = ( hash ^ word ) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 32;
+    }
+
+    for( ; i < _text.size(); ++i )
+        hash = ( hash ^ _text[i] ) * 0x100000001b3ull;
+
+    return hash;
+}
+
+// -------------------------------------------------------------------------- //
+
+std::shared_ptr<const suffixIndex> suffixIndex::get( const dataset & _dataset, const std::string & _path )
+{
+    // the index last used, for the queries which come after
+    static datasetCache<suffixIndex> cache;
+
+    return cache.get( _dataset, [&_dataset, &_path]()
+    {
+        std::shared_ptr<suffixIndex> index( new suffixIndex() );
+
+        // the texts, each followed by a new line, and a null character which ends them
+        index->m_sentenceBegin.reserve( _dataset.size() );
+        for( const sentence & current : _dataset )
+        {
+            if( index->m_text.size() + current.size() + 2 >= NO_SUFFIX )
+            {
+                qlog::warning << "The sentences are too long to be held in a suffix array\n";
+                return std::shared_ptr<const suffixIndex>();
+            }
+
+            index->m_sentenceBegin.push_back( static_cast<uint32_t>( index->m_text.size() ) );
+            index->m_text.insert( index->m_text.end(), current.begin(), current.end() );
+            index->m_text.push_back( SENTENCE_END );
+        }
+
+        std::replace( index->m_text.begin(), index->m_text.end(), uint8_t( 0 ), SENTENCE_END );
+        index->m_text.push_back( 0 );
+
+        const uint64_t fingerprint = computeFingerprint( index->m_text );
+
+        if( index->load( _path, fingerprint ) )
+            qlog::info << "Read the suffix array " << _path << '\n';
+        else
+        {
+            qlog::info << "Building the suffix array " << _path << '\n';
+
+            index->m_suffixes.resize( index->m_text.size() );
+            sortSuffixes( index->m_text.data(), index->m_suffixes.data(), index->m_text.size(), 256 );
+
+            // the suffix made of the null character alone comes first
+            index->m_suffixes.erase( index->m_suffixes.begin() );
+
+            if( !index->save( _path, fingerprint ) )
+                qlog::warning << "Could not write the suffix array " << _path << '\n';
+        }
+
+        return std::shared_ptr<const suffixIndex>( index );
+    } );
+}
+
+// -------------------------------------------------------------------------- //
+
+bool suffixIndex::save( const std::string & _path, uint64_t _fingerprint ) const
+{
+    // written aside first, so that the file is never read half written
+    const std::string temporaryPath = _path + ".tmp";
+
+    {
+        std::ofstream out( temporaryPath.c_str(), std::ios::binary | std::ios::trunc );
+
+        const uint64_t nbSuffixes = m_suffixes.size();
+        out.write( INDEX_MAGIC, sizeof( INDEX_MAGIC ) );
+        out.write( reinterpret_cast<const char *>( &INDEX_VERSION ), sizeof( INDEX_VERSION ) );
+        out.write( reinterpret_cast<const char *>( &_fingerprint ), sizeof( _fingerprint ) );
+        out.write( reinterpret_cast<const char *>( &nbSuffixes ), sizeof( nbSuffixes ) );
+        out.write( reinterpret_cast<const char *>( m_suffixes.data() ), static_cast<std::streamsize>( nbSuffixes * sizeof( uint32_t ) ) );
+
+        if( !out.flush() )
+        {
+            std::remove( temporaryPath.c_str() );
+            return false;
+        }
+    }
+
+    return std::rename( temporaryPath.c_str(), _path.c_str() ) == 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+bool suffixIndex::load( const std::string & _path, uint64_t _fingerprint )
+{
+    std::ifstream in( _path.c_str(), std::ios::binary );
+
+    char magic[sizeof( INDEX_MAGIC )];
+    uint64_t version = 0, fingerprint = 0, nbSuffixes = 0;
+
+    if( !in.read( magic, sizeof( magic ) ) ||
+        !in.read( reinterpret_cast<char *>( &version ), sizeof( version ) ) ||
+        !in.read( reinterpret_cast<char *>( &fingerprint ), sizeof( fingerprint ) ) ||
+        !in.read( reinterpret_cast<char *>( &nbSuffixes ), sizeof( nbSuffixes ) ) )
+    {
+        return false;
+    }
+
+    // an index of other sentences, or of an older version, is built again
+    if( std::memcmp( magic, INDEX_MAGIC, sizeof( magic ) ) != 0 || version != INDEX_VERSION ||
+        fingerprint != _fingerprint || nbSuffixes + 1 != m_text.size() )
+    {
+        return false;
+    }
+
+    m_suffixes.resize( nbSuffixes );
+    return static_cast<bool>( in.read( reinterpret_cast<char *>( m_suffixes.data() ), static_cast<std::streamsize>( nbSuffixes * sizeof( uint32_t ) ) ) );
+}
+
+// -------------------------------------------------------------------------- //
+
+std::pair<size_t, size_t> suffixIndex::findRange( const std::string & _string ) const
+{
+    const uint8_t * const searched = reinterpret_cast<const uint8_t *>( _string.data() );
+    const size_t length = _string.size();
+
+    // compares the start of a suffix with the string
+    auto compare = [&]( uint32_t _suffix ) -> int
+    {
+        const size_t suffixLength = m_text.size() - _suffix;
+        const int order = std::memcmp( &m_text[_suffix], searched, std::min( suffixLength, length ) );
+        return order != 0 ? order : ( suffixLength < length ? -1 : 0 );
+    };
+
+    const std::vector<uint32_t>::const_iterator first =
+        std::partition_point( m_suffixes.begin(), m_suffixes.end(), [&]( uint32_t _suffix ) { return compare( _suffix ) < 0; } );
+    const std::vector<uint32_t>::const_iterator last =
+        std::partition_point( first, m_suffixes.end(), [&]( uint32_t _suffix ) { return compare( _suffix ) == 0; } );
+
+    return std::make_pair( static_cast<size_t>( first - m_suffixes.begin() ), static_cast<size_t>( last - m_suffixes.begin() ) );
+}
+
+// -------------------------------------------------------------------------- //
+
+size_t suffixIndex::count( const std::string & _string ) const
+{
+    const std::pair<size_t, size_t> range = findRange( _string );
+    return range.second - range.first;
+}
+
+// -------------------------------------------------------------------------- //
+
+sentenceBitmap suffixIndex::select( const std::string & _string ) const
+{
+    sentenceBitmap selected( m_sentenceBegin.size() );
+    const std::pair<size_t, size_t> range = findRange( _string );
+
+    for( size_t i = range.first; i < range.second; ++i )
+    {
+        // the sentence which holds the suffix
+        const std::vector<uint32_t>::const_iterator begin = std::upper_bound( m_sentenceBegin.begin(), m_sentenceBegin.end(), m_suffixes[i] );
+        selected.set( static_cast<size_t>( begin - m_sentenceBegin.begin() ) - 1 );
+    }
+
+    return selected;
+}
+
+NAMESPACE_END
@@ -0,0 +1,67 @@
+#ifndef TATOPARSER_SUFFIX_INDEX_H
+#define TATOPARSER_SUFFIX_INDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bitmap.h"
+
+NAMESPACE_START
+
+struct dataset;
+
+/**@brief Tells whether a regular expression only looks for a string, like
+ *        '.*XYZ.*' or '^.*XYZ.*$', in which case the sentences which can
+ *        match are those holding the string. A string at the start or the
+ *        end, like 'XYZ.*', is accepted too.
+ * @param[out] string_ The string, if there is one
+ * @return false if the expression is more than a string */
+bool findSearchedString( const std::string & _regex, std::string & string_ );
+
+// -------------------------------------------------------------------------- //
+
+/**@struct suffixIndex
+ * @brief A suffix array of the text of all the sentences, which finds the
+ *        sentences holding a string in O( length of the string * log( size
+ *        of the text ) + number of occurrences ).
+ *
+ * The texts are concatenated, each followed by a new line, which no string
+ * searched for holds. The array is sorted with SA-IS, in linear time. */
+struct suffixIndex
+{
+    /**@brief Returns the index of some sentences. It is read from a file if
+     *        the file was written for the same sentences, and built and
+     *        written in the file if not. The index is then kept for the next
+     *        calls with the same sentences, like the queries of a server.
+     * @param[in] _path Where the suffix array is stored */
+    static std::shared_ptr<const suffixIndex> get( const dataset & _dataset, const std::string & _path );
+
+    /**@brief Counts the occurrences of a string in all the sentences */
+    size_t count( const std::string & _string ) const;
+
+    /**@brief Returns the sentences which hold a string */
+    sentenceBitmap select( const std::string & _string ) const;
+
+private:
+    suffixIndex(): m_text(), m_sentenceBegin(), m_suffixes() { }
+
+    bool load( const std::string & _path, uint64_t _fingerprint );
+    bool save( const std::string & _path, uint64_t _fingerprint ) const;
+
+    // the suffixes which start with a string
+    std::pair<size_t, size_t> findRange( const std::string & _string ) const;
+
+private:
+    // the texts of the sentences, in the order of the dataset, and where each
+    // of them begins in it
+    std::vector<uint8_t>    m_text;
+    std::vector<uint32_t>   m_sentenceBegin;
+
+    // the positions of the suffixes of m_text, in lexicographic order
+    std::vector<uint32_t>   m_suffixes;
+};
+
+NAMESPACE_END
+
+#endif // TATOPARSER_SUFFIX_INDEX_H
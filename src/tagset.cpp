@@ -5,28 +5,98 @@ NAMESPACE_START
 
 tagset::tagset()
     :m_tagToSentences()
-    ,m_nameToId()
+    ,m_names()
+    ,m_loader()
 {
 }
 
 // -------------------------------------------------------------------------- //
 
-bool tagset::isSentenceTagged( sentence::id _id, tagId _tag )
+bool tagset::isSentenceTagged( sentence::id _id, tagId _tag ) const
 {
-    sentenceList & TATO_RESTRICT
-        allSentencesMatchingTheTag = m_tagToSentences[ _tag ];
+    loadIfNeeded();
+
+    const sentenceList & allSentencesMatchingTheTag = getTaggedSentences( _tag );
 
     return std::find(
-        allSentencesMatchingTheTag.begin(),
-        allSentencesMatchingTheTag.end(),
-        _id) != allSentencesMatchingTheTag.end();
+            allSentencesMatchingTheTag.begin(),
+            allSentencesMatchingTheTag.end(),
+            _id) != allSentencesMatchingTheTag.end();
+}
+
+// -------------------------------------------------------------------------- //
+
+const std::vector<sentence::id> & tagset::getTaggedSentences( tagId _tag ) const
+{
+    loadIfNeeded();
+
+    static const sentenceList noSentence;
+
+    return _tag == INVALID_TAGID || _tag > m_tagToSentences.size() ? noSentence : m_tagToSentences[ _tag - 1 ];
+}
+
+// -------------------------------------------------------------------------- //
+
+tagset::tagId tagset::findTagId( const std::string & _tagName ) const
+{
+    loadIfNeeded();
+
+    return m_names.find( _tagName );
+}
+
+// -------------------------------------------------------------------------- //
+
+void tagset::addTag( sentence::id _id, const std::string & _tagName )
+{
+    const tagId tag = getTagId( toLower( _tagName ) );
+
+    if( !isSentenceTagged( _id, tag ) )
+        tagSentence( _id, tag );
+}
+
+// -------------------------------------------------------------------------- //
+
+bool tagset::removeTag( sentence::id _id, const std::string & _tagName )
+{
+    loadIfNeeded();
+
+    const tagId tag = m_names.find( _tagName.data(), _tagName.data() + _tagName.size(), true );
+    if( tag == INVALID_TAGID || tag > m_tagToSentences.size() )
+        return false;
+
+    sentenceList & taggedSentences = m_tagToSentences[ tag - 1 ];
+    const sentenceList::iterator position = std::find( taggedSentences.begin(), taggedSentences.end(), _id );
+
+    if( position == taggedSentences.end() )
+        return false;
+
+    *position = taggedSentences.back();
+    taggedSentences.pop_back();
+    return true;
 }
 
 // -------------------------------------------------------------------------- //
 
-void tagset::tagSentence( sentence::id _id, tagset::tagId _newTag )
+void tagset::merge( tagset && _other )
 {
-    m_tagToSentences[ _newTag ].push_back(_id);
+    for( tagId otherTag = 1; otherTag <= _other.m_names.size(); ++otherTag )
+    {
+        const std::string name = _other.m_names.getName( otherTag );
+        const tagId tag = m_names.intern( name.data(), name.data() + name.size(), false );
+
+        if( otherTag > _other.m_tagToSentences.size() )
+            continue;
+
+        sentenceList & otherSentences = _other.m_tagToSentences[ otherTag - 1 ];
+        if( tag > m_tagToSentences.size() )
+            m_tagToSentences.resize( tag );
+
+        sentenceList & sentences = m_tagToSentences[ tag - 1 ];
+        if( sentences.empty() )
+            sentences.swap( otherSentences );
+        else
+            sentences.insert( sentences.end(), otherSentences.begin(), otherSentences.end() );
+    }
 }
 
 NAMESPACE_END
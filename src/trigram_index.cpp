@@ -0,0 +1,794 @@
+#include "prec.h"
+#include "trigram_index.h"
+#include "dataset_cache.h"
+#include <tatoparser/dataset.h>
+#include <unicode/utf8.h>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+NAMESPACE_START
+
+// written at the start of the file, followed by the version of the format
+static const char INDEX_MAGIC[8] = { 'T', 'A', 'T', 'O', 'G', 'R', 'A', 'M' };
+static const uint64_t INDEX_VERSION = 1;
+
+static const uint64_t BIGRAM_BIT = uint64_t( 1 ) << 63;
+
+// -------------------------------------------------------------------------- //
+
+// the characters which are written without spaces between words, so that a
+// word often holds only 2 of them
+static inline
+bool isIdeographic( UChar32 _character )
+{
+    return ( _character >= 0x2E80 && _character <= 0x9FFF )   || // CJK radicals, kana, ideographs
+           ( _character >= 0xAC00 && _character <= 0xD7AF )   || // hangul syllables
+           ( _character >= 0xF900 && _character <= 0xFAFF )   || // CJK compatibility ideographs
+           ( _character >= 0x20000 && _character <= 0x3FFFF );   // CJK extensions
+}
+
+static inline
+uint64_t trigram( UChar32 _first, UChar32 _second, UChar32 _third )
+{
+    return ( uint64_t( _first ) << 42 ) | ( uint64_t( _second ) << 21 ) | uint64_t( _third );
+}
+
+static inline
+uint64_t bigram( UChar32 _first, UChar32 _second )
+{
+    return BIGRAM_BIT | ( uint64_t( _first ) << 21 ) | uint64_t( _second );
+}
+
+// -------------------------------------------------------------------------- //
+
+// decodes UTF-8, the invalid bytes becoming negative values which are in no gram
+static
+void decodeCharacters( const char * _begin, const char * _end, std::vector<UChar32> & characters_ )
+{
+    const uint8_t * const text = reinterpret_cast<const uint8_t *>( _begin );
+    const int32_t length = static_cast<int32_t>( _end - _begin );
+
+    characters_.clear();
+    for( int32_t i = 0; i < length; )
+    {
+        UChar32 character;
+        U8_NEXT( text, i, length, character );
+        characters_.push_back( character );
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+// the grams of a text, each once
+static
+void collectGrams( const std::vector<UChar32> & _characters, std::vector<uint64_t> & grams_ )
+{
+    grams_.clear();
+
+    for( size_t i = 0; i + 1 < _characters.size(); ++i )
+    {
+        const UChar32 first = _characters[i], second = _characters[i + 1];
+        if( first < 0 || second < 0 )
+            continue;
+
+        if( i + 2 < _characters.size() && _characters[i + 2] >= 0 )
+            grams_.push_back( trigram( first, second, _characters[i + 2] ) );
+
+        if( isIdeographic( first ) && isIdeographic( second ) )
+            grams_.push_back( bigram( first, second ) );
+    }
+
+    std::sort( grams_.begin(), grams_.end() );
+    grams_.erase( std::unique( grams_.begin(), grams_.end() ), grams_.end() );
+}
+
+// -------------------------------------------------------------------------- //
+
+// adds an operand to a query of kind AND, which any sentence matching it matches
+static
+void addOperand( gramQuery & and_, const gramQuery & _operand )
+{
+    if( _operand.m_kind == gramQuery::ALL )
+        return;
+
+    if( _operand.m_kind == gramQuery::AND )
+        and_.m_children.insert( and_.m_children.end(), _operand.m_children.begin(), _operand.m_children.end() );
+    else
+        and_.m_children.push_back( _operand );
+}
+
+// -------------------------------------------------------------------------- //
+
+// a query of kind AND or OR with no or a single operand is simplified
+static
+gramQuery simplify( gramQuery _query )
+{
+    if( _query.m_children.empty() )
+        return gramQuery( gramQuery::ALL );
+
+    if( _query.m_children.size() == 1 )
+        return _query.m_children.front();
+
+    return _query;
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@struct regexAnalyzer
+ * @brief Goes through a regular expression in the perl syntax, looking for the
+ *        strings a sentence must hold to match it */
+struct regexAnalyzer
+{
+    // thrown when the expression uses a syntax which is not understood
+    struct unknownSyntax { };
+
+    explicit regexAnalyzer( const std::string & _regex )
+        : m_pattern()
+        , m_position( 0 )
+    {
+        decodeCharacters( _regex.data(), _regex.data() + _regex.size(), m_pattern );
+
+        if( std::find_if( m_pattern.begin(), m_pattern.end(), []( UChar32 _character ) { return _character < 0; } ) != m_pattern.end() )
+            throw unknownSyntax();
+    }
+
+    gramQuery analyze()
+    {
+        gramQuery query = parseAlternation();
+
+        if( m_position != m_pattern.size() )
+            throw unknownSyntax();
+
+        return query;
+    }
+
+private:
+    enum repetition { ONCE, OPTIONAL, REPEATED };
+
+    // alternation := sequence ( "|" sequence )*
+    gramQuery parseAlternation()
+    {
+        gramQuery alternatives( gramQuery::OR );
+
+        bool matchesAll = false;
+        do
+        {
+            const gramQuery alternative = parseSequence();
+            matchesAll |= ( alternative.m_kind == gramQuery::ALL );
+            alternatives.m_children.push_back( alternative );
+        }
+        while( accept( '|' ) );
+
+        return matchesAll ? gramQuery( gramQuery::ALL ) : simplify( alternatives );
+    }
+
+    // the atoms until the end of the alternative, and the strings they form
+    gramQuery parseSequence()
+    {
+        gramQuery sequence( gramQuery::AND );
+        std::vector<UChar32> literal;
+
+        while( m_position < m_pattern.size() && m_pattern[m_position] != '|' && m_pattern[m_position] != ')' )
+        {
+            const UChar32 character = m_pattern[m_position++];
+
+            switch( character )
+            {
+            case '(':
+            {
+                if( accept( '?' ) && !accept( ':' ) )
+                    throw unknownSyntax();
+
+                if( m_position < m_pattern.size() && m_pattern[m_position] == '*' )
+                    throw unknownSyntax();
+
+                const gramQuery group = parseAlternation();
+                if( !accept( ')' ) )
+                    throw unknownSyntax();
+
+                addOperand( sequence, literalQuery( literal ) );
+                if( readRepetition() != OPTIONAL )
+                    addOperand( sequence, group );
+                break;
+            }
+
+            case '[':
+                skipClass();
+                readRepetition();
+                addOperand( sequence, literalQuery( literal ) );
+                break;
+
+            case '\\':
+                if( m_position == m_pattern.size() )
+                    throw unknownSyntax();
+
+                if( isLiteralEscape( m_pattern[m_position] ) )
+                    addCharacter( m_pattern[m_position++], sequence, literal );
+                else
+                {
+                    skipEscape();
+                    readRepetition();
+                    addOperand( sequence, literalQuery( literal ) );
+                }
+                break;
+
+            case '.': case '^': case '$':
+                readRepetition();
+                addOperand( sequence, literalQuery( literal ) );
+                break;
+
+            case '*': case '+': case '?': case '{':
+                // a repetition of nothing
+                throw unknownSyntax();
+
+            default:
+                addCharacter( character, sequence, literal );
+                break;
+            }
+        }
+
+        addOperand( sequence, literalQuery( literal ) );
+        return simplify( sequence );
+    }
+
+    // a character written literally, which can be repeated
+    void addCharacter( UChar32 _character, gramQuery & sequence_, std::vector<UChar32> & literal_ )
+    {
+        switch( readRepetition() )
+        {
+        case ONCE:
+            literal_.push_back( _character );
+            break;
+
+        case OPTIONAL:
+            addOperand( sequence_, literalQuery( literal_ ) );
+            break;
+
+        case REPEATED:
+            // the first and the last occurrences of the character are
+            // followed and preceded by the rest of the string
+            literal_.push_back( _character );
+            addOperand( sequence_, literalQuery( literal_ ) );
+            literal_.push_back( _character );
+            break;
+        }
+    }
+
+    // reads *, +, ?, {n}, {n,} or {n,m}, and the ? or + which can follow
+    repetition readRepetition()
+    {
+        if( m_position == m_pattern.size() )
+            return ONCE;
+
+        repetition read = ONCE;
+
+        switch( m_pattern[m_position] )
+        {
+        case '*': case '?':
+            read = OPTIONAL;
+            ++m_position;
+            break;
+
+        case '+':
+            read = REPEATED;
+            ++m_position;
+            break;
+
+        case '{':
+        {
+            ++m_position;
+            const size_t minimum = readNumber();
+            size_t maximum = minimum;
+
+            if( accept( ',' ) )
+                maximum = ( m_position < m_pattern.size() && m_pattern[m_position] == '}' ) ? 2 : readNumber();
+
+            if( !accept( '}' ) )
+                throw unknownSyntax();
+
+            read = minimum == 0 ? OPTIONAL : ( maximum > 1 ? REPEATED : ONCE );
+            break;
+        }
+
+        default:
+            return ONCE;
+        }
+
+        // lazy or possessive
+        if( !accept( '?' ) )
+            accept( '+' );
+
+        if( m_position < m_pattern.size() &&
+            ( m_pattern[m_position] == '*' || m_pattern[m_position] == '+' || m_pattern[m_position] == '?' || m_pattern[m_position] == '{' ) )
+        {
+            throw unknownSyntax();
+        }
+
+        return read;
+    }
+
+    size_t readNumber()
+    {
+        const size_t begin = m_position;
+        size_t number = 0;
+
+        for( ; m_position < m_pattern.size() && m_pattern[m_position] >= '0' && m_pattern[m_position] <= '9'; ++m_position )
+            number = std::min<size_t>( number * 10 + static_cast<size_t>( m_pattern[m_position] - '0' ), 1000000 );
+
+        if( m_position == begin )
+            throw unknownSyntax();
+
+        return number;
+    }
+
+    // goes past a class like [a-z] or [^[:digit:]\]]
+    void skipClass()
+    {
+        accept( '^' );
+        accept( ']' );
+
+        while( m_position < m_pattern.size() && m_pattern[m_position] != ']' )
+        {
+            if( m_pattern[m_position] == '\\' )
+                ++m_position;
+            else if( m_pattern[m_position] == '[' && m_position + 1 < m_pattern.size() &&
+                     ( m_pattern[m_position + 1] == ':' || m_pattern[m_position + 1] == '.' || m_pattern[m_position + 1] == '=' ) )
+            {
+                // [:alpha:], [.a.] or [=a=]
+                const UChar32 delimiter = m_pattern[m_position + 1];
+                for( m_position += 2; m_position + 1 < m_pattern.size() && !( m_pattern[m_position] == delimiter && m_pattern[m_position + 1] == ']' ); )
+                    ++m_position;
+                ++m_position;
+            }
+
+            ++m_position;
+        }
+
+        if( !accept( ']' ) )
+            throw unknownSyntax();
+    }
+
+    // the escapes of a single character which stand for something else than
+    // themselves, like \d or \b, are skipped, the others are not understood
+    void skipEscape()
+    {
+        static const char SINGLE_CHARACTER_ESCAPES[] = "dDwWsShHvVluUbBAzZGntrfae123456789<>`'";
+
+        const UChar32 escaped = m_pattern[m_position++];
+        if( std::strchr( SINGLE_CHARACTER_ESCAPES, static_cast<int>( escaped ) ) == nullptr )
+            throw unknownSyntax();
+    }
+
+    static bool isLiteralEscape( UChar32 _character )
+    {
+        return _character >= 0x80 ||
+               ( !std::isalnum( static_cast<int>( _character ) ) && _character != '<' && _character != '>' &&
+                 _character != '`' && _character != '\'' );
+    }
+
+    // the grams of a string, which are all in the sentences holding it
+    static gramQuery literalQuery( std::vector<UChar32> & literal_ )
+    {
+        gramQuery grams( gramQuery::AND );
+
+        for( size_t i = 0; i + 2 < literal_.size(); ++i )
+            grams.m_children.push_back( gramQuery( gramQuery::GRAM, trigram( literal_[i], literal_[i + 1], literal_[i + 2] ) ) );
+
+        if( literal_.size() == 2 && isIdeographic( literal_[0] ) && isIdeographic( literal_[1] ) )
+            grams.m_children.push_back( gramQuery( gramQuery::GRAM, bigram( literal_[0], literal_[1] ) ) );
+
+        literal_.clear();
+        return simplify( grams );
+    }
+
+    bool accept( UChar32 _character )
+    {
+        if( m_position < m_pattern.size() && m_pattern[m_position] == _character )
+        {
+            ++m_position;
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    std::vector<UChar32>    m_pattern;
+    size_t                  m_position;
+};
+
+// -------------------------------------------------------------------------- //
+
+gramQuery analyzeRegex( const std::string & _regex )
+{
+    try
+    {
+        return regexAnalyzer( _regex ).analyze();
+    }
+    catch( const regexAnalyzer::unknownSyntax & )
+    {
+        return gramQuery( gramQuery::ALL );
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+// tells whether an index was built from some sentences, from their ids and text
+static
+uint64_t computeFingerprint( const dataset & _dataset )
+{
+    uint64_t hash = 0xcbf29ce484222325ull ^ _dataset.size();
+    auto mix = [&hash]( uint64_t _word )
+    {
+        hash = ( hash ^ _word ) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 32;
+    };
+
+    for( const sentence & current : _dataset )
+    {
+        mix( current.getId() );
+        mix( current.size() );
+
+        const char * text = current.begin();
+        for( ; text + sizeof( uint64_t ) <= current.end(); text += sizeof( uint64_t ) )
+        {
+            uint64_t word;
+            std::memcpy( &word, text, sizeof( word ) );
+            mix( word );
+        }
+
+        if( text != current.end() )
+        {
+            uint64_t tail = 0;
+            std::memcpy( &tail, text, static_cast<size_t>( current.end() - text ) );
+            mix( tail );
+        }
+    }
+
+    return hash;
+}
+
+// -------------------------------------------------------------------------- //
+
+std::shared_ptr<const trigramIndex> trigramIndex::get( const dataset & _dataset, const std::string & _path )
+{
+    // the index last used, for the queries which come after
+    static datasetCache<trigramIndex> cache;
+
+    return cache.get( _dataset, [&_dataset, &_path]()
+    {
+        // only the index kept on the disk has to be checked against the text of the sentences
+        const uint64_t fingerprint = computeFingerprint( _dataset );
+        std::shared_ptr<trigramIndex> index( new trigramIndex() );
+
+        if( index->load( _path, fingerprint ) )
+            qlog::info << "Read the trigram index " << _path << '\n';
+        else
+        {
+            qlog::info << "Building the trigram index " << _path << '\n';
+            index->build( _dataset );
+
+            if( !index->save( _path, fingerprint ) )
+                qlog::warning << "Could not write the trigram index " << _path << '\n';
+        }
+
+        return std::shared_ptr<const trigramIndex>( index );
+    } );
+}
+
+// -------------------------------------------------------------------------- //
+
+void trigramIndex::build( const dataset & _dataset )
+{
+    std::vector<UChar32> characters;
+    std::vector<uint64_t> grams;
+
+    // first, how many sentences hold each gram
+    std::unordered_map<uint64_t, uint32_t> slots;
+    std::vector<uint32_t> slotCounts;
+
+    for( const sentence & current : _dataset )
+    {
+        decodeCharacters( current.begin(), current.end(), characters );
+        collectGrams( characters, grams );
+
+        for( uint64_t gram : grams )
+        {
+            const auto inserted = slots.emplace( gram, static_cast<uint32_t>( slotCounts.size() ) );
+            if( inserted.second )
+                slotCounts.push_back( 0 );
+
+            ++slotCounts[inserted.first->second];
+        }
+    }
+
+    // then the positions of the sentences of each gram, one after the other
+    std::vector<uint64_t> slotBegin( slotCounts.size() + 1, 0 );
+    for( size_t slot = 0; slot < slotCounts.size(); ++slot )
+        slotBegin[slot + 1] = slotBegin[slot] + slotCounts[slot];
+
+    std::vector<uint32_t> positions( slotBegin.back() );
+    std::vector<uint64_t> slotEnd( slotBegin.begin(), slotBegin.end() - 1 );
+
+    uint32_t position = 0;
+    for( dataset::const_iterator current = _dataset.begin(); current != _dataset.end(); ++current, ++position )
+    {
+        decodeCharacters( current->begin(), current->end(), characters );
+        collectGrams( characters, grams );
+
+        for( uint64_t gram : grams )
+            positions[ slotEnd[ slots[gram] ]++ ] = position;
+    }
+
+    // and lastly the grams in order, with their positions compressed
+    std::vector< std::pair<uint64_t, uint32_t> > sortedSlots( slots.begin(), slots.end() );
+    std::sort( sortedSlots.begin(), sortedSlots.end() );
+
+    m_nbSentences = _dataset.size();
+    m_grams.clear();
+    m_offsets.assign( 1, 0 );
+    m_counts.clear();
+    m_postings.clear();
+
+    for( const std::pair<uint64_t, uint32_t> & slot : sortedSlots )
+    {
+        uint32_t previous = 0;
+        for( uint64_t i = slotBegin[slot.second]; i < slotBegin[slot.second + 1]; ++i )
+        {
+            for( uint32_t delta = positions[i] - previous; ; delta >>= 7 )
+            {
+                if( delta < 0x80 )
+                {
+                    m_postings.push_back( static_cast<uint8_t>( delta ) );
+                    break;
+                }
+
+                m_postings.push_back( static_cast<uint8_t>( 0x80 | ( delta & 0x7f ) ) );
+            }
+
+            previous = positions[i];
+        }
+
+        m_grams.push_back( slot.first );
+        m_counts.push_back( slotCounts[slot.second] );
+        m_offsets.push_back( m_postings.size() );
+    }
+
+    qlog::info << "The trigram index holds " << m_grams.size() << " grams in " << m_postings.size() / 1024 << " kB\n";
+}
+
+// -------------------------------------------------------------------------- //
+
+template<typename VECTOR>
+static
+void writeVector( std::ostream & _out, const VECTOR & _vector )
+{
+    const uint64_t size = _vector.size();
+    _out.write( reinterpret_cast<const char *>( &size ), sizeof( size ) );
+    _out.write( reinterpret_cast<const char *>( _vector.data() ), static_cast<std::streamsize>( size * sizeof( _vector[0] ) ) );
+}
+
+template<typename VECTOR>
+static
+bool readVector( std::istream & _in, VECTOR & vector_ )
+{
+    uint64_t size = 0;
+    if( !_in.read( reinterpret_cast<char *>( &size ), sizeof( size ) ) )
+        return false;
+
+    vector_.resize( size );
+    return static_cast<bool>( _in.read( reinterpret_cast<char *>( vector_.data() ), static_cast<std::streamsize>( size * sizeof( vector_[0] ) ) ) );
+}
+
+// -------------------------------------------------------------------------- //
+
+bool trigramIndex::save( const std::string & _path, uint64_t _fingerprint ) const
+{
+    // written aside first, so that the file is never read half written
+    const std::string temporaryPath = _path + ".tmp";
+
+    {
+        std::ofstream out( temporaryPath.c_str(), std::ios::binary | std::ios::trunc );
+
+        out.write( INDEX_MAGIC, sizeof( INDEX_MAGIC ) );
+        out.write( reinterpret_cast<const char *>( &INDEX_VERSION ), sizeof( INDEX_VERSION ) );
+        out.write( reinterpret_cast<const char *>( &_fingerprint ), sizeof( _fingerprint ) );
+        out.write( reinterpret_cast<const char *>( &m_nbSentences ), sizeof( m_nbSentences ) );
+
+        writeVector( out, m_grams );
+        writeVector( out, m_offsets );
+        writeVector( out, m_counts );
+        writeVector( out, m_postings );
+
+        if( !out.flush() )
+        {
+            std::remove( temporaryPath.c_str() );
+            return false;
+        }
+    }
+
+    return std::rename( temporaryPath.c_str(), _path.c_str() ) == 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+bool trigramIndex::load( const std::string & _path, uint64_t _fingerprint )
+{
+    std::ifstream in( _path.c_str(), std::ios::binary );
+
+    char magic[sizeof( INDEX_MAGIC )];
+    uint64_t version = 0, fingerprint = 0;
+
+    if( !in.read( magic, sizeof( magic ) ) ||
+        !in.read( reinterpret_cast<char *>( &version ), sizeof( version ) ) ||
+        !in.read( reinterpret_cast<char *>( &fingerprint ), sizeof( fingerprint ) ) ||
+        !in.read( reinterpret_cast<char *>( &m_nbSentences ), sizeof( m_nbSentences ) ) )
+    {
+        return false;
+    }
+
+    // an index of other sentences, or of an older version, is built again
+    if( std::memcmp( magic, INDEX_MAGIC, sizeof( magic ) ) != 0 || version != INDEX_VERSION || fingerprint != _fingerprint )
+        return false;
+
+    return readVector( in, m_grams ) && readVector( in, m_offsets ) && readVector( in, m_counts ) && readVector( in, m_postings ) &&
+           m_offsets.size() == m_grams.size() + 1 && m_counts.size() == m_grams.size() && m_offsets.back() == m_postings.size();
+}
+
+// -------------------------------------------------------------------------- //
+
+void trigramIndex::decode( size_t _gramIndex, std::vector<uint32_t> & positions_ ) const
+{
+    positions_.clear();
+    positions_.reserve( m_counts[_gramIndex] );
+
+    uint32_t position = 0;
+    const uint8_t * byte = m_postings.data() + m_offsets[_gramIndex];
+    const uint8_t * const end = m_postings.data() + m_offsets[_gramIndex + 1];
+
+    while( byte != end )
+    {
+        uint32_t delta = 0;
+        for( unsigned shift = 0; ; shift += 7 )
+        {
+            const uint8_t current = *byte++;
+            delta |= static_cast<uint32_t>( current & 0x7f ) << shift;
+
+            if( ( current & 0x80 ) == 0 )
+                break;
+        }
+
+        position += delta;
+        positions_.push_back( position );
+    }
+}
+
+// -------------------------------------------------------------------------- //
+
+/**@struct trigramIndex::candidates
+ * @brief The positions of the sentences which can match a query, in order */
+struct trigramIndex::candidates
+{
+    candidates(): m_all( true ), m_positions() { }
+
+    // true when any sentence can match
+    bool                    m_all;
+    std::vector<uint32_t>   m_positions;
+};
+
+// -------------------------------------------------------------------------- //
+
+trigramIndex::candidates trigramIndex::evaluate( const gramQuery & _query ) const
+{
+    candidates found;
+
+    switch( _query.m_kind )
+    {
+    case gramQuery::ALL:
+        break;
+
+    case gramQuery::GRAM:
+    {
+        found.m_all = false;
+
+        const std::vector<uint64_t>::const_iterator gram = std::lower_bound( m_grams.begin(), m_grams.end(), _query.m_gram );
+        if( gram != m_grams.end() && *gram == _query.m_gram )
+            decode( static_cast<size_t>( gram - m_grams.begin() ), found.m_positions );
+        break;
+    }
+
+    case gramQuery::AND:
+    {
+        // the grams which fewer sentences hold are intersected first
+        std::vector<const gramQuery *> operands;
+        for( const gramQuery & child : _query.m_children )
+            operands.push_back( &child );
+
+        auto countSentences = [this]( const gramQuery * _operand ) -> uint64_t
+        {
+            if( _operand->m_kind != gramQuery::GRAM )
+                return m_nbSentences;
+
+            const std::vector<uint64_t>::const_iterator gram = std::lower_bound( m_grams.begin(), m_grams.end(), _operand->m_gram );
+            return gram != m_grams.end() && *gram == _operand->m_gram ? m_counts[ gram - m_grams.begin() ] : 0;
+        };
+
+        std::stable_sort( operands.begin(), operands.end(), [&]( const gramQuery * _a, const gramQuery * _b )
+        {
+            return countSentences( _a ) < countSentences( _b );
+        } );
+
+        std::vector<uint32_t> intersection;
+        for( const gramQuery * operand : operands )
+        {
+            const candidates operandFound = evaluate( *operand );
+            if( operandFound.m_all )
+                continue;
+
+            if( found.m_all )
+                found = operandFound;
+            else
+            {
+                intersection.clear();
+                std::set_intersection( found.m_positions.begin(), found.m_positions.end(),
+                                       operandFound.m_positions.begin(), operandFound.m_positions.end(),
+                                       std::back_inserter( intersection ) );
+                found.m_positions.swap( intersection );
+            }
+
+            if( found.m_positions.empty() )
+                break;
+        }
+        break;
+    }
+
+    case gramQuery::OR:
+    {
+        found.m_all = false;
+
+        std::vector<uint32_t> merged;
+        for( const gramQuery & child : _query.m_children )
+        {
+            const candidates childFound = evaluate( child );
+            if( childFound.m_all )
+                return childFound;
+
+            merged.clear();
+            std::set_union( found.m_positions.begin(), found.m_positions.end(),
+                            childFound.m_positions.begin(), childFound.m_positions.end(),
+                            std::back_inserter( merged ) );
+            found.m_positions.swap( merged );
+        }
+        break;
+    }
+    }
+
+    return found;
+}
+
+// -------------------------------------------------------------------------- //
+
+sentenceBitmap trigramIndex::select( const gramQuery & _query ) const
+{
+    const candidates found = evaluate( _query );
+    sentenceBitmap selected( static_cast<size_t>( m_nbSentences ) );
+
+    if( found.m_all )
+    {
+        for( size_t position = 0; position < selected.size(); ++position )
+            selected.set( position );
+    }
+    else
+    {
+        for( uint32_t position : found.m_positions )
+            selected.set( position );
+    }
+
+    return selected;
+}
+
+NAMESPACE_END
@@ -0,0 +1,88 @@
+#ifndef TATOPARSER_TRIGRAM_INDEX_H
+#define TATOPARSER_TRIGRAM_INDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bitmap.h"
+
+NAMESPACE_START
+
+struct dataset;
+
+/**@struct gramQuery
+ * @brief The grams a sentence must hold to be able to match a regular
+ *        expression, combined with and and or */
+struct gramQuery
+{
+    enum kind { ALL, GRAM, AND, OR };
+
+    explicit gramQuery( kind _kind = ALL, uint64_t _gram = 0 ): m_kind( _kind ), m_gram( _gram ), m_children() { }
+
+    kind                    m_kind;
+
+    // a gram, when m_kind is GRAM, see trigramIndex
+    uint64_t                m_gram;
+
+    // the operands of AND and OR
+    std::vector<gramQuery>  m_children;
+};
+
+// -------------------------------------------------------------------------- //
+
+/**@brief Finds the grams a sentence must hold to match a case-sensitive
+ *        regular expression: those of the strings written literally in it.
+ * @return A query of kind ALL if any sentence could match, or if the
+ *         expression uses a syntax which is not understood, like \Q...\E or
+ *         look-ahead assertions */
+gramQuery analyzeRegex( const std::string & _regex );
+
+// -------------------------------------------------------------------------- //
+
+/**@struct trigramIndex
+ * @brief For each sequence of 3 characters, or of 2 CJK characters, the
+ *        sentences which hold it, in the way of codesearch. A regular
+ *        expression is then only checked on the sentences which hold all the
+ *        grams of its literal strings.
+ *
+ * The grams are packed in a uint64_t: 21 bits per code point, and the highest
+ * bit set for a bigram. The sentences of a gram are stored as their positions
+ * in the dataset, in increasing order, as the differences between them
+ * written in variable-length bytes. */
+struct trigramIndex
+{
+    /**@brief Returns the index of some sentences. It is read from a file if
+     *        the file was written for the same sentences, and built and
+     *        written in the file if not. The index is then kept for the next
+     *        calls with the same sentences, like the queries of a server.
+     * @param[in] _path Where the index is stored */
+    static std::shared_ptr<const trigramIndex> get( const dataset & _dataset, const std::string & _path );
+
+    /**@brief Returns the sentences which hold the grams of a query */
+    sentenceBitmap select( const gramQuery & _query ) const;
+
+private:
+    trigramIndex(): m_nbSentences( 0 ), m_grams(), m_offsets(), m_counts(), m_postings() { }
+
+    void build( const dataset & _dataset );
+    bool load( const std::string & _path, uint64_t _fingerprint );
+    bool save( const std::string & _path, uint64_t _fingerprint ) const;
+
+    struct candidates;
+    candidates evaluate( const gramQuery & _query ) const;
+    void decode( size_t _gramIndex, std::vector<uint32_t> & positions_ ) const;
+
+private:
+    uint64_t                m_nbSentences;
+
+    // the grams, sorted, and where the sentences of each begin in m_postings
+    std::vector<uint64_t>   m_grams;
+    std::vector<uint64_t>   m_offsets;
+    std::vector<uint32_t>   m_counts;
+    std::vector<uint8_t>    m_postings;
+};
+
+NAMESPACE_END
+
+#endif // TATOPARSER_TRIGRAM_INDEX_H
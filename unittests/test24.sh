@@ -0,0 +1,13 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+temp_dir=$(mktemp -d)
+gzip -c sentences.csv > "$temp_dir/sentences.csv.gz"
+xz -c links.csv > "$temp_dir/links.csv.xz"
+
+result=`$tatoparser_bin --csv-path "$temp_dir" --is-linked-to 1 | wc -l`
+expected_result=2
+
+rm -rf "$temp_dir"
+
+displayResult $result $expected_result $test_number
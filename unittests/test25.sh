@@ -0,0 +1,12 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+temp_dir=$(mktemp -d)
+tar cjf "$temp_dir/sentences_detailed.tar.bz2" sentences_detailed.csv
+
+result=`$tatoparser_bin --csv-path "$temp_dir" --user qdii | wc -l`
+expected_result=1
+
+rm -rf "$temp_dir"
+
+displayResult $result $expected_result $test_number
@@ -0,0 +1,15 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# the files are only read: they can be parsed even when they are read-only,
+# and printing every sentence gives back sentences.csv unchanged
+temp_dir=$(mktemp -d)
+cp sentences.csv links.csv tags.csv lists.csv "$temp_dir"
+chmod a-w "$temp_dir"/*.csv
+
+result=`$tatoparser_bin --csv-path "$temp_dir" -i --display-lang | cmp -s - sentences.csv && echo same`
+expected_result=same
+
+rm -rf "$temp_dir"
+
+displayResult $result $expected_result $test_number
@@ -0,0 +1,8 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# reading the files before parsing them does not change the result
+result=`$tatoparser_bin --prefault --regex '.*我.*' | wc -l`
+expected_result=2
+
+displayResult $result $expected_result $test_number
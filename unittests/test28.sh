@@ -0,0 +1,8 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# reading the files instead of mapping them gives the same sentences
+result=`$tatoparser_bin --no-mmap -i --display-lang | cmp -s - sentences.csv && $tatoparser_bin --no-mmap --has-tag hsk | wc -l`
+expected_result=1
+
+displayResult $result $expected_result $test_number
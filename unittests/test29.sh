@@ -0,0 +1,8 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# counting the lines exactly instead of estimating them gives the same result
+result=`$tatoparser_bin --exact-count -i --display-lang | cmp -s - sentences.csv && $tatoparser_bin --exact-count --is-linked-to 1 | wc -l`
+expected_result=2
+
+displayResult $result $expected_result $test_number
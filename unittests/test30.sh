@@ -0,0 +1,10 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# parsing links, tags and lists on first use finds the same sentences
+result=`$tatoparser_bin --lazy --in-list bla | wc -l`
+result=$result`$tatoparser_bin --lazy --has-tag HSK | wc -l`
+result=$result`$tatoparser_bin --lazy --is-linked-to 1 | wc -l`
+expected_result=`$tatoparser_bin --in-list bla | wc -l``$tatoparser_bin --has-tag HSK | wc -l``$tatoparser_bin --is-linked-to 1 | wc -l`
+
+displayResult $result $expected_result $test_number
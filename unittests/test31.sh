@@ -0,0 +1,33 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# applying the diffs between two exports gives the same sentences, links, tags
+# and lists as parsing the new export
+old_dir=$(mktemp -d)
+new_dir=$(mktemp -d)
+cp sentences.csv links.csv tags.csv lists.csv "$old_dir"
+
+sed -e '/^2	/d' -e 's/^3	cmn	.*/3	cmn	你在干什麼？/' sentences.csv > "$new_dir/sentences.csv"
+echo "11	fra	Une nouvelle phrase." >> "$new_dir/sentences.csv"
+sed -e '/^2	5$/d' links.csv > "$new_dir/links.csv"
+echo "11	1" >> "$new_dir/links.csv"
+echo "11	new" > "$new_dir/tags.csv"
+sed -e '/^2	bla$/d' lists.csv > "$new_dir/lists.csv"
+
+for file in sentences links tags lists; do
+    diff -u "$old_dir/$file.csv" "$new_dir/$file.csv" > "$old_dir/$file.csv.diff"
+done
+
+query() {
+    $tatoparser_bin -i --display-lang "$@" | sort
+    $tatoparser_bin -i --is-linked-to 1 "$@" | sort
+    $tatoparser_bin -i --has-tag new "$@"
+    $tatoparser_bin -i --in-list bla "$@"
+}
+
+result=`query --csv-path "$old_dir" --apply-diff "$old_dir" | md5sum | cut -c1-32`
+expected_result=`query --csv-path "$new_dir" | md5sum | cut -c1-32`
+
+rm -rf "$old_dir" "$new_dir"
+
+displayResult $result $expected_result $test_number
@@ -0,0 +1,25 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# a server answers the queries like tatoparser itself
+socket=`mktemp -u`
+$tatoparser_bin --serve $socket &
+server=$!
+
+waited=0
+while [ ! -S $socket ] && [ $waited -lt 100 ]; do sleep 0.1; waited=$((waited+1)); done
+
+result=`$tatoparser_bin --connect $socket -i --has-tag HSK | md5sum | cut -c1-32`
+result=$result`$tatoparser_bin --connect $socket --is-linked-to 1 --display-lang | md5sum | cut -c1-32`
+result=$result`$tatoparser_bin --connect=$socket -l fra -r ".*a.*" | md5sum | cut -c1-32`
+# the server answers from the files it parsed, not from those of the query
+$tatoparser_bin --connect $socket --csv-path /tmp -r ".*a.*" > /dev/null 2>&1 && result=$result"csv-path accepted"
+expected_result=`$tatoparser_bin -i --has-tag HSK | md5sum | cut -c1-32``$tatoparser_bin --is-linked-to 1 --display-lang | md5sum | cut -c1-32``$tatoparser_bin -l fra -r ".*a.*" | md5sum | cut -c1-32`
+
+kill $server
+wait $server
+rm -f $socket
+
+result=`echo $result | md5sum | cut -c1-32`
+expected_result=`echo $expected_result | md5sum | cut -c1-32`
+displayResult $result $expected_result $test_number
@@ -0,0 +1,11 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# the progress is drawn on the error output, and leaves the sentences untouched
+progress=`$tatoparser_bin -i --display-lang --progress 2>&1 >/dev/null | grep -c "sentences.csv.*100%"`
+sentences=`$tatoparser_bin -i --display-lang --progress 2>/dev/null | md5sum | cut -c1-32`
+
+result="$progress$sentences"
+expected_result="1"`$tatoparser_bin -i --display-lang | md5sum | cut -c1-32`
+
+displayResult $result $expected_result $test_number
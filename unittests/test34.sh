@@ -0,0 +1,15 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# --stats reports what each filter was given and kept on the error output,
+# and leaves the sentences untouched. Every filter is given the first
+# sentences, to know how many of them it keeps.
+selected=`$tatoparser_bin -l fra -r '.*pain.*' --stats=json 2>&1 >/dev/null | grep -c \
+    -e '"filter language", "calls": 10, .* "items": 2, "selectivity": 0.200000' \
+    -e '"filter regex", "calls": 10, .* "items": 2, "selectivity": 0.200000'`
+sentences=`$tatoparser_bin -l fra -r '.*pain.*' --stats 2>/dev/null | md5sum | cut -c1-32`
+
+result="$selected$sentences"
+expected_result="2"`$tatoparser_bin -l fra -r '.*pain.*' | md5sum | cut -c1-32`
+
+displayResult $result $expected_result $test_number
@@ -0,0 +1,12 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# the filters are ordered from the sentences they keep: --has-tag rejects
+# more sentences than --regex '.*', so it is run first
+order=`$tatoparser_bin -r '.*' --has-tag hsk --verbose 2>&1 | grep 'sampled sentences' | grep -o -e 'has-tag' -e 'regex' | tr -d '\n'`
+ids=`$tatoparser_bin -r '.*' --has-tag hsk -i | cut -f1`
+
+result="$order$ids"
+expected_result="has-tagregex3"
+
+displayResult $result $expected_result $test_number
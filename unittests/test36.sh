@@ -0,0 +1,12 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# --language and --regex are run as a single filter, which selects the same
+# sentences as the two filters apart, as they are run with --stats
+fused=`$tatoparser_bin -l fra -r '.*pain.*' --verbose 2>&1 | grep -c 'fused filters.*language+regex'`
+sentences=`$tatoparser_bin -l fra -r '.*pain.*' -i | md5sum | cut -c1-32`
+
+result="$fused$sentences"
+expected_result="1"`$tatoparser_bin -l fra -r '.*pain.*' -i --stats 2>/dev/null | md5sum | cut -c1-32`
+
+displayResult $result $expected_result $test_number
@@ -0,0 +1,13 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# --query combines the filters with and, or and not, and an expression which
+# cannot be parsed is refused
+selected=`$tatoparser_bin --query 'has-tag:hsk or (language:fra and not has-id:6)' -i | cut -f1 | tr '\n' ' '`
+$tatoparser_bin --query 'has-tag:hsk or' -i > /dev/null 2>&1
+refused=$?
+
+result="$selected$refused"
+expected_result="3 10 1"
+
+displayResult "$result" "$expected_result" $test_number
@@ -0,0 +1,16 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# --regex-index builds a trigram index of the sentences, then reads it, and
+# selects the same sentences as --regex alone
+rm -f sentences.trigrams
+built=`$tatoparser_bin -r '.*(pain|hello).*' --regex-index -i | md5sum | cut -c1-32`
+read=`$tatoparser_bin -r '.*(pain|hello).*' --regex-index -i | md5sum | cut -c1-32`
+test -f sentences.trigrams && written=1
+rm -f sentences.trigrams
+
+result="$built$read$written"
+expected=`$tatoparser_bin -r '.*(pain|hello).*' -i | md5sum | cut -c1-32`
+expected_result="$expected${expected}1"
+
+displayResult $result $expected_result $test_number
@@ -0,0 +1,15 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# --only-chars keeps the sentences written with some characters, punctuation
+# aside, and --max-unknown-chars those with a few others
+only=`$tatoparser_bin --only-chars '我們試試看' -i | cut -f1 | tr '\n' ' '`
+
+printf '我們試試看\n你在干什麼啊\n' > known_chars.tmp
+known=`$tatoparser_bin -l cmn --known-chars-file known_chars.tmp --max-unknown-chars 1 -i | cut -f1 | tr '\n' ' '`
+rm -f known_chars.tmp
+
+result="$only$known"
+expected_result="1 1 3 "
+
+displayResult "$result" "$expected_result" $test_number
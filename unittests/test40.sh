@@ -0,0 +1,17 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# --substring-index finds the sentences holding the string of '.*XYZ.*' in a
+# suffix array, which it builds and then reads, and leaves the other
+# expressions to the regular expression alone
+rm -f sentences.suffixes
+built=`$tatoparser_bin -r '.*pain.*' --substring-index -i | cut -f1 | tr '\n' ' '`
+read=`$tatoparser_bin -r '^.*pain.*$' --substring-index -i | cut -f1 | tr '\n' ' '`
+other=`$tatoparser_bin -r '.*(pain|Hey).*' --substring-index -i | cut -f1 | tr '\n' ' '`
+test -f sentences.suffixes && written=1
+rm -f sentences.suffixes
+
+result="$built$read$other$written"
+expected_result="7 10 7 10 7 9 10 1"
+
+displayResult "$result" "$expected_result" $test_number
@@ -0,0 +1,16 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# --folded-text matches --regex-nocs and --fuzzy against the sentences
+# normalized with NFKC and case-folded, and the expressions which cannot be
+# folded as they would be matched otherwise
+string=`$tatoparser_bin --regex-nocs '.*PAIN À LA.*' --folded-text -i | cut -f1 | tr '\n' ' '`
+regex=`$tatoparser_bin --regex-nocs '[A-Z]L N.Y A+ PLUS.*' --folded-text -i | cut -f1 | tr '\n' ' '`
+width=`$tatoparser_bin --regex-nocs 'ＢＯＮＪＯＵＲ' --folded-text -i | cut -f1 | tr '\n' ' '`
+class=`$tatoparser_bin --regex-nocs 'b\p{Ll}+R' --folded-text -i | cut -f1 | tr '\n' ' '`
+fuzzy=`$tatoparser_bin --fuzzy 1 BONJOUR --folded-text -i | cut -f1 | tr '\n' ' '`
+
+result="$string$regex$width$class$fuzzy"
+expected_result="10 10 6 6 6 "
+
+displayResult "$result" "$expected_result" $test_number
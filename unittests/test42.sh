@@ -0,0 +1,19 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# the tags are numbered on 32 bits, so that the 65536th tag is not mistaken for
+# another one, and their names are lowered as they are parsed
+tag_dir=$(mktemp -d)
+cp sentences.csv links.csv lists.csv "$tag_dir"
+awk 'BEGIN { for( i = 0; i < 70000; ++i ) printf "%d\tTag%d\n", i % 10 + 1, i }' > "$tag_dir/tags.csv"
+
+first=`$tatoparser_bin --csv-path "$tag_dir" --has-tag tag0 -i | cut -f1 | tr '\n' ' '`
+last=`$tatoparser_bin --csv-path "$tag_dir" --has-tag TAG65536 -i | cut -f1 | tr '\n' ' '`
+missing=`$tatoparser_bin --csv-path "$tag_dir" --has-tag tag70000 -i | wc -l`
+
+rm -rf "$tag_dir"
+
+result="$first$last$missing"
+expected_result="1 7 0"
+
+displayResult "$result" "$expected_result" $test_number
@@ -0,0 +1,18 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# the lists are told apart by their whole name, lowered as it is parsed, and
+# the lines without a list name are skipped
+list_dir=$(mktemp -d)
+cp sentences.csv links.csv tags.csv "$list_dir"
+printf '1\tbla\n2\tbla\n3\tBLA\n4\n5\tbla2\n6\tBla2\n' > "$list_dir/lists.csv"
+
+bla=`$tatoparser_bin --csv-path "$list_dir" --in-list bla -i | cut -f1 | tr '\n' ' '`
+bla2=`$tatoparser_bin --csv-path "$list_dir" --in-list BLA2 -i | cut -f1 | tr '\n' ' '`
+
+rm -rf "$list_dir"
+
+result="$bla$bla2"
+expected_result="1 2 3 5 6 "
+
+displayResult "$result" "$expected_result" $test_number
@@ -0,0 +1,18 @@
+#!/bin/sh
+. ./unittests_common.sh
+
+# the authors are told apart by their whole name, with its case, and the
+# sentences written by \N are the orphans
+user_dir=$(mktemp -d)
+printf '1\teng\tOne.\tqdii\t\\N\t\\N\n2\teng\tTwo.\tQdii\t\\N\t\\N\n3\teng\tThree.\tqdii\t\\N\t\\N\n4\teng\tFour.\t\\N\t\\N\t\\N\n5\teng\tFive.\tqdi\t\\N\t\\N\n' > "$user_dir/sentences_detailed.csv"
+
+user=`$tatoparser_bin --csv-path "$user_dir" --user qdii -i | cut -f1 | tr '\n' ' '`
+orphans=`$tatoparser_bin --csv-path "$user_dir" --orphan -i | cut -f1 | tr '\n' ' '`
+query=`$tatoparser_bin --csv-path "$user_dir" --query 'user:Qdii or user:qdi' -i | cut -f1 | tr '\n' ' '`
+
+rm -rf "$user_dir"
+
+result="$user$orphans$query"
+expected_result="1 3 4 2 5 "
+
+displayResult "$result" "$expected_result" $test_number